@@ -21,18 +21,20 @@ namespace OneJS.Editor {
         IScriptEngine _scriptEngine;
         Dictionary<string, StyleSheet> _runtimeStyleSheets = new Dictionary<string, StyleSheet>();
         
-        Dictionary<string, Texture2D> _imageCache = new();
-        Dictionary<string, Font> _fontCache = new();
-        Dictionary<string, FontDefinition> _fontDefinitionCache = new();
-        WebApi _webApi = new WebApi(); // TODO May need a dedicated WebApi that uses Editor Coroutines
+        TextureCache _textureCache = new TextureCache();
+        WebApi _webApi; // TODO May need a dedicated WebApi that uses Editor Coroutines
+        SvgLoader _svgLoader;
+        readonly Dictionary<string, DateTime> _svgWriteTimes = new Dictionary<string, DateTime>();
 
         public EditorDocument(IScriptEngine scriptEngine) {
             _scriptEngine = scriptEngine;
+            _webApi = new WebApi(_textureCache);
             _tagTypes = GetAllVisualElementTypes();
         }
 
         public void Dispose() {
             clearRuntimeStyleSheets();
+            _svgLoader?.Purge();
         }
 
         public Dom.Dom createElement(string tagName) {
@@ -140,25 +142,43 @@ namespace OneJS.Editor {
             UnityEngine.Object.Destroy(sheet);
         }
         
+        /// <summary>
+        /// Evaluated once against the screen: editor documents have no single root to watch.
+        /// </summary>
+        public MediaQueryList matchMedia(string query) {
+            var parsed = MediaQuery.Parse(query);
+            var features = new MediaFeatures {
+                width = Screen.width, height = Screen.height, dppx = 1, deviceWidth = Screen.width,
+                deviceHeight = Screen.height
+            };
+            return new MediaQueryList(parsed, parsed.Evaluate(features));
+        }
+
+        public TextureCache textureCache => _textureCache;
+
+        public ImageAtlas imageAtlas => null;
+
+        public SvgLoader svgLoader => _svgLoader ??= new SvgLoader(null);
+
         public void clearCache() {
-            _imageCache.Clear();
-            _fontCache.Clear();
-            _fontDefinitionCache.Clear();
+            _textureCache.Clear();
+            // Fonts are shared by every engine (see FontManager), so only this one's are dropped
+            FontManager.Shared.Purge(_scriptEngine);
+            _svgLoader?.Purge();
+            _svgWriteTimes.Clear();
         }
         
+        /// <summary>
+        /// Img elements load right away in editor documents.
+        /// </summary>
+        public ImageLoadScheduler imageLoadScheduler => null;
+
         public Coroutine loadRemoteImage(string url, Action<Texture2D> callback) {
-            if (_imageCache.TryGetValue(url, out var tex)) {
-                callback(tex);
-                return null;
-            }
-            return _webApi.getImage(url, (texture) => {
-                if (texture == null) {
-                    Debug.LogError($"Failed to load image: {url}");
-                    return;
-                }
-                _imageCache[url] = texture;
-                callback(texture);
-            });
+            return _webApi.getImage(url, callback);
+        }
+
+        public void cancelRemoteImage(string url, Action<Texture2D> callback) {
+            _webApi.cancelImage(url, callback);
         }
 
         /// <summary>
@@ -166,17 +186,16 @@ namespace OneJS.Editor {
         /// </summary>
         /// <param name="path">Relative to the WorkingDir</param>
         public Texture2D loadImage(string path, FilterMode filterMode = FilterMode.Bilinear) {
-            if (_imageCache.TryGetValue(path, out var texture)) {
+            if (_textureCache.TryGet(path, out var texture)) {
                 return texture;
             }
             try {
-                path = Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path);
-                var rawData = File.ReadAllBytes(path);
+                var fullPath = Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path);
+                var rawData = File.ReadAllBytes(fullPath);
                 Texture2D tex = new Texture2D(2, 2); // Create an empty Texture; size doesn't matter
                 tex.LoadImage(rawData);
                 tex.filterMode = filterMode;
-                _imageCache[path] = tex;
-                return tex;
+                return _textureCache.Add(path, tex);
             } catch (Exception) {
                 Debug.LogError($"Failed to load image: {path}");
                 // Debug.LogError(e);
@@ -185,37 +204,101 @@ namespace OneJS.Editor {
         }
 
         /// <summary>
-        /// Loads a font from the specified path and returns a Font object.
+        /// Same as loadImage; editor documents load images synchronously.
         /// </summary>
         /// <param name="path">Relative to the WorkingDir</param>
-        public Font loadFont(string path) {
-            if (_fontCache.TryGetValue(path, out var f)) {
-                return f;
+        public void loadImageAsync(string path, Action<Texture2D> callback, FilterMode filterMode = FilterMode.Bilinear) {
+            callback(loadImage(path, filterMode));
+        }
+
+        /// <summary>
+        /// Editor documents don't use the image atlas; this is always a texture.
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public Background loadBackground(string path, FilterMode filterMode = FilterMode.Bilinear) {
+            return Background.FromTexture2D(loadImage(path, filterMode));
+        }
+
+        public void loadBackgroundAsync(string path, Action<Background> callback, FilterMode filterMode = FilterMode.Bilinear) {
+            callback(loadBackground(path, filterMode));
+        }
+
+        public bool tryGetCachedBackground(string path, out Background background) {
+            if (_textureCache.TryGet(path, out var texture)) {
+                background = Background.FromTexture2D(texture);
+                return true;
             }
+            background = default;
+            return false;
+        }
+
+        public void retainImage(Texture2D texture) {
+            _textureCache.HandOut(texture);
+        }
+
+        public void retainBackground(Background background) {
+            _textureCache.HandOut(background.texture);
+        }
+
+        public void releaseImage(Texture2D texture) {
+            _textureCache.ReleaseHandOut(texture);
+        }
+
+        public void releaseBackground(Background background) {
+            _textureCache.ReleaseHandOut(background.texture);
+        }
+
+        /// <summary>
+        /// Parses and tessellates right away; editor documents load images synchronously. Files edited since they
+        /// were last loaded are parsed again.
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public void loadVectorImageAsync(string path, int size, Action<VectorImage> callback, Color? currentColor = null) {
+            var fullPath = Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path);
+            byte[] bytes;
+            DateTime writeTime;
             try {
-                path = Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path);
-                var font = new Font(path);
-                _fontCache[path] = font;
-                return font;
+                bytes = File.ReadAllBytes(fullPath);
+                writeTime = File.GetLastWriteTimeUtc(fullPath);
             } catch (Exception) {
-                Debug.LogError($"Failed to load font: {path}");
-                // Debug.LogError(e);
-                return null;
+                Debug.LogError($"Failed to load SVG: {path}");
+                callback(null);
+                return;
             }
+            // Editor documents live as long as their engine, which doesn't reload for asset edits
+            if (_svgWriteTimes.TryGetValue(fullPath, out var loadedTime) && loadedTime != writeTime)
+                svgLoader.Remove(fullPath);
+            _svgWriteTimes[fullPath] = writeTime;
+            callback(svgLoader.LoadNow(fullPath, SvgLoader.SizeBucket(size), bytes, currentColor));
         }
 
         /// <summary>
-        /// Loads a font from the specified path and returns a FontDefinition object.
+        /// Loads a font from the specified path and returns a Font object. Cached process-wide (see FontManager).
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public Font loadFont(string path) {
+            return FontManager.Shared.GetFont(GetFontPath(path), _scriptEngine);
+        }
+
+        /// <summary>
+        /// Loads a font from the specified path and returns a FontDefinition object. Cached process-wide (see
+        /// FontManager).
         /// </summary>
         /// <param name="path">Relative to the WorkingDir</param>
         public FontDefinition loadFontDefinition(string path) {
-            if (_fontDefinitionCache.TryGetValue(path, out var fd)) {
-                return fd;
-            }
-            path = Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path);
-            var font = new Font(path);
-            _fontCache[path] = font;
-            return FontDefinition.FromFont(font);
+            return FontManager.Shared.GetFontDefinition(GetFontPath(path), _scriptEngine);
+        }
+
+        public void loadFontDefinitionAsync(string path, Action<FontDefinition> callback, string prewarmCharacters = null) {
+            FontManager.Shared.LoadAsync(GetFontPath(path), callback, prewarmCharacters, _scriptEngine);
+        }
+
+        public void prewarmFont(string path, string characters) {
+            FontManager.Shared.Prewarm(GetFontPath(path), characters, _scriptEngine);
+        }
+
+        string GetFontPath(string path) {
+            return Path.GetFullPath(Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path));
         }
 
         Type[] GetAllVisualElementTypes() {
@@ -3,6 +3,7 @@ using System.Collections.Generic;
 using System.IO;
 using System.Linq;
 using Newtonsoft.Json;
+using OneJS.Utils;
 using Puerts;
 using UnityEditor;
 using UnityEngine;
@@ -47,7 +48,7 @@ namespace OneJS.Editor {
         RendererRegistry _rendererRegistry;
         EditorDocument _document;
         EditorEngineHost _engineHost;
-        FileSystemWatcher _fileWatcher;
+        FileWatcher _fileWatcher;
         #endregion
 
         #region Lifecycle
@@ -119,6 +120,7 @@ namespace OneJS.Editor {
                 _document.Dispose();
                 _document = null;
             }
+            TextureKernels.CancelAll();
             if (_jsEnv != null) {
                 _jsEnv.Dispose();
                 _jsEnv = null;
@@ -128,6 +130,7 @@ namespace OneJS.Editor {
 
         void Tick() {
             _jsEnv.Tick();
+            _fileWatcher?.Poll();
         }
         #endregion
 
@@ -135,6 +138,8 @@ namespace OneJS.Editor {
         public void Reload() {
             OnReload?.Invoke();
             Dispose();
+            // Edited fonts get picked up
+            FontManager.Shared.Purge(this);
             Init();
         }
 
@@ -223,15 +228,9 @@ namespace OneJS.Editor {
 
         #region Runner
         void StartWatching() {
-            _fileWatcher = new FileSystemWatcher();
-            _fileWatcher.Path = Path.GetDirectoryName(ScriptFilePath);
-            _fileWatcher.Filter = Path.GetFileName(ScriptFilePath); // Only watch the specific file.
-
-            _fileWatcher.Changed += OnFileChanged;
-            // _fileWatcher.Deleted += OnFileDeleted;
-            // _fileWatcher.Renamed += OnFileRenamed;
-
-            _fileWatcher.EnableRaisingEvents = true;
+            _fileWatcher = new FileWatcher();
+            _fileWatcher.WatchFile(ScriptFilePath); // Only watch the specific file.
+            _fileWatcher.OnChanged += OnFileChanged;
 
             if (extraLogging)
                 Debug.Log($"[OneJS Editor] Loaded: {folderName} ({ScriptFilePath})");
@@ -239,22 +238,19 @@ namespace OneJS.Editor {
 
         void StopWatching() {
             if (_fileWatcher != null) {
-                _fileWatcher.EnableRaisingEvents = false;
                 _fileWatcher.Dispose();
                 _fileWatcher = null;
                 // Debug.Log("Stopped watching: " + ScriptFilePath);
             }
         }
 
-        void OnFileChanged(object source, FileSystemEventArgs e) {
-            // Debug.Log("File: " + e.FullPath + " " + e.ChangeType);
-            EditorApplication.update += RunOnMainThread;
-        }
-
-        void RunOnMainThread() {
-            EditorApplication.update -= RunOnMainThread;
+        /// <summary>
+        /// Raised from Tick() on the main thread, only when the file's content actually changed.
+        /// </summary>
+        void OnFileChanged(IReadOnlyList<string> paths) {
             if (devMode) {
-                Reload();
+                // Reload() disposes the current watcher, so don't do it while it's still dispatching
+                EditorApplication.delayCall += Reload;
             }
         }
 
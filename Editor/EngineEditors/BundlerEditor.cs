@@ -1,6 +1,11 @@
-﻿using UnityEditor;
+﻿using System;
+using System.Diagnostics;
+using System.IO;
+using OneJS.Utils;
+using UnityEditor;
 using UnityEngine;
 using UnityEngine.UIElements;
+using Debug = UnityEngine.Debug;
 
 namespace OneJS.Editor {
     [CustomEditor(typeof(Bundler))]
@@ -9,9 +14,12 @@ namespace OneJS.Editor {
         SerializedProperty _defaultFiles;
         SerializedProperty _includes;
         SerializedProperty _bundleZip;
+        SerializedProperty _codec;
+        SerializedProperty _minifyJS;
 
         SerializedProperty _version;
         SerializedProperty _forceExtract;
+        SerializedProperty _serveFromArchive;
         SerializedProperty _ignoreList;
 
         // bool showAssets;
@@ -20,9 +28,12 @@ namespace OneJS.Editor {
             _defaultFiles = serializedObject.FindProperty("defaultFiles");
             _includes = serializedObject.FindProperty("includes");
             _bundleZip = serializedObject.FindProperty("bundleZip");
+            _codec = serializedObject.FindProperty("codec");
+            _minifyJS = serializedObject.FindProperty("minifyJS");
 
             _version = serializedObject.FindProperty("version");
             _forceExtract = serializedObject.FindProperty("forceExtract");
+            _serveFromArchive = serializedObject.FindProperty("serveFromArchive");
             _ignoreList = serializedObject.FindProperty("ignoreList");
         }
 
@@ -34,8 +45,11 @@ namespace OneJS.Editor {
             EditorGUILayout.PropertyField(_defaultFiles, new GUIContent("Default Files"));
             EditorGUILayout.PropertyField(_version, new GUIContent("Version"));
             EditorGUILayout.PropertyField(_forceExtract, new GUIContent("Force Extract"));
+            EditorGUILayout.PropertyField(_serveFromArchive, new GUIContent("Serve From Archive"));
             EditorGUILayout.PropertyField(_includes, new GUIContent("Includes"));
             EditorGUILayout.PropertyField(_bundleZip, new GUIContent("bundle.tgz"));
+            EditorGUILayout.PropertyField(_codec, new GUIContent("Codec"));
+            EditorGUILayout.PropertyField(_minifyJS, new GUIContent("Minify JS"));
             EditorGUILayout.PropertyField(_ignoreList, new GUIContent("Ignore List"));
 
             // showAssets = EditorGUILayout.Foldout(showAssets, "Default Assets", true);
@@ -56,5 +70,59 @@ namespace OneJS.Editor {
 
             serializedObject.ApplyModifiedProperties();
         }
+
+        /// <summary>
+        /// Packages the current includes with every codec (in memory) and logs bundle size, full decompression
+        /// time, and the time to index the bundle and read one file on demand. Bundles stay in memory, and minified
+        /// JS goes to a throwaway cache so the real one (Library/OneJS/MinifyCache) isn't pruned.
+        /// </summary>
+        [MenuItem("CONTEXT/Bundler/Benchmark Bundle Codecs")]
+        static void BenchmarkCodecs(MenuCommand command) {
+            var bundler = (Bundler)command.context;
+            const int runs = 5;
+            var report = new System.Text.StringBuilder("Bundle codec benchmark (best of 5)\n");
+            var minifyCacheDir = Path.Combine(Path.GetTempPath(), "OneJS-MinifyBenchmark-" + Guid.NewGuid().ToString("N"));
+            try {
+                foreach (BundleCodec c in Enum.GetValues(typeof(BundleCodec)))
+                    report.AppendLine(BenchmarkCodec(bundler, c, runs, minifyCacheDir));
+            } finally {
+                try {
+                    if (Directory.Exists(minifyCacheDir))
+                        Directory.Delete(minifyCacheDir, true);
+                } catch (IOException) {
+                }
+            }
+            Debug.Log(report.ToString());
+        }
+
+        static string BenchmarkCodec(Bundler bundler, BundleCodec c, int runs, string minifyCacheDir) {
+            var ms = new MemoryStream();
+            bundler.WriteBundle(ms, c, minifyCacheDir);
+            var bytes = ms.ToArray();
+
+            double extractMs = double.MaxValue, indexMs = double.MaxValue;
+            long total = 0;
+            int count = 0;
+            for (int i = 0; i < runs; i++) {
+                var sw = Stopwatch.StartNew();
+                total = 0;
+                count = 0;
+                foreach (var kv in BundleFormat.ReadEntries(bytes)) {
+                    total += kv.Value.Length;
+                    count++;
+                }
+                extractMs = Math.Min(extractMs, sw.Elapsed.TotalMilliseconds);
+
+                sw.Restart();
+                var archive = BundleArchive.FromBytes(bytes);
+                foreach (var path in archive.Paths) {
+                    archive.ReadAllBytes(path);
+                    break;
+                }
+                indexMs = Math.Min(indexMs, sw.Elapsed.TotalMilliseconds);
+            }
+            return $"{c}: {bytes.Length} bytes ({count} files, {total} bytes raw), " +
+                   $"decompress all {extractMs:F1}ms, index + read one {indexMs:F1}ms";
+        }
     }
 }
\ No newline at end of file
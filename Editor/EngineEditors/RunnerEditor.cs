@@ -10,7 +10,7 @@ namespace OneJS.Editor {
         SerializedProperty _entryFile;
         SerializedProperty _runOnStart;
         SerializedProperty _liveReload;
-        SerializedProperty _pollingInterval;
+        SerializedProperty _debounceInterval;
         SerializedProperty _clearGameObjects;
         SerializedProperty _clearLogs;
         SerializedProperty _respawnJanitorOnSceneLoad;
@@ -22,7 +22,7 @@ namespace OneJS.Editor {
             _entryFile = serializedObject.FindProperty("entryFile");
             _runOnStart = serializedObject.FindProperty("runOnStart");
             _liveReload = serializedObject.FindProperty("liveReload");
-            _pollingInterval = serializedObject.FindProperty("pollingInterval");
+            _debounceInterval = serializedObject.FindProperty("debounceInterval");
             _clearGameObjects = serializedObject.FindProperty("clearGameObjects");
             _clearLogs = serializedObject.FindProperty("clearLogs");
             _respawnJanitorOnSceneLoad = serializedObject.FindProperty("respawnJanitorOnSceneLoad");
@@ -39,7 +39,7 @@ namespace OneJS.Editor {
             EditorGUILayout.PropertyField(_runOnStart, new GUIContent("Run On Start"));
             EditorGUILayout.PropertyField(_liveReload, new GUIContent("Live Reload"));
             if (_liveReload.boolValue) {
-                EditorGUILayout.PropertyField(_pollingInterval, new GUIContent("    Polling Interval (ms)"));
+                EditorGUILayout.PropertyField(_debounceInterval, new GUIContent("    Debounce Interval (ms)"));
                 EditorGUILayout.PropertyField(_clearGameObjects, new GUIContent("    Clear GameObjects on Reload"));
                 EditorGUILayout.PropertyField(_clearLogs, new GUIContent("    Clear Logs on Reload"));
                 EditorGUILayout.PropertyField(_respawnJanitorOnSceneLoad, new GUIContent("    Respawn Janitor on SceneLoad"));
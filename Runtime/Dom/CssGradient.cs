@@ -0,0 +1,404 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// A parsed CSS linear-gradient(), radial-gradient() or their repeating- variants. Immutable once parsed, so
+    /// instances can be compared by reference to tell whether a cached mesh (see GradientMesh) is still valid.
+    ///
+    /// Supported: angles (deg, rad, grad, turn) and "to side/corner" directions; circle/ellipse, the four size
+    /// keywords or explicit radii, and "at" positions; color stops with 0-2 positions in % or px. Colors are hex,
+    /// named, transparent, rgb() or rgba(). Color hints are ignored.
+    /// </summary>
+    public class CssGradient {
+        public enum Kind { Linear, Radial }
+        public enum RadialSize { ClosestSide, ClosestCorner, FarthestSide, FarthestCorner, Explicit }
+
+        public struct Stop {
+            public Color color;
+            public Length position;
+            public bool hasPosition;
+        }
+
+        public Kind kind { get; private set; }
+        public bool repeating { get; private set; }
+        public string source { get; private set; }
+
+        /// <summary>
+        /// Linear only. Degrees, clockwise from "to top" (so the default, "to bottom", is 180).
+        /// </summary>
+        public float angle { get; private set; } = 180;
+        /// <summary>
+        /// Linear only. Set for "to top left" etc., whose angle depends on the rect: -1 or 1 per axis.
+        /// </summary>
+        public Vector2Int corner { get; private set; }
+
+        public bool circle { get; private set; }
+        public RadialSize size { get; private set; } = RadialSize.FarthestCorner;
+        public Length radiusX { get; private set; }
+        public Length radiusY { get; private set; }
+        public Length centerX { get; private set; } = Length.Percent(50);
+        public Length centerY { get; private set; } = Length.Percent(50);
+
+        public IReadOnlyList<Stop> stops => _stops;
+
+        readonly List<Stop> _stops = new List<Stop>();
+
+        public static bool IsGradient(string text) {
+            if (text == null)
+                return false;
+            text = text.TrimStart();
+            if (text.StartsWith("repeating-", StringComparison.OrdinalIgnoreCase))
+                text = text.Substring(10);
+            return text.StartsWith("linear-gradient(", StringComparison.OrdinalIgnoreCase) ||
+                   text.StartsWith("radial-gradient(", StringComparison.OrdinalIgnoreCase);
+        }
+
+        public static bool TryParse(string text, out CssGradient gradient) {
+            gradient = null;
+            if (!IsGradient(text))
+                return false;
+            var result = new CssGradient { source = text };
+            var s = text.Trim();
+            if (s.StartsWith("repeating-", StringComparison.OrdinalIgnoreCase)) {
+                result.repeating = true;
+                s = s.Substring(10);
+            }
+            result.kind = s.StartsWith("radial", StringComparison.OrdinalIgnoreCase) ? Kind.Radial : Kind.Linear;
+            var open = s.IndexOf('(');
+            if (!s.EndsWith(")"))
+                return false;
+            var args = SplitTopLevel(s.Substring(open + 1, s.Length - open - 2), ',');
+            if (args.Count == 0)
+                return false;
+
+            var first = 0;
+            var tokens = SplitTopLevel(args[0].Trim(), ' ');
+            if (tokens.Count > 0 && !TryParseColor(tokens[0], out _)) {
+                var ok = result.kind == Kind.Linear ? result.ParseDirection(tokens) : result.ParseShape(tokens);
+                if (!ok)
+                    return false;
+                first = 1;
+            }
+            for (int i = first; i < args.Count; i++) {
+                if (!result.ParseStop(args[i]))
+                    return false;
+            }
+            if (result._stops.Count == 0)
+                return false;
+            gradient = result;
+            return true;
+        }
+
+        #region Resolving
+        /// <summary>
+        /// The linear gradient's angle for a rect (in degrees, clockwise from up).
+        /// </summary>
+        public float ResolveAngle(Rect rect) {
+            if (corner == Vector2Int.zero)
+                return angle;
+            // The 50% line runs through the two other corners
+            var degrees = Mathf.Atan2(rect.height, rect.width) * Mathf.Rad2Deg;
+            if (corner.y > 0)
+                degrees = 180 - degrees;
+            if (corner.x < 0)
+                degrees = 360 - degrees;
+            return degrees;
+        }
+
+        public Vector2 ResolveCenter(Rect rect) {
+            return new Vector2(rect.x + Resolve(centerX, rect.width), rect.y + Resolve(centerY, rect.height));
+        }
+
+        /// <summary>
+        /// The radial gradient's ending shape radii for a rect (y down).
+        /// </summary>
+        public Vector2 ResolveRadii(Rect rect, Vector2 center) {
+            var left = Mathf.Abs(center.x - rect.xMin);
+            var right = Mathf.Abs(rect.xMax - center.x);
+            var top = Mathf.Abs(center.y - rect.yMin);
+            var bottom = Mathf.Abs(rect.yMax - center.y);
+            var closest = new Vector2(Mathf.Min(left, right), Mathf.Min(top, bottom));
+            var farthest = new Vector2(Mathf.Max(left, right), Mathf.Max(top, bottom));
+            switch (size) {
+                case RadialSize.Explicit:
+                    return new Vector2(Resolve(radiusX, rect.width), Resolve(radiusY, rect.height));
+                case RadialSize.ClosestSide:
+                    return circle ? Vector2.one * Mathf.Min(closest.x, closest.y) : closest;
+                case RadialSize.FarthestSide:
+                    return circle ? Vector2.one * Mathf.Max(farthest.x, farthest.y) : farthest;
+                case RadialSize.ClosestCorner:
+                    // An ellipse keeps the closest side's aspect ratio and passes through the corner
+                    return circle ? Vector2.one * closest.magnitude : closest * Mathf.Sqrt(2);
+                default:
+                    return circle ? Vector2.one * farthest.magnitude : farthest * Mathf.Sqrt(2);
+            }
+        }
+
+        /// <summary>
+        /// Stop positions as fractions of the gradient length (in px: the gradient line, or the horizontal radius),
+        /// with missing positions filled in and kept in ascending order, as CSS specifies.
+        /// </summary>
+        public void ResolveStops(float length, List<(float t, Color color)> result) {
+            result.Clear();
+            var positions = new float?[_stops.Count];
+            for (int i = 0; i < _stops.Count; i++) {
+                if (_stops[i].hasPosition)
+                    positions[i] = Resolve(_stops[i].position, length) / Mathf.Max(length, 0.001f);
+            }
+            positions[0] ??= 0;
+            positions[_stops.Count - 1] ??= 1;
+            var last = positions[0].Value;
+            for (int i = 1; i < _stops.Count; i++) {
+                if (positions[i] == null) {
+                    // Evenly spread the run of stops without a position
+                    var next = i;
+                    while (positions[next] == null)
+                        next++;
+                    var end = Mathf.Max(positions[next].Value, last);
+                    for (int j = i; j < next; j++)
+                        positions[j] = last + (end - last) * (j - i + 1) / (next - i + 1);
+                }
+                positions[i] = Mathf.Max(positions[i].Value, last);
+                last = positions[i].Value;
+            }
+            for (int i = 0; i < _stops.Count; i++) {
+                var color = _stops[i].color;
+                if (color.a > 0) {
+                    result.Add((positions[i].Value, color));
+                    continue;
+                }
+                // Fully transparent stops take their neighbors' colors, so fades don't go through black (CSS
+                // interpolates premultiplied colors)
+                var before = i > 0 ? _stops[i - 1].color : i + 1 < _stops.Count ? _stops[i + 1].color : color;
+                var after = i + 1 < _stops.Count ? _stops[i + 1].color : before;
+                result.Add((positions[i].Value, new Color(before.r, before.g, before.b, 0)));
+                if (after != before)
+                    result.Add((positions[i].Value, new Color(after.r, after.g, after.b, 0)));
+            }
+        }
+
+        static float Resolve(Length length, float size) {
+            return length.unit == LengthUnit.Percent ? length.value / 100f * size : length.value;
+        }
+        #endregion
+
+        #region Parsing
+        bool ParseDirection(List<string> tokens) {
+            if (tokens[0].Equals("to", StringComparison.OrdinalIgnoreCase)) {
+                var x = 0;
+                var y = 0;
+                for (int i = 1; i < tokens.Count; i++) {
+                    switch (tokens[i].ToLowerInvariant()) {
+                        case "left": x = -1; break;
+                        case "right": x = 1; break;
+                        case "top": y = -1; break;
+                        case "bottom": y = 1; break;
+                        default: return false;
+                    }
+                }
+                if (x == 0 && y == 0)
+                    return false;
+                if (x != 0 && y != 0)
+                    corner = new Vector2Int(x, y);
+                else
+                    angle = x == 1 ? 90 : x == -1 ? 270 : y == -1 ? 0 : 180;
+                return true;
+            }
+            if (tokens.Count != 1 || !TryParseAngle(tokens[0], out var degrees))
+                return false;
+            angle = degrees;
+            return true;
+        }
+
+        bool ParseShape(List<string> tokens) {
+            var lengths = new List<Length>();
+            var i = 0;
+            for (; i < tokens.Count; i++) {
+                var token = tokens[i].ToLowerInvariant();
+                if (token == "at")
+                    break;
+                switch (token) {
+                    case "circle": circle = true; break;
+                    case "ellipse": circle = false; break;
+                    case "closest-side": size = RadialSize.ClosestSide; break;
+                    case "closest-corner": size = RadialSize.ClosestCorner; break;
+                    case "farthest-side": size = RadialSize.FarthestSide; break;
+                    case "farthest-corner": size = RadialSize.FarthestCorner; break;
+                    default:
+                        if (!TryParseLength(token, out var length))
+                            return false;
+                        lengths.Add(length);
+                        break;
+                }
+            }
+            if (lengths.Count == 1) {
+                // A single length is a circle's radius
+                if (lengths[0].unit == LengthUnit.Percent)
+                    return false;
+                circle = true;
+                size = RadialSize.Explicit;
+                radiusX = radiusY = lengths[0];
+            } else if (lengths.Count == 2) {
+                if (circle)
+                    return false;
+                size = RadialSize.Explicit;
+                radiusX = lengths[0];
+                radiusY = lengths[1];
+            } else if (lengths.Count > 2) {
+                return false;
+            }
+            if (i < tokens.Count)
+                return ParsePosition(tokens.GetRange(i + 1, tokens.Count - i - 1));
+            return true;
+        }
+
+        bool ParsePosition(List<string> tokens) {
+            if (tokens.Count == 0 || tokens.Count > 2)
+                return false;
+            Length? x = null;
+            Length? y = null;
+            foreach (var token in tokens) {
+                switch (token.ToLowerInvariant()) {
+                    case "left": x = Length.Percent(0); break;
+                    case "right": x = Length.Percent(100); break;
+                    case "top": y = Length.Percent(0); break;
+                    case "bottom": y = Length.Percent(100); break;
+                    case "center":
+                        // Fills whichever axis is left
+                        if (tokens.Count == 1) {
+                            x = y = Length.Percent(50);
+                        } else if (x == null) {
+                            x = Length.Percent(50);
+                        } else {
+                            y = Length.Percent(50);
+                        }
+                        break;
+                    default:
+                        if (!TryParseLength(token, out var length))
+                            return false;
+                        if (x == null)
+                            x = length;
+                        else
+                            y = length;
+                        break;
+                }
+            }
+            centerX = x ?? Length.Percent(50);
+            centerY = y ?? Length.Percent(50);
+            return true;
+        }
+
+        bool ParseStop(string arg) {
+            var tokens = SplitTopLevel(arg.Trim(), ' ');
+            if (tokens.Count == 0)
+                return false;
+            if (!TryParseColor(tokens[0], out var color)) {
+                // A color hint ("30%") on its own: not supported, so it's skipped
+                return tokens.Count == 1 && TryParseLength(tokens[0], out _);
+            }
+            if (tokens.Count == 1) {
+                _stops.Add(new Stop { color = color });
+                return true;
+            }
+            for (int i = 1; i < tokens.Count; i++) {
+                if (i > 2 || !TryParseLength(tokens[i], out var position))
+                    return false;
+                _stops.Add(new Stop { color = color, position = position, hasPosition = true });
+            }
+            return true;
+        }
+
+        static bool TryParseAngle(string token, out float degrees) {
+            token = token.ToLowerInvariant();
+            string[] units = { "deg", "grad", "rad", "turn" };
+            float[] scales = { 1, 0.9f, Mathf.Rad2Deg, 360 };
+            for (int i = 0; i < units.Length; i++) {
+                if (token.EndsWith(units[i]) && TryParseNumber(token.Substring(0, token.Length - units[i].Length), out var value)) {
+                    degrees = value * scales[i];
+                    return true;
+                }
+            }
+            degrees = 0;
+            return token == "0";
+        }
+
+        static bool TryParseLength(string token, out Length length) {
+            token = token.ToLowerInvariant();
+            if (token.EndsWith("%") && TryParseNumber(token.Substring(0, token.Length - 1), out var percent)) {
+                length = Length.Percent(percent);
+                return true;
+            }
+            if (token.EndsWith("px") && TryParseNumber(token.Substring(0, token.Length - 2), out var px)) {
+                length = new Length(px);
+                return true;
+            }
+            length = default;
+            if (token == "0") {
+                length = new Length(0);
+                return true;
+            }
+            return false;
+        }
+
+        static bool TryParseNumber(string token, out float value) {
+            return float.TryParse(token, NumberStyles.Float, CultureInfo.InvariantCulture, out value);
+        }
+
+        /// <summary>
+        /// What DomStyle accepts (hex and named colors), plus transparent, rgb() and rgba().
+        /// </summary>
+        public static bool TryParseColor(string token, out Color color) {
+            var lower = token.Trim().ToLowerInvariant();
+            if (lower == "transparent") {
+                color = new Color(0, 0, 0, 0);
+                return true;
+            }
+            if (lower.StartsWith("rgb") && lower.EndsWith(")")) {
+                color = default;
+                var open = lower.IndexOf('(');
+                var parts = lower.Substring(open + 1, lower.Length - open - 2)
+                    .Split(new[] { ',', ' ', '/' }, StringSplitOptions.RemoveEmptyEntries);
+                if (parts.Length != 3 && parts.Length != 4)
+                    return false;
+                var channels = new float[4] { 0, 0, 0, 1 };
+                for (int i = 0; i < parts.Length; i++) {
+                    var part = parts[i];
+                    var isPercent = part.EndsWith("%");
+                    if (!TryParseNumber(isPercent ? part.Substring(0, part.Length - 1) : part, out var value))
+                        return false;
+                    channels[i] = isPercent ? value / 100f : i < 3 ? value / 255f : value;
+                }
+                color = new Color(Mathf.Clamp01(channels[0]), Mathf.Clamp01(channels[1]), Mathf.Clamp01(channels[2]),
+                    Mathf.Clamp01(channels[3]));
+                return true;
+            }
+            return DomStyle.TryParseColorString(lower, out color);
+        }
+
+        /// <summary>
+        /// Splits on the separator outside of parentheses. Empty parts are dropped.
+        /// </summary>
+        static List<string> SplitTopLevel(string text, char separator) {
+            var parts = new List<string>();
+            var depth = 0;
+            var start = 0;
+            for (int i = 0; i <= text.Length; i++) {
+                var c = i < text.Length ? text[i] : separator;
+                if (c == '(') depth++;
+                else if (c == ')') depth--;
+                else if (depth == 0 && (c == separator || (separator == ' ' && char.IsWhiteSpace(c)))) {
+                    var part = text.Substring(start, i - start).Trim();
+                    if (part.Length > 0)
+                        parts.Add(part);
+                    start = i + 1;
+                }
+            }
+            return parts;
+        }
+        #endregion
+    }
+}
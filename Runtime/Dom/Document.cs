@@ -27,40 +27,96 @@ namespace OneJS.Dom {
         VisualElement _root;
         ScriptEngine _scriptEngine;
         List<StyleSheet> _runtimeStyleSheets = new List<StyleSheet>();
+        Dictionary<string, StyleSheet> _runtimeStyleSheetFiles = new Dictionary<string, StyleSheet>();
 
         Dictionary<VisualElement, Dom> _elementToDomLookup = new();
 
         Dictionary<string, ElementTypeInfo> _tagCache = new();
-        Dictionary<string, Texture2D> _imageCache = new();
-        Dictionary<string, Font> _fontCache = new();
-        Dictionary<string, FontDefinition> _fontDefinitionCache = new();
         Type[] _tagTypes;
-        WebApi _webApi = new WebApi();
+        TextureCache _textureCache;
+        WebApi _webApi;
+        MediaQueryWatcher _mediaQueryWatcher;
 
         public Document(VisualElement root, ScriptEngine scriptEngine) {
             _root = root;
             _body = new Dom(_root, this);
             _scriptEngine = scriptEngine;
+            _textureCache = scriptEngine.TextureCache;
+            _webApi = new WebApi(_textureCache);
             _tagTypes = GetAllVisualElementTypes();
         }
 
-        public void addRuntimeUSS(string uss) {
-            var ss = ScriptableObject.CreateInstance<StyleSheet>();
-            var builder = new OneJS.CustomStyleSheets.CustomStyleSheetImporterImpl(_scriptEngine);
-            builder.BuildStyleSheet(ss, uss);
-            if (builder.importErrors.hasErrors) {
-                Debug.LogError($"Runtime USS Error(s)");
-                foreach (var error in builder.importErrors) {
-                    Debug.LogError(error);
-                }
-                return;
-            }
+        public StyleSheet addRuntimeUSS(string uss) {
+            var ss = BuildStyleSheet(uss);
+            if (ss == null)
+                return null;
             _runtimeStyleSheets.Add(ss);
             _root.styleSheets.Add(ss);
+            return ss;
+        }
+
+        /// <summary>
+        /// Loads a USS file as a runtime stylesheet. File-backed sheets can later be refreshed in place
+        /// (see reloadRuntimeUSS) when only styling changes, keeping JS state and the DOM intact.
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public StyleSheet loadRuntimeUSS(string path) {
+            var fullpath = Path.GetFullPath(Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path));
+            if (_runtimeStyleSheetFiles.TryGetValue(fullpath, out var existing) && existing != null)
+                return existing;
+            if (!_scriptEngine.FileExists(fullpath)) {
+                Debug.LogError($"USS file not found: {fullpath}");
+                return null;
+            }
+            var ss = addRuntimeUSS(_scriptEngine.ReadAllText(fullpath));
+            if (ss == null)
+                return null;
+            _runtimeStyleSheetFiles[fullpath] = ss;
+            _scriptEngine.NotifyStyleSheetFileLoaded(fullpath);
+            return ss;
+        }
+
+        /// <summary>
+        /// Rebuilds a file-backed runtime stylesheet from its file (read the same way as in loadRuntimeUSS) and
+        /// swaps it in at the same position, so cascade order is preserved. Returns false if the file isn't a loaded
+        /// runtime stylesheet.
+        /// </summary>
+        /// <param name="fullpath">Full path of the USS file</param>
+        public bool reloadRuntimeUSS(string fullpath) {
+            if (!_runtimeStyleSheetFiles.TryGetValue(fullpath, out var oldSheet))
+                return false;
+            var newSheet = BuildStyleSheet(_scriptEngine.ReadAllText(fullpath));
+            if (newSheet == null)
+                return true; // Keep the old sheet on errors (already logged)
+
+            var sheets = new List<StyleSheet>(_root.styleSheets.count);
+            for (int i = 0; i < _root.styleSheets.count; i++) {
+                var sheet = _root.styleSheets[i];
+                sheets.Add(sheet == oldSheet ? newSheet : sheet);
+            }
+            _root.styleSheets.Clear();
+            foreach (var sheet in sheets) {
+                _root.styleSheets.Add(sheet);
+            }
+            var index = _runtimeStyleSheets.IndexOf(oldSheet);
+            if (index >= 0)
+                _runtimeStyleSheets[index] = newSheet;
+            else
+                _runtimeStyleSheets.Add(newSheet);
+            _runtimeStyleSheetFiles[fullpath] = newSheet;
+            Object.Destroy(oldSheet);
+            return true;
         }
 
         public void removeRuntimeStyleSheet(StyleSheet sheet) {
             _root.styleSheets.Remove(sheet);
+            _runtimeStyleSheets.Remove(sheet);
+            foreach (var kv in _runtimeStyleSheetFiles) {
+                if (kv.Value == sheet) {
+                    _runtimeStyleSheetFiles.Remove(kv.Key);
+                    break;
+                }
+            }
             Object.Destroy(sheet);
         }
 
@@ -70,6 +126,40 @@ namespace OneJS.Dom {
                 Object.Destroy(sheet);
             }
             _runtimeStyleSheets.Clear();
+            _runtimeStyleSheetFiles.Clear();
+        }
+
+        StyleSheet BuildStyleSheet(string uss) {
+            var ss = ScriptableObject.CreateInstance<StyleSheet>();
+            var builder = new OneJS.CustomStyleSheets.CustomStyleSheetImporterImpl(_scriptEngine);
+            builder.BuildStyleSheet(ss, uss);
+            if (builder.importErrors.hasErrors) {
+                Debug.LogError($"Runtime USS Error(s)");
+                foreach (var error in builder.importErrors) {
+                    Debug.LogError(error);
+                }
+                Object.Destroy(ss);
+                return null;
+            }
+            return ss;
+        }
+
+        /// <summary>
+        /// Like window.matchMedia(): width, height, aspect-ratio and orientation are the root element's, resolution
+        /// is in physical pixels per UI pixel. Re-evaluated only when the root's geometry changes, and listeners are
+        /// only called when the result does.
+        /// </summary>
+        public MediaQueryList matchMedia(string query) {
+            _mediaQueryWatcher ??= new MediaQueryWatcher(_root);
+            return _mediaQueryWatcher.Match(query);
+        }
+
+        /// <summary>
+        /// Unregisters from the root and drops every JS listener (the root outlives the document across reloads).
+        /// </summary>
+        public void Dispose() {
+            _mediaQueryWatcher?.Dispose();
+            _mediaQueryWatcher = null;
         }
 
         public Dom createElement(string tagName) {
@@ -137,85 +227,211 @@ namespace OneJS.Dom {
             return null;
         }
 
+        /// <summary>
+        /// The image cache, shared with Resource and WebApi (see ScriptEngine.TextureCache).
+        /// </summary>
+        public TextureCache textureCache => _textureCache;
+
+        /// <summary>
+        /// Null unless ScriptEngine.useImageAtlas is on.
+        /// </summary>
+        public ImageAtlas imageAtlas => _scriptEngine.ImageAtlas;
+
+        public SvgLoader svgLoader => _scriptEngine.SvgLoader;
+
         public void clearCache() {
-            foreach (var tex in _imageCache.Values) {
-                if (tex != null) Object.Destroy(tex);
-            }
-            _imageCache.Clear();
-            _fontCache.Clear();
-            _fontDefinitionCache.Clear();
+            _textureCache.Clear();
+            _scriptEngine.SvgLoader.Purge();
+            // Fonts are shared by every engine (see FontManager), so only this one's are dropped
+            FontManager.Shared.Purge(_scriptEngine);
         }
 
+        /// <summary>
+        /// Schedules image loads for Img elements (see Img.Loading). Shared by every document of the ScriptEngine.
+        /// </summary>
+        public ImageLoadScheduler imageLoadScheduler => _scriptEngine.ImageLoadScheduler;
+
+        /// <summary>
+        /// Downloads an image (or gets it from the caches). The callback gets null if it couldn't be loaded.
+        /// </summary>
         public Coroutine loadRemoteImage(string url, Action<Texture2D> callback) {
-            if (_imageCache.TryGetValue(url, out var tex)) {
-                callback(tex);
-                return null;
-            }
-            return _webApi.getImage(url, (tex) => {
-                if (tex == null) {
-                    Debug.LogError($"Failed to load image: {url}");
-                    return;
-                }
-                _imageCache[url] = tex;
-                callback(tex);
-            });
+            // WebApi caches in the shared TextureCache (keyed by the URL)
+            return _webApi.getImage(url, callback);
+        }
+
+        /// <summary>
+        /// Drops a callback passed to loadRemoteImage. The download is aborted if nothing else is waiting for it.
+        /// </summary>
+        public void cancelRemoteImage(string url, Action<Texture2D> callback) {
+            _webApi.cancelImage(url, callback);
         }
 
         /// <summary>
-        /// Loads an image from the specified path and returns a Texture2D object.
+        /// Loads an image from the specified path and returns a Texture2D object. The texture lives in the
+        /// TextureCache: elements showing it keep it alive (see TextureLease), anything else can be evicted once the
+        /// frame is over, unless the script holds on to it with retainImage.
         /// </summary>
         /// <param name="path">Relative to the WorkingDir</param>
         public Texture2D loadImage(string path, FilterMode filterMode = FilterMode.Bilinear) {
-            if (_imageCache.TryGetValue(path, out var texture)) {
+            var key = _scriptEngine.GetFullPath(path);
+            if (_textureCache.TryGet(key, out var texture)) {
                 return texture;
             }
-            try {
-                var fullpath = Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path);
-                var rawData = File.ReadAllBytes(fullpath);
-                Texture2D tex = new Texture2D(2, 2); // Create an empty Texture; size doesn't matter
-                tex.LoadImage(rawData);
-                tex.filterMode = filterMode;
-                _imageCache[path] = tex; // caches the original path
-                return tex;
-            } catch (Exception) {
-                Debug.LogError($"Failed to load image: {path}");
-                // Debug.LogError(e);
-                return null;
+            var tex = LoadTexture(path, filterMode);
+            return tex != null ? _textureCache.Add(key, tex) : null;
+        }
+
+        /// <summary>
+        /// Like loadImage, but reads and decodes the image off the main thread. The callback is invoked on the main
+        /// thread with the texture (or null if it couldn't be loaded); right away if the image is already cached.
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public void loadImageAsync(string path, Action<Texture2D> callback, FilterMode filterMode = FilterMode.Bilinear) {
+            var key = _scriptEngine.GetFullPath(path);
+            if (_textureCache.TryGet(key, out var texture)) {
+                callback(texture);
+                return;
             }
+            _scriptEngine.ImageLoader.Load(path, filterMode, tex => {
+                // Returns the already cached texture if it was loaded synchronously in the meantime
+                callback(tex != null ? _textureCache.Add(key, tex) : null);
+            });
         }
 
         /// <summary>
-        /// Loads a font from the specified path and returns a Font object.
+        /// Loads an image for use as an element background (or by Img). With ScriptEngine.useImageAtlas on, small
+        /// images come from the runtime ImageAtlas as sprites, so elements showing them can be batched. Anything
+        /// else is a texture, same as loadImage.
         /// </summary>
         /// <param name="path">Relative to the WorkingDir</param>
-        public Font loadFont(string path) {
-            if (_fontCache.TryGetValue(path, out var f)) {
-                return f;
+        public Background loadBackground(string path, FilterMode filterMode = FilterMode.Bilinear) {
+            var atlas = _scriptEngine.ImageAtlas;
+            if (atlas == null || filterMode != FilterMode.Bilinear)
+                return Background.FromTexture2D(loadImage(path, filterMode));
+            var key = _scriptEngine.GetFullPath(path);
+            if (TryGetBackground(atlas, key, out var background))
+                return background;
+            return ToBackground(atlas, key, LoadTexture(path, filterMode));
+        }
+
+        /// <summary>
+        /// Like loadBackground, but reads and decodes the image off the main thread (see loadImageAsync).
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public void loadBackgroundAsync(string path, Action<Background> callback, FilterMode filterMode = FilterMode.Bilinear) {
+            var atlas = _scriptEngine.ImageAtlas;
+            if (atlas == null || filterMode != FilterMode.Bilinear) {
+                loadImageAsync(path, tex => callback(Background.FromTexture2D(tex)), filterMode);
+                return;
             }
-            try {
-                path = Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path);
-                var font = new Font(path);
-                _fontCache[path] = font;
-                return font;
-            } catch (Exception) {
-                Debug.LogError($"Failed to load font: {path}");
-                // Debug.LogError(e);
-                return null;
+            var key = _scriptEngine.GetFullPath(path);
+            if (TryGetBackground(atlas, key, out var background)) {
+                callback(background);
+                return;
             }
+            // Exclusive, since ToBackground destroys the texture once it's copied into the atlas
+            _scriptEngine.ImageLoader.Load(path, filterMode, tex => callback(ToBackground(atlas, key, tex)), true);
         }
 
         /// <summary>
-        /// Loads a font from the specified path and returns a FontDefinition object.
+        /// What loadBackground would return for the path, if it's already loaded (atlas sprite or cached texture).
+        /// Lets Img show cached images in the same frame instead of going through the ImageLoadScheduler.
         /// </summary>
         /// <param name="path">Relative to the WorkingDir</param>
-        public FontDefinition loadFontDefinition(string path) {
-            if (_fontDefinitionCache.TryGetValue(path, out var fd)) {
-                return fd;
+        public bool tryGetCachedBackground(string path, out Background background) {
+            var key = _scriptEngine.GetFullPath(path);
+            var atlas = _scriptEngine.ImageAtlas;
+            if (atlas != null) {
+                return TryGetBackground(atlas, key, out background);
             }
-            path = Path.IsPathRooted(path) ? path : Path.Combine(_scriptEngine.WorkingDir, path);
-            var font = new Font(path);
-            _fontCache[path] = font;
-            return FontDefinition.FromFont(font);
+            if (_textureCache.TryGet(key, out var texture)) {
+                background = Background.FromTexture2D(texture);
+                return true;
+            }
+            background = default;
+            return false;
+        }
+
+        /// <summary>
+        /// Keeps a texture from loadImage, loadImageAsync or loadRemoteImage in the TextureCache until it's given
+        /// back with releaseImage (or the engine reloads), i.e. to show it later or draw with it. Not needed for
+        /// textures shown on an element, which keeps them alive by itself.
+        /// </summary>
+        public void retainImage(Texture2D texture) {
+            _textureCache.HandOut(texture);
+        }
+
+        /// <summary>
+        /// Same as retainImage, for loadBackground, loadBackgroundAsync and tryGetCachedBackground.
+        /// </summary>
+        public void retainBackground(Background background) {
+            _textureCache.HandOut(background.texture);
+            _scriptEngine.ImageAtlas?.HandOut(background.sprite);
+        }
+
+        /// <summary>
+        /// Lets go of a texture kept with retainImage, so the TextureCache can evict it once nothing displays it.
+        /// Call once per retainImage; textures that weren't retained are ignored.
+        /// </summary>
+        public void releaseImage(Texture2D texture) {
+            _textureCache.ReleaseHandOut(texture);
+        }
+
+        /// <summary>
+        /// Same as releaseImage, for retainBackground.
+        /// </summary>
+        public void releaseBackground(Background background) {
+            _textureCache.ReleaseHandOut(background.texture);
+            _scriptEngine.ImageAtlas?.ReleaseHandOut(background.sprite);
+        }
+
+        /// <summary>
+        /// Loads an .svg file as a VectorImage, parsed off the main thread and tessellated for the given size (see
+        /// SvgLoader). The callback gets null if it couldn't be loaded; it's invoked right away if already cached.
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        /// <param name="size">Longest side in pixels, rounded up to a power of two; 0 for the SVG's own size</param>
+        /// <param name="currentColor">What currentColor in the SVG paints with (the element's color); black if
+        /// null. Taken when the image is tessellated, so later color changes don't apply.</param>
+        public void loadVectorImageAsync(string path, int size, Action<VectorImage> callback, Color? currentColor = null) {
+            _scriptEngine.SvgLoader.Load(_scriptEngine.GetFullPath(path), SvgLoader.SizeBucket(size), callback,
+                currentColor);
+        }
+
+        /// <summary>
+        /// Loads a font from the specified path and returns a Font object. Cached process-wide (see FontManager).
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public Font loadFont(string path) {
+            return FontManager.Shared.GetFont(_scriptEngine.GetDiskPath(path), _scriptEngine);
+        }
+
+        /// <summary>
+        /// Loads a font from the specified path and returns a FontDefinition object. Cached process-wide (see
+        /// FontManager).
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public FontDefinition loadFontDefinition(string path) {
+            return FontManager.Shared.GetFontDefinition(_scriptEngine.GetDiskPath(path), _scriptEngine);
+        }
+
+        /// <summary>
+        /// Like loadFontDefinition, but loads the font on the next frame (see FontManager.LoadAsync). Optionally
+        /// pre-warms glyphs for the given characters (i.e. the alphabet of a language about to be shown), spread
+        /// over the next frames.
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public void loadFontDefinitionAsync(string path, Action<FontDefinition> callback, string prewarmCharacters = null) {
+            FontManager.Shared.LoadAsync(_scriptEngine.GetDiskPath(path), callback, prewarmCharacters, _scriptEngine);
+        }
+
+        /// <summary>
+        /// Adds glyphs for the given characters to a font's atlas ahead of time, so the first text using them
+        /// doesn't hitch (see FontManager.Prewarm).
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir</param>
+        public void prewarmFont(string path, string characters) {
+            FontManager.Shared.Prewarm(_scriptEngine.GetDiskPath(path), characters, _scriptEngine);
         }
 
         public static object createStyleEnum(int v, Type type) {
@@ -264,6 +480,60 @@ namespace OneJS.Dom {
             _elementToDomLookup.Remove(dom.ve);
         }
 
+        /// <summary>
+        /// Loads an image into a new, uncached texture. Null (and logs an error) if it can't be loaded.
+        /// </summary>
+        Texture2D LoadTexture(string path, FilterMode filterMode) {
+            try {
+                var rawData = _scriptEngine.ReadAllBytes(path);
+                Texture2D tex = new Texture2D(2, 2); // Create an empty Texture; size doesn't matter
+                tex.LoadImage(rawData);
+                tex.filterMode = filterMode;
+                return tex;
+            } catch (Exception) {
+                Debug.LogError($"Failed to load image: {path}");
+                // Debug.LogError(e);
+                return null;
+            }
+        }
+
+        /// <summary>
+        /// Atlas sprite or cached texture (images too big for the atlas, or that didn't fit) for the key.
+        /// </summary>
+        bool TryGetBackground(ImageAtlas atlas, string key, out Background background) {
+            if (atlas.TryGet(key, out var sprite)) {
+                background = Background.FromSprite(sprite);
+                return true;
+            }
+            if (_textureCache.TryGet(key, out var texture)) {
+                background = Background.FromTexture2D(texture);
+                return true;
+            }
+            background = default;
+            return false;
+        }
+
+        /// <summary>
+        /// Moves a freshly loaded texture into the atlas if it fits there, or into the TextureCache otherwise.
+        /// The texture has to be the caller's own (LoadTexture, or an exclusive ImageLoader load), since it's
+        /// destroyed once it's in the atlas.
+        /// </summary>
+        Background ToBackground(ImageAtlas atlas, string key, Texture2D texture) {
+            // Already there if it was loaded in the meantime (or this texture was handed to several callbacks)
+            if (TryGetBackground(atlas, key, out var background)) {
+                if (texture != null && texture != background.texture)
+                    Object.Destroy(texture);
+                return background;
+            }
+            if (texture == null)
+                return default;
+            var sprite = atlas.Add(key, texture);
+            if (sprite == null)
+                return Background.FromTexture2D(_textureCache.Add(key, texture));
+            Object.Destroy(texture);
+            return Background.FromSprite(sprite);
+        }
+
         Type[] GetAllVisualElementTypes() {
             List<Type> visualElementTypes = new List<Type>();
             Assembly[] assemblies = AppDomain.CurrentDomain.GetAssemblies();
@@ -133,6 +133,8 @@ namespace OneJS.Dom {
         Dictionary<string, List<RegisteredCallbackHolder>> _registeredCallbacks =
             new Dictionary<string, List<RegisteredCallbackHolder>>();
 
+        List<GestureRecognizer> _gestures;
+
         static Dictionary<string, RegisterCallbackDelegate> _eventCache =
             new Dictionary<string, RegisterCallbackDelegate>();
 
@@ -282,6 +284,49 @@ namespace OneJS.Dom {
             }
         }
 
+        /// <summary>
+        /// Attaches a gesture recognizer ("pan", "pinch", "swipe" or "longpress"). Pointer events are handled in C#;
+        /// the callback only runs on state changes (began/changed/ended/cancelled, or recognized for swipes), with
+        /// "changed" coalesced to once per frame. Options are a plain object, see GestureOptions.
+        /// </summary>
+        /// <returns>Pass to removeGesture, or set its `enabled`</returns>
+        public GestureRecognizer addGesture(string type, object options, Action<GestureEvent> callback) {
+            var gesture = GestureRecognizer.Create(type, _ve, GestureOptions.From(options), callback);
+            _gestures ??= new List<GestureRecognizer>();
+            _gestures.Add(gesture);
+            return gesture;
+        }
+
+        public void removeGesture(GestureRecognizer gesture) {
+            if (gesture == null || _gestures == null || !_gestures.Remove(gesture))
+                return;
+            gesture.Dispose();
+        }
+
+        /// <summary>
+        /// Removes every gesture of the given type, or all of them if null.
+        /// </summary>
+        public void removeGestures(string type = null) {
+            if (_gestures == null)
+                return;
+            for (var i = _gestures.Count - 1; i >= 0; i--) {
+                if (type != null && _gestures[i].type != type.ToLowerInvariant().Replace("-", ""))
+                    continue;
+                _gestures[i].Dispose();
+                _gestures.RemoveAt(i);
+            }
+        }
+
+        /// <summary>
+        /// Removed elements aren't reused, so their (and their descendants') recognizers go with them instead of
+        /// keeping the JS callbacks alive.
+        /// </summary>
+        void DisposeGestures() {
+            removeGestures();
+            foreach (var child in _childNodes)
+                child.DisposeGestures();
+        }
+
         public void appendChild(Dom node) {
             if (node == null)
                 return;
@@ -315,6 +360,7 @@ namespace OneJS.Dom {
             _childNodes.Remove(child);
             child._parentNode = null;
             TryRemoveCacheDom(child);
+            child.DisposeGestures();
         }
 
         public void insertBefore(Dom a, Dom b) {
@@ -13,7 +13,13 @@ namespace OneJS.Dom {
         static readonly Dictionary<string, PropertyInfo> _propCache = new(StringComparer.OrdinalIgnoreCase);
 
         Dom _dom;
-        Coroutine _imageCoroutine;
+        string _remoteImageUrl;
+        Action<Texture2D> _remoteImageCallback;
+        TextureLease _backgroundLease;
+        GradientBackground _gradientBackground;
+        string _svgBackground;
+        int _svgBackgroundSize = -1;
+        bool _svgGeometryCallback;
 
         public DomStyle(Dom dom) {
             this._dom = dom;
@@ -85,18 +91,42 @@ namespace OneJS.Dom {
         }
 
         public object backgroundImage {
-            get => veStyle.backgroundImage;
+            get => _gradientBackground?.gradient != null ? _gradientBackground.gradient.source :
+                _svgBackground ?? (object)veStyle.backgroundImage;
             set {
+                if (value is string svg && SvgLoader.IsSvg(svg) && !IsRemoteUrl(svg)) {
+                    _gradientBackground?.Set(null);
+                    SetSvgBackground(svg);
+                    return;
+                }
+                _svgBackground = null;
+                if (value is string g && CssGradient.IsGradient(g)) {
+                    SetGradientBackground(g);
+                    return;
+                }
+                _gradientBackground?.Set(null);
+                CancelRemoteImage();
                 if (value is string s && IsRemoteUrl(s)) {
-                    StaticCoroutine.Stop(_imageCoroutine);
-                    _imageCoroutine = _dom.document.loadRemoteImage(s, (texture) => {
+                    Action<Texture2D> callback = null;
+                    callback = (texture) => {
+                        if (_remoteImageCallback != callback)
+                            return;
+                        _remoteImageUrl = null;
+                        _remoteImageCallback = null;
+                        if (texture == null)
+                            return;
                         veStyle.backgroundImage = new StyleBackground(Background.FromTexture2D(texture));
-                        _imageCoroutine = null;
-                    });
+                        SetLeasedBackground(Background.FromTexture2D(texture));
+                    };
+                    _remoteImageUrl = s;
+                    _remoteImageCallback = callback;
+                    _dom.document.loadRemoteImage(s, callback);
                     return;
                 }
-                if (TryParseStyleBackground(value, out var styleBackground))
+                if (TryParseStyleBackground(value, out var styleBackground)) {
                     veStyle.backgroundImage = styleBackground;
+                    SetLeasedBackground(styleBackground.value);
+                }
             }
         }
 
@@ -1009,6 +1039,83 @@ namespace OneJS.Dom {
             return false;
         }
 
+        /// <summary>
+        /// Drops the callback of a remote background that's still downloading (WebApi aborts the download if
+        /// nothing else is waiting for it).
+        /// </summary>
+        void CancelRemoteImage() {
+            if (_remoteImageCallback == null)
+                return;
+            _dom.document.cancelRemoteImage(_remoteImageUrl, _remoteImageCallback);
+            _remoteImageUrl = null;
+            _remoteImageCallback = null;
+        }
+
+        /// <summary>
+        /// linear-gradient() and radial-gradient() backgrounds are drawn as meshes (see GradientMesh) rather than
+        /// baked into textures.
+        /// </summary>
+        void SetGradientBackground(string value) {
+            if (_gradientBackground?.gradient?.source == value)
+                return;
+            if (!CssGradient.TryParse(value, out var gradient)) {
+                Debug.LogWarning($"Invalid gradient: {value}");
+                return;
+            }
+            CancelRemoteImage();
+            veStyle.backgroundImage = new StyleBackground(StyleKeyword.Null);
+            SetLeasedBackground(default);
+            _gradientBackground ??= new GradientBackground(_dom.ve);
+            _gradientBackground.Set(gradient);
+        }
+
+        /// <summary>
+        /// SVG backgrounds become VectorImages tessellated for the element's size, and again whenever it's resized
+        /// into another size bucket (see SvgLoader).
+        /// </summary>
+        void SetSvgBackground(string path) {
+            if (_svgBackground == path)
+                return;
+            CancelRemoteImage();
+            _svgBackground = path;
+            LoadSvgBackground();
+            if (!_svgGeometryCallback) {
+                _dom.ve.RegisterCallback<GeometryChangedEvent>(OnSvgBackgroundGeometryChanged);
+                _svgGeometryCallback = true;
+            }
+        }
+
+        void LoadSvgBackground() {
+            var path = _svgBackground;
+            _svgBackgroundSize = SvgLoader.SizeBucket(SvgLoader.DisplaySize(_dom.ve));
+            _dom.document.loadVectorImageAsync(path, _svgBackgroundSize, (vectorImage) => {
+                if (_svgBackground != path || vectorImage == null)
+                    return;
+                var background = Background.FromVectorImage(vectorImage);
+                veStyle.backgroundImage = new StyleBackground(background);
+                SetLeasedBackground(background);
+            }, _dom.ve.resolvedStyle.color);
+        }
+
+        void OnSvgBackgroundGeometryChanged(GeometryChangedEvent evt) {
+            if (_svgBackground == null)
+                return;
+            if (SvgLoader.SizeBucket(SvgLoader.DisplaySize(_dom.ve)) != _svgBackgroundSize)
+                LoadSvgBackground();
+        }
+
+        /// <summary>
+        /// Keeps the background texture (or atlas sprite, or SVG) retained in the document's caches while the element
+        /// is shown.
+        /// </summary>
+        void SetLeasedBackground(Background background) {
+            if (_backgroundLease == null && background.texture == null && background.sprite == null &&
+                background.vectorImage == null)
+                return;
+            _backgroundLease ??= new TextureLease(_dom.document, _dom.ve);
+            _backgroundLease.Set(background);
+        }
+
         bool TryParseStyleBackground(object value, out StyleBackground styleBackground) {
             if (value is string ss && StyleKeyword.TryParse(ss, true, out StyleKeyword keyword)) {
                 styleBackground = new StyleBackground(keyword);
@@ -1028,9 +1135,9 @@ namespace OneJS.Dom {
             }
 
             if (value is string s) {
-                var texture = _dom.document.loadImage(s);
-                if (texture != null) {
-                    styleBackground = new StyleBackground(Background.FromTexture2D(texture));
+                var background = _dom.document.loadBackground(s);
+                if (background.texture != null || background.sprite != null) {
+                    styleBackground = new StyleBackground(background);
                     return true;
                 }
             } else if (value is Texture2D t) {
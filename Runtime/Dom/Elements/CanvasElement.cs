@@ -0,0 +1,473 @@
+﻿using System;
+using System.Collections.Generic;
+using Puerts;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// A subset of the Canvas 2D API, drawn with Painter2D (&lt;canvas-element&gt;). JS records commands into a
+    /// Float32Array (see Resources/onejs/canvas.js.txt, which adds getContext("2d"), width and height to this
+    /// element) and hands them over with one submit() call per batch; they're replayed in generateVisualContent, and
+    /// only trigger a repaint when they differ from the last batch.
+    ///
+    /// Supported: paths (moveTo, lineTo, bezierCurveTo, quadraticCurveTo, arc, arcTo, ellipse, rect, closePath),
+    /// fill (nonzero/evenodd), stroke, fillRect, strokeRect, color fill/stroke styles, lineWidth, lineCap, lineJoin,
+    /// miterLimit, globalAlpha, save/restore and transforms. clearRect over the whole canvas starts over; partial
+    /// clears, text, images, gradients and clipping aren't supported. Coordinates are in pixels from the top left
+    /// of the content rect (inside padding and borders), which is the canvas' width and height.
+    /// </summary>
+    public class CanvasElement : VisualElement {
+        public enum Op {
+            BeginPath = 1,
+            MoveTo = 2, // x y
+            LineTo = 3, // x y
+            BezierCurveTo = 4, // cp1x cp1y cp2x cp2y x y
+            QuadraticCurveTo = 5, // cpx cpy x y
+            Arc = 6, // x y radius startAngle endAngle counterclockwise
+            ArcTo = 7, // x1 y1 x2 y2 radius
+            ClosePath = 8,
+            Rect = 9, // x y w h
+            Fill = 10, // fillRule (0 nonzero, 1 evenodd)
+            Stroke = 11,
+            FillStyle = 12, // string index
+            StrokeStyle = 13, // string index
+            LineWidth = 14, // width
+            LineCap = 15, // 0 butt, 1 round, 2 square
+            LineJoin = 16, // 0 miter, 1 round, 2 bevel
+            MiterLimit = 17, // limit
+            FillRect = 18, // x y w h
+            StrokeRect = 19, // x y w h
+            ClearRect = 20, // x y w h
+            Save = 21,
+            Restore = 22,
+            Transform = 23, // a b c d e f (multiplies)
+            SetTransform = 24, // a b c d e f
+            GlobalAlpha = 25, // alpha
+            Ellipse = 26 // x y radiusX radiusY rotation startAngle endAngle counterclockwise
+        }
+
+        const int MinCapacity = 64 * 1024;
+
+        static readonly Dictionary<string, Color> _colorCache = new Dictionary<string, Color>();
+
+        public int commandLength => _count;
+
+        float[] _commands = Array.Empty<float>();
+        byte[] _bytes = Array.Empty<byte>();
+        int _count;
+        string _strings = "";
+        string[] _stringTable = Array.Empty<string>();
+        readonly Stack<State> _stack = new Stack<State>();
+
+        public CanvasElement() {
+            generateVisualContent = OnGenerateVisualContent;
+        }
+
+        /// <summary>
+        /// Replaces the commands. Repaints only if they changed.
+        /// </summary>
+        /// <param name="commands">Float32 commands (see Op), or null to clear</param>
+        /// <param name="strings">The strings commands refer to by index, newline-separated</param>
+        public void submit(ArrayBuffer commands, string strings) {
+            var length = commands?.Bytes != null ? commands.Count - commands.Count % 4 : 0;
+            strings ??= "";
+            if (length == _count * 4 && strings == _strings &&
+                new ReadOnlySpan<byte>(_bytes, 0, length).SequenceEqual(new ReadOnlySpan<byte>(commands?.Bytes, 0, length)))
+                return;
+            // Doubled to fit (batches usually grow a little every frame), and shrunk again once a much smaller
+            // batch comes in (i.e. after a full clear)
+            var capacity = _bytes.Length;
+            if (capacity < length)
+                capacity = Mathf.Max(length, capacity * 2);
+            else if (capacity > Mathf.Max(length * 4, MinCapacity))
+                capacity = length;
+            if (capacity != _bytes.Length) {
+                _bytes = new byte[capacity];
+                _commands = new float[capacity / 4];
+            }
+            if (length > 0)
+                Buffer.BlockCopy(commands.Bytes, 0, _bytes, 0, length);
+            Buffer.BlockCopy(_bytes, 0, _commands, 0, length);
+            _count = length / 4;
+            if (strings != _strings) {
+                _strings = strings;
+                _stringTable = strings.Length > 0 ? strings.Split('\n') : Array.Empty<string>();
+            }
+            MarkDirtyRepaint();
+        }
+
+        public void clear() {
+            submit(null, null);
+        }
+
+        void OnGenerateVisualContent(MeshGenerationContext mgc) {
+            if (_count == 0)
+                return;
+            // Everything before the last full clear is covered up anyway
+            var start = 0;
+            var rect = new Rect(Vector2.zero, contentRect.size);
+            for (int i = 0; i < _count;) {
+                var op = (Op)(int)_commands[i];
+                var size = ArgCount(op);
+                if (size < 0 || i + 1 + size > _count)
+                    break;
+                if (op == Op.ClearRect && Covers(_commands[i + 1], _commands[i + 2], _commands[i + 3], _commands[i + 4], rect))
+                    start = i + 1 + size;
+                i += 1 + size;
+            }
+            Replay(mgc.painter2D, start);
+        }
+
+        void Replay(Painter2D p, int start) {
+            // Canvas coordinates start at the content rect's top left
+            var origin = new Affine(1, 0, 0, 1, contentRect.x, contentRect.y);
+            var state = State.Default;
+            state.transform = origin;
+            _stack.Clear();
+            var hasPoint = false;
+            p.BeginPath();
+            var i = start;
+            while (i < _count) {
+                var op = (Op)(int)_commands[i];
+                var size = ArgCount(op);
+                if (size < 0 || i + 1 + size > _count) {
+                    Debug.LogWarning($"CanvasElement: invalid command {op} at {i}");
+                    break;
+                }
+                var a = i + 1;
+                i += 1 + size;
+                switch (op) {
+                    case Op.BeginPath:
+                        p.BeginPath();
+                        hasPoint = false;
+                        break;
+                    case Op.MoveTo:
+                        p.MoveTo(state.Apply(Arg(a), Arg(a + 1)));
+                        hasPoint = true;
+                        break;
+                    case Op.LineTo:
+                        LineTo(p, state.Apply(Arg(a), Arg(a + 1)), ref hasPoint);
+                        break;
+                    case Op.BezierCurveTo:
+                        if (!hasPoint)
+                            p.MoveTo(state.Apply(Arg(a), Arg(a + 1)));
+                        p.BezierCurveTo(state.Apply(Arg(a), Arg(a + 1)), state.Apply(Arg(a + 2), Arg(a + 3)),
+                            state.Apply(Arg(a + 4), Arg(a + 5)));
+                        hasPoint = true;
+                        break;
+                    case Op.QuadraticCurveTo:
+                        if (!hasPoint)
+                            p.MoveTo(state.Apply(Arg(a), Arg(a + 1)));
+                        p.QuadraticCurveTo(state.Apply(Arg(a), Arg(a + 1)), state.Apply(Arg(a + 2), Arg(a + 3)));
+                        hasPoint = true;
+                        break;
+                    case Op.Arc:
+                        Ellipse(p, state, Arg(a), Arg(a + 1), Arg(a + 2), Arg(a + 2), 0, Arg(a + 3), Arg(a + 4),
+                            Arg(a + 5) != 0, ref hasPoint);
+                        break;
+                    case Op.Ellipse:
+                        Ellipse(p, state, Arg(a), Arg(a + 1), Arg(a + 2), Arg(a + 3), Arg(a + 4), Arg(a + 5), Arg(a + 6),
+                            Arg(a + 7) != 0, ref hasPoint);
+                        break;
+                    case Op.ArcTo:
+                        if (!hasPoint)
+                            p.MoveTo(state.Apply(Arg(a), Arg(a + 1)));
+                        p.ArcTo(state.Apply(Arg(a), Arg(a + 1)), state.Apply(Arg(a + 2), Arg(a + 3)), Arg(a + 4) * state.Scale);
+                        hasPoint = true;
+                        break;
+                    case Op.ClosePath:
+                        p.ClosePath();
+                        break;
+                    case Op.Rect:
+                        AddRect(p, state, Arg(a), Arg(a + 1), Arg(a + 2), Arg(a + 3));
+                        hasPoint = true;
+                        break;
+                    case Op.Fill:
+                        p.fillColor = state.WithAlpha(state.fillColor);
+                        p.Fill(Arg(a) != 0 ? FillRule.OddEven : FillRule.NonZero);
+                        break;
+                    case Op.Stroke:
+                        ApplyStroke(p, state);
+                        p.Stroke();
+                        break;
+                    case Op.FillStyle:
+                        state.fillColor = GetColor(Arg(a), state.fillColor);
+                        break;
+                    case Op.StrokeStyle:
+                        state.strokeColor = GetColor(Arg(a), state.strokeColor);
+                        break;
+                    case Op.LineWidth:
+                        if (Arg(a) > 0)
+                            state.lineWidth = Arg(a);
+                        break;
+                    case Op.LineCap:
+                        // Painter2D has no square caps
+                        state.lineCap = (int)Arg(a) == 1 ? LineCap.Round : LineCap.Butt;
+                        break;
+                    case Op.LineJoin:
+                        state.lineJoin = (int)Arg(a) == 1 ? LineJoin.Round : (int)Arg(a) == 2 ? LineJoin.Bevel : LineJoin.Miter;
+                        break;
+                    case Op.MiterLimit:
+                        if (Arg(a) > 0)
+                            state.miterLimit = Arg(a);
+                        break;
+                    case Op.FillRect:
+                        // Like the other *Rect calls, this replaces the current path
+                        p.BeginPath();
+                        AddRect(p, state, Arg(a), Arg(a + 1), Arg(a + 2), Arg(a + 3));
+                        p.fillColor = state.WithAlpha(state.fillColor);
+                        p.Fill();
+                        p.BeginPath();
+                        hasPoint = false;
+                        break;
+                    case Op.StrokeRect:
+                        p.BeginPath();
+                        AddRect(p, state, Arg(a), Arg(a + 1), Arg(a + 2), Arg(a + 3));
+                        ApplyStroke(p, state);
+                        p.Stroke();
+                        p.BeginPath();
+                        hasPoint = false;
+                        break;
+                    case Op.ClearRect:
+                        break;
+                    case Op.Save:
+                        _stack.Push(state);
+                        break;
+                    case Op.Restore:
+                        if (_stack.Count > 0)
+                            state = _stack.Pop();
+                        break;
+                    case Op.Transform:
+                        state.transform = state.transform.Multiply(new Affine(Arg(a), Arg(a + 1), Arg(a + 2), Arg(a + 3),
+                            Arg(a + 4), Arg(a + 5)));
+                        break;
+                    case Op.SetTransform:
+                        state.transform = origin.Multiply(new Affine(Arg(a), Arg(a + 1), Arg(a + 2), Arg(a + 3),
+                            Arg(a + 4), Arg(a + 5)));
+                        break;
+                    case Op.GlobalAlpha:
+                        state.globalAlpha = Mathf.Clamp01(Arg(a));
+                        break;
+                }
+            }
+        }
+
+        float Arg(int index) {
+            return _commands[index];
+        }
+
+        static void LineTo(Painter2D p, Vector2 point, ref bool hasPoint) {
+            if (hasPoint)
+                p.LineTo(point);
+            else
+                p.MoveTo(point);
+            hasPoint = true;
+        }
+
+        static void AddRect(Painter2D p, State state, float x, float y, float w, float h) {
+            p.MoveTo(state.Apply(x, y));
+            p.LineTo(state.Apply(x + w, y));
+            p.LineTo(state.Apply(x + w, y + h));
+            p.LineTo(state.Apply(x, y + h));
+            p.ClosePath();
+        }
+
+        static void ApplyStroke(Painter2D p, State state) {
+            p.strokeColor = state.WithAlpha(state.strokeColor);
+            p.lineWidth = state.lineWidth * state.Scale;
+            p.lineCap = state.lineCap;
+            p.lineJoin = state.lineJoin;
+            p.miterLimit = state.miterLimit;
+        }
+
+        /// <summary>
+        /// arc() and ellipse(). Circles under a plain translate/scale/rotate go to Painter2D.Arc; anything else is
+        /// flattened into line segments.
+        /// </summary>
+        static void Ellipse(Painter2D p, State state, float x, float y, float rx, float ry, float rotation, float start,
+            float end, bool counterclockwise, ref bool hasPoint) {
+            if (rx < 0 || ry < 0)
+                return;
+            // Canvas sweep rules: a full turn or more draws a full circle, otherwise it's taken modulo one turn
+            var twoPi = Mathf.PI * 2;
+            float sweep;
+            if (!counterclockwise && end - start >= twoPi) {
+                sweep = twoPi;
+            } else if (counterclockwise && start - end >= twoPi) {
+                sweep = -twoPi;
+            } else {
+                sweep = end - start;
+                if (!counterclockwise) {
+                    sweep %= twoPi;
+                    if (sweep < 0) sweep += twoPi;
+                } else {
+                    sweep = -((start - end) % twoPi);
+                    if (sweep > 0) sweep -= twoPi;
+                }
+            }
+
+            var t = state.transform;
+            if (Mathf.Approximately(rx, ry) && t.IsSimilarity) {
+                var center = t.Apply(x, y);
+                var angle = t.Rotation + rotation;
+                var from = start + angle;
+                var to = from + sweep;
+                // Painter2D.Arc connects from the current point, like canvas does
+                if (!hasPoint)
+                    p.MoveTo(center + new Vector2(Mathf.Cos(from), Mathf.Sin(from)) * rx * t.Scale);
+                p.Arc(center, rx * t.Scale, Angle.Radians(from), Angle.Radians(to),
+                    sweep < 0 ? ArcDirection.CounterClockwise : ArcDirection.Clockwise);
+                hasPoint = true;
+                return;
+            }
+            var segments = Mathf.Clamp(Mathf.CeilToInt(Mathf.Abs(sweep) * Mathf.Max(rx, ry) * t.Scale / 4f), 4, 256);
+            var cos = Mathf.Cos(rotation);
+            var sin = Mathf.Sin(rotation);
+            for (int i = 0; i <= segments; i++) {
+                var a = start + sweep * i / segments;
+                var ex = Mathf.Cos(a) * rx;
+                var ey = Mathf.Sin(a) * ry;
+                LineTo(p, t.Apply(x + ex * cos - ey * sin, y + ex * sin + ey * cos), ref hasPoint);
+            }
+        }
+
+        Color GetColor(float index, Color fallback) {
+            var i = (int)index;
+            if (i < 0 || i >= _stringTable.Length)
+                return fallback;
+            var s = _stringTable[i];
+            if (_colorCache.TryGetValue(s, out var color))
+                return color;
+            if (!CssGradient.TryParseColor(s, out color))
+                return fallback;
+            if (_colorCache.Count > 1024)
+                _colorCache.Clear();
+            _colorCache[s] = color;
+            return color;
+        }
+
+        static bool Covers(float x, float y, float w, float h, Rect rect) {
+            return x <= rect.xMin && y <= rect.yMin && x + w >= rect.xMax && y + h >= rect.yMax;
+        }
+
+        /// <summary>
+        /// Number of float arguments after the op, or -1 for an unknown op.
+        /// </summary>
+        static int ArgCount(Op op) {
+            switch (op) {
+                case Op.BeginPath:
+                case Op.ClosePath:
+                case Op.Stroke:
+                case Op.Save:
+                case Op.Restore:
+                    return 0;
+                case Op.Fill:
+                case Op.FillStyle:
+                case Op.StrokeStyle:
+                case Op.LineWidth:
+                case Op.LineCap:
+                case Op.LineJoin:
+                case Op.MiterLimit:
+                case Op.GlobalAlpha:
+                    return 1;
+                case Op.MoveTo:
+                case Op.LineTo:
+                    return 2;
+                case Op.QuadraticCurveTo:
+                case Op.Rect:
+                case Op.FillRect:
+                case Op.StrokeRect:
+                case Op.ClearRect:
+                    return 4;
+                case Op.ArcTo:
+                    return 5;
+                case Op.BezierCurveTo:
+                case Op.Arc:
+                case Op.Transform:
+                case Op.SetTransform:
+                    return 6;
+                case Op.Ellipse:
+                    return 8;
+                default:
+                    return -1;
+            }
+        }
+
+        struct State {
+            public static State Default => new State {
+                fillColor = Color.black,
+                strokeColor = Color.black,
+                lineWidth = 1,
+                lineCap = LineCap.Butt,
+                lineJoin = LineJoin.Miter,
+                miterLimit = 10,
+                globalAlpha = 1,
+                transform = Affine.Identity
+            };
+
+            public Color fillColor;
+            public Color strokeColor;
+            public float lineWidth;
+            public LineCap lineCap;
+            public LineJoin lineJoin;
+            public float miterLimit;
+            public float globalAlpha;
+            public Affine transform;
+
+            public float Scale => transform.Scale;
+
+            public Vector2 Apply(float x, float y) => transform.Apply(x, y);
+
+            public Color WithAlpha(Color color) {
+                color.a *= globalAlpha;
+                return color;
+            }
+        }
+
+        /// <summary>
+        /// A canvas transform: x' = a*x + c*y + e, y' = b*x + d*y + f.
+        /// </summary>
+        struct Affine {
+            public static readonly Affine Identity = new Affine(1, 0, 0, 1, 0, 0);
+
+            public float a, b, c, d, e, f;
+
+            public Affine(float a, float b, float c, float d, float e, float f) {
+                this.a = a;
+                this.b = b;
+                this.c = c;
+                this.d = d;
+                this.e = e;
+                this.f = f;
+            }
+
+            /// <summary>
+            /// Average scale, for line widths and radii
+            /// </summary>
+            public float Scale => Mathf.Sqrt(Mathf.Abs(a * d - b * c));
+            public float Rotation => Mathf.Atan2(b, a);
+            /// <summary>
+            /// Only rotates, uniformly scales and translates (so circles stay circles)
+            /// </summary>
+            public bool IsSimilarity => Mathf.Abs(a - d) < 0.0001f && Mathf.Abs(b + c) < 0.0001f;
+
+            public Vector2 Apply(float x, float y) {
+                return new Vector2(a * x + c * y + e, b * x + d * y + f);
+            }
+
+            /// <summary>
+            /// This transform applied after `other` (canvas' transform() semantics).
+            /// </summary>
+            public Affine Multiply(Affine other) {
+                return new Affine(
+                    a * other.a + c * other.b,
+                    b * other.a + d * other.b,
+                    a * other.c + c * other.d,
+                    b * other.c + d * other.d,
+                    a * other.e + c * other.f + e,
+                    b * other.e + d * other.f + f);
+            }
+        }
+    }
+}
@@ -0,0 +1,352 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using OneJS.Utils;
+using Puerts;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Line/area chart for large, streaming series. Values come in as whole Float32Arrays (one call per update):
+    ///
+    ///     chart.setSeries(0, new Float32Array(values).buffer)
+    ///     chart.setSeriesStyle(0, "#4af", 2, "rgba(68, 170, 255, 0.2)")
+    ///     chart.append(0, new Float32Array(latest).buffer) // streaming, keeps the last `window` points
+    ///
+    /// Meshes are built by ChartMeshJob (Burst), decimated to the element's pixel width, at most once per repaint
+    /// however many updates came in; repaints without changes reuse the last mesh.
+    /// </summary>
+    public class Chart : VisualElement {
+        /// <summary>
+        /// How many points span the width (and how many each series keeps). 0 fits the longest series.
+        /// </summary>
+        public int window {
+            get => _window;
+            set {
+                value = Math.Max(value, 0);
+                if (value == _window)
+                    return;
+                _window = value;
+                if (value > 0) {
+                    foreach (var series in _series)
+                        series?.Trim(value);
+                }
+                Invalidate();
+            }
+        }
+
+        /// <summary>
+        /// Bottom of the y axis; NaN to fit the data.
+        /// </summary>
+        public float yMin {
+            get => _yMin;
+            set {
+                if (value.Equals(_yMin))
+                    return;
+                _yMin = value;
+                Invalidate();
+            }
+        }
+
+        /// <summary>
+        /// Top of the y axis; NaN to fit the data.
+        /// </summary>
+        public float yMax {
+            get => _yMax;
+            set {
+                if (value.Equals(_yMax))
+                    return;
+                _yMax = value;
+                Invalidate();
+            }
+        }
+
+        /// <summary>
+        /// The y range of the last build, with auto ends resolved (i.e. for axis labels).
+        /// </summary>
+        public Vector2 range => _range;
+
+        public int seriesCount => _series.Count;
+
+        int _window;
+        float _yMin = float.NaN;
+        float _yMax = float.NaN;
+        Vector2 _range = new Vector2(0, 1);
+        readonly List<Series> _series = new List<Series>();
+
+        // Last build
+        bool _dirty = true;
+        Rect _builtRect;
+        readonly List<(Vertex[] vertices, ushort[] indices)> _meshes = new List<(Vertex[], ushort[])>();
+
+        public Chart() {
+            generateVisualContent = OnGenerateVisualContent;
+        }
+
+        /// <summary>
+        /// Replaces a series' values (float32s). Creates the series if needed.
+        /// </summary>
+        public void setSeries(int index, ArrayBuffer values) {
+            var series = GetSeries(index);
+            series.Clear();
+            series.Append(values, _window);
+            Invalidate();
+        }
+
+        /// <summary>
+        /// Adds values (float32s) to the end of a series, dropping its oldest ones beyond `window`.
+        /// </summary>
+        public void append(int index, ArrayBuffer values) {
+            GetSeries(index).Append(values, _window);
+            Invalidate();
+        }
+
+        /// <param name="color">Line color (CSS)</param>
+        /// <param name="lineWidth">0 for no line</param>
+        /// <param name="fill">Color (CSS) of the area under the line, null for none</param>
+        public void setSeriesStyle(int index, string color, float lineWidth = 2, string fill = null) {
+            var series = GetSeries(index);
+            series.lineColor = ParseColor(color, Color.black);
+            series.fillColor = ParseColor(fill, Color.clear);
+            series.lineWidth = Mathf.Max(lineWidth, 0);
+            Invalidate();
+        }
+
+        public void removeSeries(int index) {
+            if (index < 0 || index >= _series.Count)
+                return;
+            _series[index] = null;
+            while (_series.Count > 0 && _series[_series.Count - 1] == null)
+                _series.RemoveAt(_series.Count - 1);
+            Invalidate();
+        }
+
+        public void clear() {
+            _series.Clear();
+            Invalidate();
+        }
+
+        Series GetSeries(int index) {
+            if (index < 0)
+                throw new ArgumentOutOfRangeException(nameof(index));
+            while (_series.Count <= index)
+                _series.Add(null);
+            return _series[index] ??= new Series();
+        }
+
+        void Invalidate() {
+            _dirty = true;
+            MarkDirtyRepaint();
+        }
+
+        void OnGenerateVisualContent(MeshGenerationContext mgc) {
+            var rect = contentRect;
+            if (rect.width < 1 || rect.height < 1)
+                return;
+            if (_dirty || rect != _builtRect) {
+                Build(rect);
+                _dirty = false;
+                _builtRect = rect;
+            }
+            foreach (var (vertices, indices) in _meshes) {
+                var mwd = mgc.Allocate(vertices.Length, indices.Length);
+                mwd.SetAllVertices(vertices);
+                mwd.SetAllIndices(indices);
+            }
+        }
+
+        void Build(Rect rect) {
+            var columns = Mathf.Clamp(Mathf.CeilToInt(rect.width), 1, ChartMeshJob.MaxColumns);
+            var domain = _window;
+            var totalValues = 0;
+            var totalPoints = 0;
+            var totalVertices = 0;
+            var totalIndices = 0;
+            foreach (var series in _series) {
+                if (series == null)
+                    continue;
+                domain = _window > 0 ? domain : Math.Max(domain, series.count);
+                totalValues += series.count;
+                totalPoints += ChartMeshJob.MaxPoints(series.count, columns);
+                var capacity = ChartMeshJob.Capacity(series.count, columns);
+                totalVertices += capacity.x;
+                totalIndices += capacity.y;
+            }
+
+            var values = new NativeArray<float>(totalValues, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            var infos = new NativeArray<ChartSeriesInfo>(_series.Count, Allocator.TempJob);
+            var points = new NativeArray<float2>(totalPoints, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            var vertices = new NativeArray<Vertex>(totalVertices, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            var indices = new NativeArray<ushort>(totalIndices, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            var chunks = new NativeArray<int4>(_series.Count * 2, Allocator.TempJob);
+            var range = new NativeArray<float2>(1, Allocator.TempJob);
+            try {
+                var offset = 0;
+                var vertexStart = 0;
+                var indexStart = 0;
+                for (int i = 0; i < _series.Count; i++) {
+                    var series = _series[i];
+                    if (series == null)
+                        continue;
+                    series.CopyTo(values, offset);
+                    infos[i] = new ChartSeriesInfo {
+                        offset = offset,
+                        count = series.count,
+                        lineColor = ToFloat4(series.lineColor),
+                        fillColor = ToFloat4(series.fillColor),
+                        lineWidth = series.lineWidth,
+                        vertexStart = vertexStart,
+                        indexStart = indexStart
+                    };
+                    offset += series.count;
+                    var capacity = ChartMeshJob.Capacity(series.count, columns);
+                    vertexStart += capacity.x;
+                    indexStart += capacity.y;
+                }
+
+                new ChartMeshJob {
+                    values = values,
+                    series = infos,
+                    points = points,
+                    vertices = vertices,
+                    indices = indices,
+                    chunks = chunks,
+                    range = range,
+                    origin = new float2(rect.x, rect.y),
+                    width = rect.width,
+                    height = rect.height,
+                    columns = columns,
+                    domain = domain,
+                    yMin = _yMin,
+                    yMax = _yMax,
+                    nearZ = Vertex.nearZ
+                }.Run();
+
+                // Reuse the previous arrays where the sizes match (i.e. a full window streaming in)
+                var previous = _meshes.ToArray();
+                _meshes.Clear();
+                foreach (var chunk in chunks) {
+                    if (chunk.y == 0)
+                        continue;
+                    var slot = _meshes.Count;
+                    var mesh = slot < previous.Length && previous[slot].vertices.Length == chunk.y &&
+                               previous[slot].indices.Length == chunk.w
+                        ? previous[slot]
+                        : (new Vertex[chunk.y], new ushort[chunk.w]);
+                    NativeArray<Vertex>.Copy(vertices, chunk.x, mesh.vertices, 0, chunk.y);
+                    NativeArray<ushort>.Copy(indices, chunk.z, mesh.indices, 0, chunk.w);
+                    _meshes.Add(mesh);
+                }
+                _range = new Vector2(range[0].x, range[0].y);
+            } finally {
+                values.Dispose();
+                infos.Dispose();
+                points.Dispose();
+                vertices.Dispose();
+                indices.Dispose();
+                chunks.Dispose();
+                range.Dispose();
+            }
+        }
+
+        static Color ParseColor(string s, Color fallback) {
+            if (string.IsNullOrEmpty(s))
+                return fallback;
+            if (CssGradient.TryParseColor(s, out var color))
+                return color;
+            Debug.LogWarning($"Chart: invalid color {s}");
+            return fallback;
+        }
+
+        static float4 ToFloat4(Color c) {
+            return new float4(c.r, c.g, c.b, c.a);
+        }
+
+        /// <summary>
+        /// A series' values as a ring buffer, so appending to a full window doesn't shift everything.
+        /// </summary>
+        class Series {
+            public Color lineColor = Color.black;
+            public Color fillColor = Color.clear;
+            public float lineWidth = 2;
+
+            public int count => _count;
+
+            float[] _values = Array.Empty<float>();
+            int _start;
+            int _count;
+
+            public void Clear() {
+                _start = 0;
+                _count = 0;
+            }
+
+            public void Append(ArrayBuffer buffer, int window) {
+                var bytes = buffer?.Bytes;
+                var added = bytes != null ? buffer.Count / 4 : 0;
+                if (added == 0)
+                    return;
+                var skip = 0;
+                if (window > 0 && added > window) {
+                    // Only the newest `window` of these would survive anyway
+                    skip = added - window;
+                    added = window;
+                }
+                var needed = window > 0 ? Math.Min(_count + added, window) : _count + added;
+                if (needed > _values.Length)
+                    Grow(window > 0 ? window : Math.Max(needed, _values.Length * 2));
+                // Drop the oldest to make room
+                var overflow = _count + added - _values.Length;
+                if (overflow > 0) {
+                    _start = (_start + overflow) % _values.Length;
+                    _count -= overflow;
+                }
+                var floats = MemoryMarshal.Cast<byte, float>(new ReadOnlySpan<byte>(bytes, skip * 4, added * 4));
+                var end = (_start + _count) % _values.Length;
+                var first = Math.Min(added, _values.Length - end);
+                floats.Slice(0, first).CopyTo(new Span<float>(_values, end, first));
+                floats.Slice(first).CopyTo(new Span<float>(_values, 0, added - first));
+                _count += added;
+            }
+
+            /// <summary>
+            /// Keeps only the newest `window` values.
+            /// </summary>
+            public void Trim(int window) {
+                if (_count > window) {
+                    _start = (_start + _count - window) % _values.Length;
+                    _count = window;
+                }
+                if (_values.Length != window)
+                    Grow(window);
+            }
+
+            public void CopyTo(NativeArray<float> destination, int offset) {
+                if (_count == 0)
+                    return;
+                var first = Math.Min(_count, _values.Length - _start);
+                NativeArray<float>.Copy(_values, _start, destination, offset, first);
+                if (first < _count)
+                    NativeArray<float>.Copy(_values, 0, destination, offset + first, _count - first);
+            }
+
+            /// <summary>
+            /// Reallocates to `capacity` (at least the current count), unwrapping the ring.
+            /// </summary>
+            void Grow(int capacity) {
+                var values = new float[Math.Max(capacity, _count)];
+                var first = Math.Min(_count, _values.Length - _start);
+                if (_count > 0) {
+                    Array.Copy(_values, _start, values, 0, first);
+                    Array.Copy(_values, 0, values, first, _count - first);
+                }
+                _values = values;
+                _start = 0;
+            }
+        }
+    }
+}
@@ -1,6 +1,4 @@
 ﻿using System;
-using System.Collections;
-using OneJS.Utils;
 using UnityEngine;
 using UnityEngine.UIElements;
 using Random = UnityEngine.Random;
@@ -60,34 +58,59 @@ namespace OneJS.Dom {
         int _cellWidth;
         int _cellHeight;
         int _index;
-
-        IEnumerator _currentCo;
+        float _elapsed;
 
         public Flipbook() {
+            RegisterCallback<AttachToPanelEvent>(OnAttachToPanel);
+            RegisterCallback<DetachFromPanelEvent>(OnDetachFromPanel);
+        }
+
+        void OnAttachToPanel(AttachToPanelEvent evt) {
+            if (_texture != null)
+                FlipbookTicker.Register(this);
+        }
+
+        void OnDetachFromPanel(DetachFromPanelEvent evt) {
+            FlipbookTicker.Unregister(this);
         }
 
         void Reset() {
             if (_texture == null)
                 return;
             _index = 0;
+            _elapsed = 0;
             _cellWidth = _texture.width / _numPerRow;
             _cellHeight = _texture.height / Math.Max(1, _count / _numPerRow);
-            if (_currentCo != null)
-                CoroutineUtil.Stop(_currentCo);
-            Animate();
+            ShowFrame(true);
+            if (panel != null)
+                FlipbookTicker.Register(this);
+        }
+
+        /// <summary>
+        /// Called by FlipbookTicker every frame the Flipbook is shown. Frames are skipped if a frame took longer
+        /// than the interval, so the animation's speed doesn't depend on the frame rate.
+        /// </summary>
+        internal void Advance(float deltaTime) {
+            if (_count <= 1 || _interval <= 0)
+                return;
+            _elapsed += deltaTime;
+            if (_elapsed < _interval)
+                return;
+            var steps = (int)(_elapsed / _interval);
+            _elapsed -= steps * _interval;
+            var wrapped = _index + steps >= _count;
+            _index = (_index + steps) % _count;
+            ShowFrame(wrapped);
         }
 
-        void Animate() {
+        void ShowFrame(bool newCycle) {
             this.sourceRect = new Rect((_index % _numPerRow) * _cellWidth,
                 (_index / _numPerRow) * _cellHeight,
                 _cellWidth, _cellHeight);
-            if (_randomRotation && _index == 0) {
+            if (_randomRotation && newCycle) {
                 this.style.rotate = new StyleRotate(new Rotate(new Angle(Random.Range(0, 360f))));
             }
             this.MarkDirtyRepaint();
-            _index = _index == _count - 1 ? 0 : _index + 1;
-            _currentCo = CoroutineUtil.DelaySeconds(Animate, _interval);
-            CoroutineUtil.Start(_currentCo);
         }
     }
 }
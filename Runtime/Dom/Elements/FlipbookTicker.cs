@@ -0,0 +1,68 @@
+﻿using System.Collections;
+using System.Collections.Generic;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Advances every animating Flipbook from one coroutine, once per frame, so animations cost no per-frame
+    /// allocations regardless of how many there are. Flipbooks are registered while they're attached to a panel;
+    /// the coroutine stops when there are none left.
+    /// </summary>
+    public static class FlipbookTicker {
+        static readonly List<Flipbook> _flipbooks = new List<Flipbook>();
+        static Coroutine _coroutine;
+
+        public static int Count => _flipbooks.Count;
+
+        [RuntimeInitializeOnLoadMethod(RuntimeInitializeLoadType.SubsystemRegistration)]
+        static void Init() {
+            _flipbooks.Clear();
+            _coroutine = null;
+        }
+
+        public static void Register(Flipbook flipbook) {
+            if (_flipbooks.Contains(flipbook))
+                return;
+            _flipbooks.Add(flipbook);
+            if (_coroutine == null && Application.isPlaying)
+                _coroutine = StaticCoroutine.Start(Run());
+        }
+
+        public static void Unregister(Flipbook flipbook) {
+            _flipbooks.Remove(flipbook);
+        }
+
+        static IEnumerator Run() {
+            while (_flipbooks.Count > 0) {
+                Tick(Time.deltaTime);
+                yield return null;
+            }
+            _coroutine = null;
+        }
+
+        static void Tick(float deltaTime) {
+            // Backwards, in case a Flipbook gets detached along the way
+            for (int i = _flipbooks.Count - 1; i >= 0; i--) {
+                if (i >= _flipbooks.Count)
+                    continue;
+                var flipbook = _flipbooks[i];
+                if (IsShown(flipbook))
+                    flipbook.Advance(deltaTime);
+            }
+        }
+
+        /// <summary>
+        /// Hidden Flipbooks (display: none on it or an ancestor, or visibility: hidden) are paused.
+        /// </summary>
+        static bool IsShown(VisualElement element) {
+            if (element.resolvedStyle.visibility == Visibility.Hidden)
+                return false;
+            for (var ve = element; ve != null; ve = ve.hierarchy.parent) {
+                if (ve.resolvedStyle.display == DisplayStyle.None)
+                    return false;
+            }
+            return true;
+        }
+    }
+}
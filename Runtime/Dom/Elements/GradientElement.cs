@@ -0,0 +1,50 @@
+﻿using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Fills its content rect with a CSS gradient (see CssGradient), i.e.
+    /// &lt;gradient-element gradient="linear-gradient(45deg, red, blue 60%, transparent)" /&gt;.
+    /// Any number of stops, clipped to rounded corners; the mesh is only rebuilt when the size or the gradient
+    /// changes.
+    /// </summary>
+    public class GradientElement : VisualElement {
+        /// <summary>
+        /// A gradient string or a CssGradient. Anything else clears it.
+        /// </summary>
+        public object gradient {
+            get => _gradient;
+            set {
+                CssGradient parsed = null;
+                if (value is CssGradient g) {
+                    parsed = g;
+                } else if (value is string s) {
+                    if (_gradient != null && _gradient.source == s)
+                        return;
+                    if (!CssGradient.TryParse(s, out parsed))
+                        Debug.LogWarning($"Invalid gradient: {s}");
+                }
+                if (parsed == _gradient)
+                    return;
+                _gradient = parsed;
+                MarkDirtyRepaint();
+            }
+        }
+
+        CssGradient _gradient;
+        readonly GradientMesh _mesh = new GradientMesh();
+
+        public GradientElement() {
+            generateVisualContent = GenerateVisualContent;
+        }
+
+        void GenerateVisualContent(MeshGenerationContext mgc) {
+            // Rounded corners (border-radius) that reach into the content rect round it too
+            var style = resolvedStyle;
+            var radii = CornerRadii.FromStyle(style, layout.size).Inset(style.borderLeftWidth + style.paddingLeft,
+                style.borderTopWidth + style.paddingTop, style.borderRightWidth + style.paddingRight,
+                style.borderBottomWidth + style.paddingBottom);
+            _mesh.Draw(mgc, contentRect, radii, _gradient);
+        }
+    }
+}
@@ -6,31 +6,135 @@ namespace OneJS.Dom {
     public class Img : Image {
         public string Src { get { return _src; } set { SetSrc(value); } }
 
+        /// <summary>
+        /// "eager" (default) or "lazy". Lazy images only start loading once they get near the viewport (see
+        /// ImageLoadScheduler). Either way, loads are queued and started closest to the viewport first.
+        /// </summary>
+        public string Loading { get { return _lazy ? "lazy" : "eager"; } set { SetLoading(value); } }
+
         IDocument _document;
         string _src;
+        bool _lazy;
 
-        Coroutine _imageCoroutine;
+        ImageLoadRequest _request;
+        bool _loadOnAttach;
+        TextureLease _lease;
+        /// <summary>
+        /// Size bucket the current SVG was requested at (see SvgLoader.SizeBucket)
+        /// </summary>
+        int _svgSize = -1;
 
         public Img() {
+            RegisterCallback<AttachToPanelEvent>(OnAttach);
+            RegisterCallback<DetachFromPanelEvent>(OnDetach);
+            RegisterCallback<GeometryChangedEvent>(OnGeometryChanged);
         }
 
         public void SetSrc(string src) {
             _src = src;
+            _loadOnAttach = false;
+            _request?.Cancel();
+            _request = null;
+            _svgSize = -1;
             if (string.IsNullOrEmpty(src)) {
-                this.image = null;
+                SetBackground(default);
+                return;
+            }
+            // Already loaded: show it right away, so re-rendering with a cached src doesn't flicker
+            if (!SvgLoader.IsSvg(src) && !IsRemoteUrl(src) && _document.tryGetCachedBackground(src, out var cached)) {
+                SetBackground(cached);
+                return;
+            }
+            var scheduler = _document.imageLoadScheduler;
+            if (scheduler == null) {
+                Load(src, null);
+                return;
+            }
+            _request = scheduler.Schedule(this, _lazy, request => Load(src, request));
+        }
+
+        public void SetLoading(string loading) {
+            _lazy = loading == "lazy";
+            // Attributes can come in any order, so this still applies to a load queued by SetSrc
+            if (_request != null && _request.state == ImageLoadRequest.State.Queued)
+                _request.lazy = _lazy;
+        }
+
+        /// <param name="request">Null if loads aren't scheduled (i.e. in editor documents)</param>
+        void Load(string src, ImageLoadRequest request) {
+            if (SvgLoader.IsSvg(src) && !IsRemoteUrl(src)) {
+                LoadSvg(src, request);
                 return;
             }
             if (IsRemoteUrl(src)) {
-                StaticCoroutine.Stop(_imageCoroutine);
-                _imageCoroutine = _document.loadRemoteImage(src, (texture) => {
-                    this.image = texture;
-                    _imageCoroutine = null;
-                });
+                Action<Texture2D> callback = (texture) => {
+                    request?.Complete();
+                    if (_src == src && texture != null)
+                        SetBackground(Background.FromTexture2D(texture));
+                };
+                if (request != null)
+                    request.onCancel = () => _document.cancelRemoteImage(src, callback);
+                _document.loadRemoteImage(src, callback);
                 return;
             }
-            this.image = _document.loadImage(src);
+            // Cached images come back right away; anything else is read and decoded off the main thread
+            _document.loadBackgroundAsync(src, (background) => {
+                request?.Complete();
+                if (_src == src && request?.isCancelled != true)
+                    SetBackground(background);
+            });
+        }
+
+        /// <summary>
+        /// SVGs are tessellated for the size they're shown at in screen pixels (panel scale included), so crisp at
+        /// any size or DPI. currentColor is this element's color at that point.
+        /// </summary>
+        void LoadSvg(string src, ImageLoadRequest request) {
+            _svgSize = SvgLoader.SizeBucket(SvgLoader.DisplaySize(this));
+            _document.loadVectorImageAsync(src, _svgSize, (vectorImage) => {
+                request?.Complete();
+                if (_src == src && request?.isCancelled != true && vectorImage != null)
+                    SetBackground(Background.FromVectorImage(vectorImage));
+            }, resolvedStyle.color);
         }
-        
+
+        void OnGeometryChanged(GeometryChangedEvent evt) {
+            // Re-tessellates once resized into another size bucket (the current image stays up meanwhile)
+            if (_svgSize < 0 || (_request != null && _request.state != ImageLoadRequest.State.Done))
+                return;
+            if (SvgLoader.SizeBucket(SvgLoader.DisplaySize(this)) != _svgSize)
+                LoadSvg(_src, null);
+        }
+
+        void OnAttach(AttachToPanelEvent evt) {
+            if (_loadOnAttach)
+                SetSrc(_src);
+        }
+
+        void OnDetach(DetachFromPanelEvent evt) {
+            // Removed elements don't hold up (or take a slot from) the ones still shown
+            if (_request == null || _request.state == ImageLoadRequest.State.Done)
+                return;
+            _request.Cancel();
+            _request = null;
+            _loadOnAttach = true;
+        }
+
+        /// <summary>
+        /// Displays a texture from the document's TextureCache (or a sprite from its ImageAtlas, or an SVG), keeping it
+        /// retained while this element is shown.
+        /// </summary>
+        void SetBackground(Background background) {
+            this.image = background.texture;
+            this.sprite = background.sprite;
+            this.vectorImage = background.vectorImage;
+            if (_lease == null && background.texture == null && background.sprite == null &&
+                background.vectorImage == null)
+                return;
+            _lease ??= new TextureLease(_document, this);
+            _lease.Set(background);
+        }
+
         static bool IsRemoteUrl(string path) {
             if (Uri.TryCreate(path, UriKind.Absolute, out Uri uriResult)) {
                 return uriResult.Scheme == Uri.UriSchemeHttp || uriResult.Scheme == Uri.UriSchemeHttps || uriResult.Scheme == Uri.UriSchemeFtp;
@@ -38,4 +142,4 @@ namespace OneJS.Dom {
             return false;
         }
     }
-}
\ No newline at end of file
+}
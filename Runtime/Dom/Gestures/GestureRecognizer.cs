@@ -0,0 +1,339 @@
+﻿using System;
+using System.Collections.Generic;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// What a gesture callback gets. Recognizers reuse a single instance, so read what you need in the callback
+    /// instead of keeping it around. Positions are in the target element's local space, in pixels.
+    /// </summary>
+    public class GestureEvent {
+        /// <summary>
+        /// "pan", "pinch", "swipe" or "longpress"
+        /// </summary>
+        public string type;
+        /// <summary>
+        /// Continuous gestures (pan, pinch, longpress): "began", "changed" (at most once per frame), then "ended" or
+        /// "cancelled". Swipes are just "recognized".
+        /// </summary>
+        public string state;
+        public float x;
+        public float y;
+        public float startX;
+        public float startY;
+        /// <summary>
+        /// Translation since the gesture started
+        /// </summary>
+        public float dx;
+        public float dy;
+        /// <summary>
+        /// Pixels per second
+        /// </summary>
+        public float vx;
+        public float vy;
+        /// <summary>
+        /// Pinch: distance between the fingers relative to when the gesture started
+        /// </summary>
+        public float scale = 1;
+        /// <summary>
+        /// Pinch: degrees, clockwise, since the gesture started
+        /// </summary>
+        public float rotation;
+        /// <summary>
+        /// Swipe: "left", "right", "up" or "down"
+        /// </summary>
+        public string direction;
+        public int pointerCount;
+        /// <summary>
+        /// Seconds since the first pointer went down
+        /// </summary>
+        public float duration;
+    }
+
+    /// <summary>
+    /// Options for Dom.addGesture. From JS, a plain object with any of these fields.
+    /// </summary>
+    public class GestureOptions {
+        /// <summary>
+        /// Pan: distance (px) before it begins. Pinch: scale change before it begins.
+        /// </summary>
+        public float threshold = float.NaN;
+        /// <summary>
+        /// Pan: "horizontal" or "vertical" to only begin on movement mostly along that axis. Swipe: "horizontal",
+        /// "vertical", "left", "right", "up" or "down" to only recognize those.
+        /// </summary>
+        public string direction;
+        /// <summary>
+        /// Pan: fewest and most pointers (fingers) that count
+        /// </summary>
+        public int minPointers = 1;
+        public int maxPointers = 10;
+        /// <summary>
+        /// Swipe: shortest distance (px), slowest speed (px/s) and longest time (s)
+        /// </summary>
+        public float minDistance = 30;
+        public float minVelocity = 300;
+        public float maxDuration = 0.5f;
+        /// <summary>
+        /// Long press: how long to hold (s), and how far (px) the pointer may wander meanwhile
+        /// </summary>
+        public float duration = 0.5f;
+        public float tolerance = 10;
+        /// <summary>
+        /// Whether to send "changed" at all (false: only began/ended)
+        /// </summary>
+        public bool changes = true;
+        /// <summary>
+        /// Capture the pointers once a continuous gesture begins, so it keeps tracking outside of the element
+        /// </summary>
+        public bool capture = true;
+        /// <summary>
+        /// Mouse button that starts the gesture (0 primary, 1 secondary, 2 middle), or -1 for any. Touches and pens
+        /// count as the primary button.
+        /// </summary>
+        public int button = 0;
+
+        public static GestureOptions From(object value) {
+            if (value is GestureOptions options)
+                return options;
+            options = new GestureOptions();
+            if (value is Puerts.JSObject js) {
+                options.threshold = Number(js, "threshold", options.threshold);
+                options.direction = js.Get<object>("direction") as string;
+                options.minPointers = (int)Number(js, "minPointers", options.minPointers);
+                options.maxPointers = (int)Number(js, "maxPointers", options.maxPointers);
+                options.minDistance = Number(js, "minDistance", options.minDistance);
+                options.minVelocity = Number(js, "minVelocity", options.minVelocity);
+                options.maxDuration = Number(js, "maxDuration", options.maxDuration);
+                options.duration = Number(js, "duration", options.duration);
+                options.tolerance = Number(js, "tolerance", options.tolerance);
+                options.changes = Flag(js, "changes", options.changes);
+                options.capture = Flag(js, "capture", options.capture);
+                options.button = (int)Number(js, "button", options.button);
+            }
+            return options;
+        }
+
+        static float Number(Puerts.JSObject js, string key, float fallback) {
+            var value = js.Get<object>(key);
+            return value is double d ? (float)d : value is int i ? i : value is float f ? f : fallback;
+        }
+
+        static bool Flag(Puerts.JSObject js, string key, bool fallback) {
+            return js.Get<object>(key) is bool b ? b : fallback;
+        }
+    }
+
+    /// <summary>
+    /// Recognizes a gesture from an element's raw pointer events, entirely on the C# side; the callback only runs
+    /// when the gesture's state changes (and "changed" at most once per frame, with the latest values), instead of
+    /// JS handling every PointerMoveEvent. See Dom.addGesture.
+    /// </summary>
+    public abstract class GestureRecognizer : IDisposable {
+        public readonly string type;
+        public readonly VisualElement target;
+        public bool enabled = true;
+
+        protected readonly GestureOptions options;
+        protected readonly GestureEvent evt = new GestureEvent();
+        /// <summary>
+        /// Pointers currently down on the target, in the order they went down
+        /// </summary>
+        protected readonly List<Pointer> pointers = new List<Pointer>();
+
+        readonly Action<GestureEvent> _callback;
+        IVisualElementScheduledItem _flush;
+        bool _changePending;
+        bool _disposed;
+
+        protected struct Pointer {
+            public int id;
+            public Vector2 start;
+            public Vector2 position;
+            public long startTime;
+        }
+
+        public static GestureRecognizer Create(string type, VisualElement target, GestureOptions options,
+            Action<GestureEvent> callback) {
+            switch (type?.ToLowerInvariant()) {
+                case "pan":
+                    return new PanGesture(target, options, callback);
+                case "pinch":
+                    return new PinchGesture(target, options, callback);
+                case "swipe":
+                    return new SwipeGesture(target, options, callback);
+                case "longpress":
+                case "long-press":
+                    return new LongPressGesture(target, options, callback);
+                default:
+                    throw new ArgumentException($"Unknown gesture: {type}");
+            }
+        }
+
+        protected GestureRecognizer(string type, VisualElement target, GestureOptions options,
+            Action<GestureEvent> callback) {
+            this.type = type;
+            this.target = target;
+            this.options = options ?? new GestureOptions();
+            _callback = callback;
+            evt.type = type;
+            target.RegisterCallback<PointerDownEvent>(OnPointerDown);
+            target.RegisterCallback<PointerMoveEvent>(OnPointerMove);
+            target.RegisterCallback<PointerUpEvent>(OnPointerUp);
+            target.RegisterCallback<PointerCancelEvent>(OnPointerCancel);
+            target.RegisterCallback<DetachFromPanelEvent>(OnDetach);
+        }
+
+        public void Dispose() {
+            if (_disposed)
+                return;
+            _disposed = true;
+            Cancel();
+            target.UnregisterCallback<PointerDownEvent>(OnPointerDown);
+            target.UnregisterCallback<PointerMoveEvent>(OnPointerMove);
+            target.UnregisterCallback<PointerUpEvent>(OnPointerUp);
+            target.UnregisterCallback<PointerCancelEvent>(OnPointerCancel);
+            target.UnregisterCallback<DetachFromPanelEvent>(OnDetach);
+            _flush?.Pause();
+        }
+
+        /// <summary>
+        /// Drops all pointers, cancelling the gesture if it's in progress.
+        /// </summary>
+        public void Cancel() {
+            for (int i = pointers.Count - 1; i >= 0; i--)
+                ReleasePointer(pointers[i].id);
+            pointers.Clear();
+            Reset(true);
+        }
+
+        #region Subclasses
+        protected abstract void PointerDown(Pointer pointer, long time);
+        protected abstract void PointerMove(Pointer pointer, long time);
+        /// <summary>
+        /// The pointer has already been removed from `pointers`.
+        /// </summary>
+        protected abstract void PointerUp(Pointer pointer, long time);
+
+        /// <summary>
+        /// Back to waiting for pointers. `cancel`: the gesture (if in progress) should end as "cancelled".
+        /// </summary>
+        protected abstract void Reset(bool cancel);
+
+        protected void Began() {
+            _changePending = false;
+            if (options.capture) {
+                foreach (var pointer in pointers)
+                    target.CapturePointer(pointer.id);
+            }
+            Dispatch("began");
+        }
+
+        /// <summary>
+        /// Coalesced: sent at most once per frame, with whatever `evt` holds then.
+        /// </summary>
+        protected void Changed() {
+            if (!options.changes || _changePending)
+                return;
+            _changePending = true;
+            _flush ??= target.schedule.Execute(FlushChange);
+            _flush.ExecuteLater(0);
+        }
+
+        protected void Ended(bool cancelled) {
+            // The final values go out with "ended", so a pending "changed" would be stale
+            _changePending = false;
+            foreach (var pointer in pointers)
+                ReleasePointer(pointer.id);
+            Dispatch(cancelled ? "cancelled" : "ended");
+        }
+
+        protected void Recognized() {
+            Dispatch("recognized");
+        }
+
+        protected void SetPosition(Vector2 position, Vector2 start, long time) {
+            evt.x = position.x;
+            evt.y = position.y;
+            evt.startX = start.x;
+            evt.startY = start.y;
+            evt.dx = position.x - start.x;
+            evt.dy = position.y - start.y;
+            evt.duration = pointers.Count > 0 ? (time - pointers[0].startTime) / 1000f : evt.duration;
+        }
+
+        protected Vector2 Centroid() {
+            var sum = Vector2.zero;
+            foreach (var pointer in pointers)
+                sum += pointer.position;
+            return pointers.Count > 0 ? sum / pointers.Count : sum;
+        }
+        #endregion
+
+        void Dispatch(string state) {
+            evt.state = state;
+            evt.pointerCount = pointers.Count;
+            _callback?.Invoke(evt);
+        }
+
+        void FlushChange() {
+            if (!_changePending)
+                return;
+            _changePending = false;
+            Dispatch("changed");
+        }
+
+        void ReleasePointer(int id) {
+            if (target.HasPointerCapture(id))
+                target.ReleasePointer(id);
+        }
+
+        int IndexOf(int id) {
+            for (int i = 0; i < pointers.Count; i++) {
+                if (pointers[i].id == id)
+                    return i;
+            }
+            return -1;
+        }
+
+        void OnPointerDown(PointerDownEvent e) {
+            if (!enabled || IndexOf(e.pointerId) >= 0 || (options.button >= 0 && e.button != options.button))
+                return;
+            var position = target.WorldToLocal(e.position);
+            var pointer = new Pointer { id = e.pointerId, start = position, position = position, startTime = e.timestamp };
+            pointers.Add(pointer);
+            PointerDown(pointer, e.timestamp);
+        }
+
+        void OnPointerMove(PointerMoveEvent e) {
+            var index = IndexOf(e.pointerId);
+            if (index < 0)
+                return;
+            var pointer = pointers[index];
+            pointer.position = target.WorldToLocal(e.position);
+            pointers[index] = pointer;
+            PointerMove(pointer, e.timestamp);
+        }
+
+        void OnPointerUp(PointerUpEvent e) {
+            var index = IndexOf(e.pointerId);
+            if (index < 0)
+                return;
+            var pointer = pointers[index];
+            pointer.position = target.WorldToLocal(e.position);
+            pointers.RemoveAt(index);
+            ReleasePointer(pointer.id);
+            PointerUp(pointer, e.timestamp);
+        }
+
+        void OnPointerCancel(PointerCancelEvent e) {
+            if (IndexOf(e.pointerId) >= 0)
+                Cancel();
+        }
+
+        void OnDetach(DetachFromPanelEvent e) {
+            Cancel();
+        }
+    }
+}
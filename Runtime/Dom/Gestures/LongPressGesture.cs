@@ -0,0 +1,75 @@
+﻿using System;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Hold a single pointer for options.duration seconds without it moving more than options.tolerance. Begins
+    /// when the time is up, then reports moves (i.e. dragging something picked up) until released.
+    /// </summary>
+    public class LongPressGesture : GestureRecognizer {
+        bool _active;
+        bool _waiting;
+        IVisualElementScheduledItem _timer;
+        long _startTime;
+
+        public LongPressGesture(VisualElement target, GestureOptions options, Action<GestureEvent> callback)
+            : base("longpress", target, options, callback) { }
+
+        protected override void PointerDown(Pointer pointer, long time) {
+            if (pointers.Count != 1) {
+                Reset(true);
+                return;
+            }
+            _waiting = true;
+            _startTime = time;
+            var delay = (long)(options.duration * 1000);
+            if (_timer == null)
+                _timer = target.schedule.Execute(Fire).StartingIn(delay);
+            else
+                _timer.ExecuteLater(delay);
+        }
+
+        protected override void PointerMove(Pointer pointer, long time) {
+            if (_waiting && (pointer.position - pointer.start).magnitude > options.tolerance) {
+                _waiting = false;
+                _timer?.Pause();
+                return;
+            }
+            if (!_active)
+                return;
+            SetPosition(pointer.position, pointer.start, time);
+            Changed();
+        }
+
+        protected override void PointerUp(Pointer pointer, long time) {
+            _waiting = false;
+            _timer?.Pause();
+            if (!_active)
+                return;
+            SetPosition(pointer.position, pointer.start, time);
+            evt.duration = (time - _startTime) / 1000f;
+            _active = false;
+            Ended(false);
+        }
+
+        protected override void Reset(bool cancel) {
+            _waiting = false;
+            _timer?.Pause();
+            if (_active) {
+                _active = false;
+                Ended(cancel);
+            }
+        }
+
+        void Fire() {
+            if (!_waiting || pointers.Count != 1)
+                return;
+            _waiting = false;
+            var pointer = pointers[0];
+            SetPosition(pointer.position, pointer.start, _startTime + (long)(options.duration * 1000));
+            _active = true;
+            Began();
+        }
+    }
+}
@@ -0,0 +1,109 @@
+﻿using System;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Drag with one or more pointers (options.minPointers to maxPointers). Begins once the centroid has moved
+    /// options.threshold (default 10px), optionally mostly along options.direction ("horizontal" or "vertical").
+    /// Fingers can be added or lifted mid-gesture without the translation jumping.
+    /// </summary>
+    public class PanGesture : GestureRecognizer {
+        const float DefaultThreshold = 10;
+        /// <summary>
+        /// Velocity smoothing time constant (s)
+        /// </summary>
+        const float VelocitySmoothing = 0.05f;
+
+        bool _active;
+        Vector2 _start;
+        long _startTime;
+        Vector2 _translation;
+        // Translation when the pointer set last changed, and the new set's centroid then
+        Vector2 _offset;
+        Vector2 _anchor;
+        long _lastTime;
+        Vector2 _velocity;
+
+        public PanGesture(VisualElement target, GestureOptions options, Action<GestureEvent> callback)
+            : base("pan", target, options, callback) { }
+
+        float threshold => float.IsNaN(options.threshold) ? DefaultThreshold : options.threshold;
+
+        protected override void PointerDown(Pointer pointer, long time) {
+            if (pointers.Count == 1) {
+                _start = pointer.position;
+                _startTime = time;
+                _translation = Vector2.zero;
+                _velocity = Vector2.zero;
+                _lastTime = time;
+            }
+            Rebase();
+            if (_active && pointers.Count > options.maxPointers)
+                Reset(true);
+        }
+
+        protected override void PointerMove(Pointer pointer, long time) {
+            if (pointers.Count < options.minPointers || pointers.Count > options.maxPointers)
+                return;
+            var translation = _offset + Centroid() - _anchor;
+            var dt = (time - _lastTime) / 1000f;
+            if (dt > 0) {
+                var t = 1 - Mathf.Exp(-dt / VelocitySmoothing);
+                _velocity = Vector2.Lerp(_velocity, (translation - _translation) / dt, t);
+                _lastTime = time;
+            }
+            _translation = translation;
+            SetPosition(_start + translation, _start, time);
+            evt.vx = _velocity.x;
+            evt.vy = _velocity.y;
+            if (_active) {
+                Changed();
+            } else if (translation.magnitude >= threshold && AlongDirection(translation)) {
+                _active = true;
+                Began();
+            }
+        }
+
+        protected override void PointerUp(Pointer pointer, long time) {
+            Rebase();
+            if (!_active || pointers.Count >= options.minPointers)
+                return;
+            // A pointer that stopped before lifting shouldn't fling
+            if ((time - _lastTime) / 1000f > VelocitySmoothing * 2)
+                _velocity = Vector2.zero;
+            SetPosition(_start + _translation, _start, time);
+            evt.vx = _velocity.x;
+            evt.vy = _velocity.y;
+            evt.duration = (time - _startTime) / 1000f;
+            _active = false;
+            Ended(false);
+        }
+
+        protected override void Reset(bool cancel) {
+            if (_active) {
+                _active = false;
+                Ended(cancel);
+            }
+        }
+
+        /// <summary>
+        /// Carries the translation so far over to the current pointer set, whose centroid is elsewhere.
+        /// </summary>
+        void Rebase() {
+            _offset = _translation;
+            _anchor = Centroid();
+        }
+
+        bool AlongDirection(Vector2 translation) {
+            switch (options.direction) {
+                case "horizontal":
+                    return Mathf.Abs(translation.x) >= Mathf.Abs(translation.y);
+                case "vertical":
+                    return Mathf.Abs(translation.y) >= Mathf.Abs(translation.x);
+                default:
+                    return true;
+            }
+        }
+    }
+}
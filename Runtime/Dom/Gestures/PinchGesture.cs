@@ -0,0 +1,105 @@
+﻿using System;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Two-finger pinch/rotate. Reports scale (finger distance relative to the start), rotation (degrees) and the
+    /// midpoint (x, y; dx, dy for its translation). Begins once the scale has changed by options.threshold
+    /// (default 0.05) or the fingers turned 5 degrees, ends when either lifts.
+    /// </summary>
+    public class PinchGesture : GestureRecognizer {
+        const float DefaultThreshold = 0.05f;
+        const float RotationThreshold = 5;
+        /// <summary>
+        /// Fingers closer than this (px) don't give a meaningful scale
+        /// </summary>
+        const float MinSpan = 1;
+
+        bool _active;
+        bool _tracking;
+        // The two fingers' ids (any later ones don't count)
+        int _a;
+        int _b;
+        Vector2 _startCenter;
+        float _startSpan;
+        float _startAngle;
+        long _startTime;
+
+        public PinchGesture(VisualElement target, GestureOptions options, Action<GestureEvent> callback)
+            : base("pinch", target, options, callback) { }
+
+        float threshold => float.IsNaN(options.threshold) ? DefaultThreshold : options.threshold;
+
+        protected override void PointerDown(Pointer pointer, long time) {
+            if (pointers.Count == 2)
+                Track(time);
+        }
+
+        protected override void PointerMove(Pointer pointer, long time) {
+            if (!_tracking || (pointer.id != _a && pointer.id != _b) || !TryGetSpan(out var a, out var b))
+                return;
+            var span = b - a;
+            var scale = Mathf.Max(span.magnitude, MinSpan) / _startSpan;
+            var rotation = Mathf.DeltaAngle(_startAngle, Mathf.Atan2(span.y, span.x) * Mathf.Rad2Deg);
+            SetPosition((a + b) * 0.5f, _startCenter, time);
+            evt.scale = scale;
+            evt.rotation = rotation;
+            evt.duration = (time - _startTime) / 1000f;
+            if (_active) {
+                Changed();
+            } else if (Mathf.Abs(scale - 1) >= threshold || Mathf.Abs(rotation) >= RotationThreshold) {
+                _active = true;
+                Began();
+            }
+        }
+
+        protected override void PointerUp(Pointer pointer, long time) {
+            if (pointer.id != _a && pointer.id != _b)
+                return;
+            _tracking = false;
+            if (_active) {
+                evt.duration = (time - _startTime) / 1000f;
+                _active = false;
+                Ended(false);
+            } else if (pointers.Count >= 2) {
+                // Not pinching yet, so start over with the two fingers that are left
+                Track(time);
+            }
+        }
+
+        protected override void Reset(bool cancel) {
+            _tracking = false;
+            if (_active) {
+                _active = false;
+                Ended(cancel);
+            }
+        }
+
+        void Track(long time) {
+            _a = pointers[0].id;
+            _b = pointers[1].id;
+            var span = pointers[1].position - pointers[0].position;
+            _tracking = span.magnitude >= MinSpan;
+            _startCenter = (pointers[0].position + pointers[1].position) * 0.5f;
+            _startSpan = span.magnitude;
+            _startAngle = Mathf.Atan2(span.y, span.x) * Mathf.Rad2Deg;
+            _startTime = time;
+        }
+
+        bool TryGetSpan(out Vector2 a, out Vector2 b) {
+            a = b = default;
+            var found = 0;
+            foreach (var pointer in pointers) {
+                if (pointer.id == _a) {
+                    a = pointer.position;
+                    found++;
+                } else if (pointer.id == _b) {
+                    b = pointer.position;
+                    found++;
+                }
+            }
+            return found == 2;
+        }
+    }
+}
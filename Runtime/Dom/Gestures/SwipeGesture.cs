@@ -0,0 +1,68 @@
+﻿using System;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// A quick single-pointer flick: on release, "recognized" with `direction` ("left", "right", "up" or "down") if
+    /// the pointer went at least options.minDistance, averaging options.minVelocity, within options.maxDuration.
+    /// options.direction limits it to an axis ("horizontal", "vertical") or a single direction.
+    /// </summary>
+    public class SwipeGesture : GestureRecognizer {
+        bool _tracking;
+
+        public SwipeGesture(VisualElement target, GestureOptions options, Action<GestureEvent> callback)
+            : base("swipe", target, options, callback) { }
+
+        protected override void PointerDown(Pointer pointer, long time) {
+            // More than one finger is something else
+            _tracking = pointers.Count == 1;
+        }
+
+        protected override void PointerMove(Pointer pointer, long time) {
+            if (_tracking && (time - pointer.startTime) / 1000f > options.maxDuration)
+                _tracking = false;
+        }
+
+        protected override void PointerUp(Pointer pointer, long time) {
+            if (!_tracking)
+                return;
+            _tracking = false;
+            var duration = Mathf.Max((time - pointer.startTime) / 1000f, 0.001f);
+            var delta = pointer.position - pointer.start;
+            var distance = delta.magnitude;
+            if (duration > options.maxDuration || distance < options.minDistance ||
+                distance / duration < options.minVelocity)
+                return;
+            var direction = Mathf.Abs(delta.x) >= Mathf.Abs(delta.y)
+                ? delta.x < 0 ? "left" : "right"
+                : delta.y < 0 ? "up" : "down";
+            if (!Allows(direction))
+                return;
+            SetPosition(pointer.position, pointer.start, time);
+            evt.vx = delta.x / duration;
+            evt.vy = delta.y / duration;
+            evt.duration = duration;
+            evt.direction = direction;
+            Recognized();
+        }
+
+        protected override void Reset(bool cancel) {
+            _tracking = false;
+        }
+
+        bool Allows(string direction) {
+            switch (options.direction) {
+                case null:
+                case "":
+                    return true;
+                case "horizontal":
+                    return direction == "left" || direction == "right";
+                case "vertical":
+                    return direction == "up" || direction == "down";
+                default:
+                    return options.direction == direction;
+            }
+        }
+    }
+}
@@ -0,0 +1,393 @@
+﻿using System;
+using System.Collections.Generic;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Tessellates a CssGradient into vertex-colored triangles for a MeshGenerationContext. Between two stops the
+    /// color is linear along the gradient, so each band between stops becomes a few polygons whose vertex colors the
+    /// GPU interpolates exactly (linear) or closely (radial, split into ring segments). Polygons are clipped to the
+    /// rect, with its corners rounded if radii are given. The mesh is cached and only rebuilt when the rect, the
+    /// radii or the gradient changes.
+    /// </summary>
+    public class GradientMesh {
+        const int MaxVertices = 60000;
+        const float RingSegmentLength = 6f;
+        const float CornerSegmentLength = 3f;
+
+        Rect _rect;
+        CornerRadii _radii;
+        CssGradient _gradient;
+        Vertex[] _vertices;
+        ushort[] _indices;
+
+        readonly List<Vertex> _vertexList = new List<Vertex>();
+        readonly List<ushort> _indexList = new List<ushort>();
+        readonly List<Vector2> _polygon = new List<Vector2>();
+        readonly List<Vector2> _clipped = new List<Vector2>();
+        readonly List<Vector2> _outline = new List<Vector2>();
+        readonly List<(float t, Color color)> _resolved = new List<(float, Color)>();
+
+        public int VertexCount => _vertices?.Length ?? 0;
+
+        public void Draw(MeshGenerationContext mgc, Rect rect, CssGradient gradient) {
+            Draw(mgc, rect, default, gradient);
+        }
+
+        /// <param name="radii">Corner radii within the rect (scaled down if they overlap, as in CSS)</param>
+        public void Draw(MeshGenerationContext mgc, Rect rect, CornerRadii radii, CssGradient gradient) {
+            if (gradient == null || rect.width < 0.1f || rect.height < 0.1f)
+                return;
+            if (_vertices == null || gradient != _gradient || rect != _rect || !radii.Equals(_radii)) {
+                _gradient = gradient;
+                _rect = rect;
+                _radii = radii;
+                Build();
+            }
+            if (_vertices.Length == 0)
+                return;
+            var mwd = mgc.Allocate(_vertices.Length, _indices.Length);
+            mwd.SetAllVertices(_vertices);
+            mwd.SetAllIndices(_indices);
+        }
+
+        public void Invalidate() {
+            _vertices = null;
+        }
+
+        void Build() {
+            _vertexList.Clear();
+            _indexList.Clear();
+            BuildOutline();
+            if (_gradient.kind == CssGradient.Kind.Linear)
+                BuildLinear();
+            else
+                BuildRadial();
+            _vertices = _vertexList.ToArray();
+            _indices = _indexList.ToArray();
+            _vertexList.Clear();
+            _indexList.Clear();
+        }
+
+        #region Linear
+        void BuildLinear() {
+            var rect = _rect;
+            var degrees = _gradient.ResolveAngle(rect);
+            var radians = degrees * Mathf.Deg2Rad;
+            var direction = new Vector2(Mathf.Sin(radians), -Mathf.Cos(radians)); // y points down
+            var length = Mathf.Abs(rect.width * direction.x) + Mathf.Abs(rect.height * direction.y);
+            var center = rect.center;
+            Func<Vector2, float> t = p => Vector2.Dot(p - center, direction) / length + 0.5f;
+
+            var tMin = float.MaxValue;
+            var tMax = float.MinValue;
+            foreach (var p in Corners(rect)) {
+                tMin = Mathf.Min(tMin, t(p));
+                tMax = Mathf.Max(tMax, t(p));
+            }
+            _gradient.ResolveStops(length, _resolved);
+            foreach (var (t0, c0, t1, c1) in Bands(tMin, tMax)) {
+                _polygon.Clear();
+                _polygon.AddRange(_outline);
+                Clip(_polygon, p => t(p) - Mathf.Max(t0, tMin));
+                Clip(_polygon, p => Mathf.Min(t1, tMax) - t(p));
+                if (!AddPolygon(_polygon, t, t0, c0, t1, c1))
+                    return;
+            }
+        }
+        #endregion
+
+        #region Radial
+        void BuildRadial() {
+            var rect = _rect;
+            var center = _gradient.ResolveCenter(rect);
+            var radii = _gradient.ResolveRadii(rect, center);
+            var rx = Mathf.Max(radii.x, 0.001f);
+            var ry = Mathf.Max(radii.y, 0.001f);
+            Func<Vector2, float> t = p => new Vector2((p.x - center.x) / rx, (p.y - center.y) / ry).magnitude;
+
+            var tMax = 0f;
+            foreach (var p in Corners(rect))
+                tMax = Mathf.Max(tMax, t(p));
+            _gradient.ResolveStops(rx, _resolved);
+            // The same segments for every ring, so neighboring rings share their edges
+            var segments = Mathf.Clamp(Mathf.CeilToInt(2 * Mathf.PI * Mathf.Max(rx, ry) * tMax / RingSegmentLength), 16, 128);
+            foreach (var (t0, c0, t1, c1) in Bands(0, tMax)) {
+                var inner = Mathf.Max(t0, 0);
+                var outer = Mathf.Min(t1, tMax);
+                for (int i = 0; i < segments; i++) {
+                    var a0 = 2 * Mathf.PI * i / segments;
+                    var a1 = 2 * Mathf.PI * (i + 1) / segments;
+                    var d0 = new Vector2(Mathf.Cos(a0) * rx, Mathf.Sin(a0) * ry);
+                    var d1 = new Vector2(Mathf.Cos(a1) * rx, Mathf.Sin(a1) * ry);
+                    // Segments are straight, so the outermost ring is pushed out to still reach the corners
+                    var reach = outer >= tMax ? outer / Mathf.Cos(Mathf.PI / segments) : outer;
+                    _polygon.Clear();
+                    _polygon.Add(center + d0 * inner);
+                    _polygon.Add(center + d0 * reach);
+                    _polygon.Add(center + d1 * reach);
+                    _polygon.Add(center + d1 * inner);
+                    ClipToOutline(_polygon);
+                    if (!AddPolygon(_polygon, t, t0, c0, t1, c1))
+                        return;
+                }
+            }
+        }
+        #endregion
+
+        #region Bands
+        /// <summary>
+        /// Bands (start, start color, end, end color) covering [tMin, tMax]. Solid bands extend the first and last
+        /// stops, unless the gradient repeats.
+        /// </summary>
+        IEnumerable<(float, Color, float, Color)> Bands(float tMin, float tMax) {
+            var first = _resolved[0];
+            var last = _resolved[_resolved.Count - 1];
+            var period = last.t - first.t;
+            if (!_gradient.repeating || period <= 0.0001f) {
+                if (tMin < first.t)
+                    yield return (float.MinValue, first.color, first.t, first.color);
+                for (int i = 0; i + 1 < _resolved.Count; i++) {
+                    var (t0, c0) = _resolved[i];
+                    var (t1, c1) = _resolved[i + 1];
+                    if (t1 > t0 && t1 > tMin && t0 < tMax)
+                        yield return (t0, c0, t1, c1);
+                }
+                if (tMax > last.t)
+                    yield return (last.t, last.color, float.MaxValue, last.color);
+                yield break;
+            }
+            var from = Mathf.FloorToInt((tMin - first.t) / period);
+            var to = Mathf.CeilToInt((tMax - first.t) / period);
+            // Very fine repeats (i.e. px stops in a huge rect) are capped; the vertex limit would cut them off anyway
+            to = Mathf.Min(to, from + 4096);
+            for (int k = from; k < to; k++) {
+                var offset = k * period;
+                for (int i = 0; i + 1 < _resolved.Count; i++) {
+                    var (t0, c0) = _resolved[i];
+                    var (t1, c1) = _resolved[i + 1];
+                    t0 += offset;
+                    t1 += offset;
+                    if (t1 > t0 && t1 > tMin && t0 < tMax)
+                        yield return (t0, c0, t1, c1);
+                }
+            }
+        }
+        #endregion
+
+        #region Geometry
+        /// <summary>
+        /// Adds a convex polygon as a triangle fan. Returns false once the vertex limit is reached.
+        /// </summary>
+        bool AddPolygon(List<Vector2> polygon, Func<Vector2, float> t, float t0, Color c0, float t1, Color c1) {
+            if (polygon.Count < 3)
+                return true;
+            if (_vertexList.Count + polygon.Count > MaxVertices)
+                return false;
+            // UI Toolkit wants clockwise triangles (positive area, since y points down)
+            var area = 0f;
+            for (int i = 0; i < polygon.Count; i++) {
+                var a = polygon[i];
+                var b = polygon[(i + 1) % polygon.Count];
+                area += a.x * b.y - b.x * a.y;
+            }
+            if (Mathf.Abs(area) < 0.0001f)
+                return true;
+            if (area < 0)
+                polygon.Reverse();
+            var span = t1 - t0;
+            var start = (ushort)_vertexList.Count;
+            foreach (var p in polygon) {
+                var color = c0 == c1 || span <= 0 ? c0 : Color.Lerp(c0, c1, (t(p) - t0) / span);
+                _vertexList.Add(new Vertex { position = new Vector3(p.x, p.y, Vertex.nearZ), tint = color });
+            }
+            for (int i = 1; i + 1 < polygon.Count; i++) {
+                _indexList.Add(start);
+                _indexList.Add((ushort)(start + i));
+                _indexList.Add((ushort)(start + i + 1));
+            }
+            return true;
+        }
+
+        /// <summary>
+        /// The rect, with its corners rounded into arcs of short segments: a convex polygon, clockwise.
+        /// </summary>
+        void BuildOutline() {
+            _outline.Clear();
+            var rect = _rect;
+            var radii = _radii.FitTo(rect.size);
+            AddCorner(new Vector2(rect.xMin, rect.yMin), radii.topLeft, 1, 1, Mathf.PI);
+            AddCorner(new Vector2(rect.xMax, rect.yMin), radii.topRight, -1, 1, Mathf.PI * 1.5f);
+            AddCorner(new Vector2(rect.xMax, rect.yMax), radii.bottomRight, -1, -1, 0);
+            AddCorner(new Vector2(rect.xMin, rect.yMax), radii.bottomLeft, 1, -1, Mathf.PI * 0.5f);
+        }
+
+        /// <param name="sx">Direction from the corner to the arc's center along x (1 or -1); sy along y</param>
+        /// <param name="startAngle">Where the quarter arc starts (y points down, so angles go clockwise)</param>
+        void AddCorner(Vector2 corner, Vector2 radius, int sx, int sy, float startAngle) {
+            if (radius.x <= 0 || radius.y <= 0) {
+                _outline.Add(corner);
+                return;
+            }
+            var center = corner + new Vector2(sx * radius.x, sy * radius.y);
+            var arcLength = Mathf.PI * 0.5f * Mathf.Max(radius.x, radius.y);
+            var segments = Mathf.Clamp(Mathf.CeilToInt(arcLength / CornerSegmentLength), 1, 16);
+            for (int i = 0; i <= segments; i++) {
+                var angle = startAngle + Mathf.PI * 0.5f * i / segments;
+                _outline.Add(center + new Vector2(Mathf.Cos(angle) * radius.x, Mathf.Sin(angle) * radius.y));
+            }
+        }
+
+        void ClipToOutline(List<Vector2> polygon) {
+            for (int i = 0; i < _outline.Count && polygon.Count > 0; i++) {
+                var a = _outline[i];
+                var edge = _outline[(i + 1) % _outline.Count] - a;
+                // Inside is to the right of each edge (clockwise, y down)
+                Clip(polygon, p => edge.x * (p.y - a.y) - edge.y * (p.x - a.x));
+            }
+        }
+
+        /// <summary>
+        /// Sutherland-Hodgman: keeps the part of the polygon where inside(p) >= 0.
+        /// </summary>
+        void Clip(List<Vector2> polygon, Func<Vector2, float> inside) {
+            if (polygon.Count == 0)
+                return;
+            _clipped.Clear();
+            for (int i = 0; i < polygon.Count; i++) {
+                var a = polygon[i];
+                var b = polygon[(i + 1) % polygon.Count];
+                var da = inside(a);
+                var db = inside(b);
+                if (da >= 0)
+                    _clipped.Add(a);
+                if ((da >= 0) != (db >= 0))
+                    _clipped.Add(Vector2.Lerp(a, b, da / (da - db)));
+            }
+            polygon.Clear();
+            polygon.AddRange(_clipped);
+        }
+
+        static Vector2[] Corners(Rect rect) {
+            return new[] {
+                new Vector2(rect.xMin, rect.yMin), new Vector2(rect.xMax, rect.yMin),
+                new Vector2(rect.xMax, rect.yMax), new Vector2(rect.xMin, rect.yMax)
+            };
+        }
+        #endregion
+    }
+
+    /// <summary>
+    /// Elliptical corner radii (x horizontal, y vertical), like CSS border-*-radius.
+    /// </summary>
+    public struct CornerRadii : IEquatable<CornerRadii> {
+        public Vector2 topLeft;
+        public Vector2 topRight;
+        public Vector2 bottomRight;
+        public Vector2 bottomLeft;
+
+        /// <summary>
+        /// An element's (circular) border radii, fitted to its border box.
+        /// </summary>
+        public static CornerRadii FromStyle(IResolvedStyle style, Vector2 size) {
+            return new CornerRadii {
+                topLeft = Vector2.one * style.borderTopLeftRadius, topRight = Vector2.one * style.borderTopRightRadius,
+                bottomRight = Vector2.one * style.borderBottomRightRadius,
+                bottomLeft = Vector2.one * style.borderBottomLeftRadius
+            }.FitTo(size);
+        }
+
+        /// <summary>
+        /// Scales all radii down by the same factor if adjacent ones would overlap in a box of the given size
+        /// (CSS Backgrounds 5.5).
+        /// </summary>
+        public CornerRadii FitTo(Vector2 size) {
+            var f = 1f;
+            f = Fit(f, size.x, topLeft.x + topRight.x);
+            f = Fit(f, size.x, bottomLeft.x + bottomRight.x);
+            f = Fit(f, size.y, topLeft.y + bottomLeft.y);
+            f = Fit(f, size.y, topRight.y + bottomRight.y);
+            if (f >= 1)
+                return this;
+            return new CornerRadii {
+                topLeft = topLeft * f, topRight = topRight * f, bottomRight = bottomRight * f, bottomLeft = bottomLeft * f
+            };
+        }
+
+        /// <summary>
+        /// The radii of the box inset by the given border widths (the padding box of a border box with these
+        /// radii): each radius shrinks by the adjoining border's width.
+        /// </summary>
+        public CornerRadii Inset(float left, float top, float right, float bottom) {
+            return new CornerRadii {
+                topLeft = Shrink(topLeft, left, top), topRight = Shrink(topRight, right, top),
+                bottomRight = Shrink(bottomRight, right, bottom), bottomLeft = Shrink(bottomLeft, left, bottom)
+            };
+        }
+
+        public bool Equals(CornerRadii other) {
+            return topLeft == other.topLeft && topRight == other.topRight && bottomRight == other.bottomRight &&
+                   bottomLeft == other.bottomLeft;
+        }
+
+        public override bool Equals(object obj) {
+            return obj is CornerRadii other && Equals(other);
+        }
+
+        public override int GetHashCode() {
+            return HashCode.Combine(topLeft, topRight, bottomRight, bottomLeft);
+        }
+
+        static float Fit(float f, float length, float sum) {
+            return sum > length && sum > 0 ? Mathf.Min(f, length / sum) : f;
+        }
+
+        static Vector2 Shrink(Vector2 radius, float x, float y) {
+            return new Vector2(Mathf.Max(0, radius.x - x), Mathf.Max(0, radius.y - y));
+        }
+    }
+
+    /// <summary>
+    /// Paints a CssGradient behind an element's content, for gradient background-images. Hooks into the
+    /// element's generateVisualContent alongside whatever else draws there, clipped to the element's rounded
+    /// corners (border-radius).
+    /// </summary>
+    public class GradientBackground {
+        readonly VisualElement _element;
+        readonly GradientMesh _mesh = new GradientMesh();
+        CssGradient _gradient;
+
+        public CssGradient gradient => _gradient;
+
+        public GradientBackground(VisualElement element) {
+            _element = element;
+        }
+
+        /// <summary>
+        /// Null removes the gradient.
+        /// </summary>
+        public void Set(CssGradient gradient) {
+            if (gradient == _gradient)
+                return;
+            if (_gradient == null && gradient != null)
+                _element.generateVisualContent += Draw;
+            else if (_gradient != null && gradient == null)
+                _element.generateVisualContent -= Draw;
+            _gradient = gradient;
+            _element.MarkDirtyRepaint();
+        }
+
+        void Draw(MeshGenerationContext mgc) {
+            // Padding box, like a CSS background
+            var style = _element.resolvedStyle;
+            var layout = _element.layout;
+            var rect = new Rect(style.borderLeftWidth, style.borderTopWidth,
+                layout.width - style.borderLeftWidth - style.borderRightWidth,
+                layout.height - style.borderTopWidth - style.borderBottomWidth);
+            var radii = CornerRadii.FromStyle(style, layout.size).Inset(style.borderLeftWidth, style.borderTopWidth,
+                style.borderRightWidth, style.borderBottomWidth);
+            _mesh.Draw(mgc, rect, radii, _gradient);
+        }
+    }
+}
@@ -8,11 +8,28 @@ namespace OneJS.Dom {
         Dom createElement(string tagName, ElementCreationOptions options);
         Dom createElementNS(string ns, string tagName, ElementCreationOptions options);
         Dom createTextNode(string text);
+        MediaQueryList matchMedia(string query);
+        TextureCache textureCache { get; }
+        ImageAtlas imageAtlas { get; }
+        SvgLoader svgLoader { get; }
         void clearCache();
+        ImageLoadScheduler imageLoadScheduler { get; }
         Coroutine loadRemoteImage(string path, Action<Texture2D> callback);
+        void cancelRemoteImage(string path, Action<Texture2D> callback);
         Texture2D loadImage(string path, FilterMode filterMode = FilterMode.Bilinear);
+        void loadImageAsync(string path, Action<Texture2D> callback, FilterMode filterMode = FilterMode.Bilinear);
+        Background loadBackground(string path, FilterMode filterMode = FilterMode.Bilinear);
+        void loadBackgroundAsync(string path, Action<Background> callback, FilterMode filterMode = FilterMode.Bilinear);
+        bool tryGetCachedBackground(string path, out Background background);
+        void retainImage(Texture2D texture);
+        void retainBackground(Background background);
+        void releaseImage(Texture2D texture);
+        void releaseBackground(Background background);
+        void loadVectorImageAsync(string path, int size, Action<VectorImage> callback, Color? currentColor = null);
         Font loadFont(string path);
         FontDefinition loadFontDefinition(string path);
+        void loadFontDefinitionAsync(string path, Action<FontDefinition> callback, string prewarmCharacters = null);
+        void prewarmFont(string path, string characters);
         void AddCachingDom(Dom dom);
         void RemoveCachingDom(Dom dom);
     }
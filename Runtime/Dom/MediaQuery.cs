@@ -0,0 +1,395 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// What media queries are evaluated against. Lengths are in UI (panel) pixels.
+    /// </summary>
+    public struct MediaFeatures {
+        public float width;
+        public float height;
+        /// <summary>
+        /// Physical pixels per UI pixel (the CSS `dppx` unit)
+        /// </summary>
+        public float dppx;
+        /// <summary>
+        /// Physical screen size, in UI pixels (device-width, device-height)
+        /// </summary>
+        public float deviceWidth;
+        public float deviceHeight;
+
+        public bool Equals(MediaFeatures other) {
+            return width.Equals(other.width) && height.Equals(other.height) && dppx.Equals(other.dppx) &&
+                   deviceWidth.Equals(other.deviceWidth) && deviceHeight.Equals(other.deviceHeight);
+        }
+    }
+
+    /// <summary>
+    /// A parsed CSS media query list, i.e. "screen and (min-width: 640px), (orientation: portrait)".
+    /// Supports media types (all, screen; anything else never matches), not/only, conditions combined with `and`,
+    /// `or` and `not` ("not (orientation: portrait)", "((width &lt; 400px) or (height &lt; 400px))"), and the width,
+    /// height, aspect-ratio, orientation, resolution, device-width and device-height features, with min-/max-
+    /// prefixes or range syntax ("(400px &lt;= width &lt; 700px)"). Lengths can be px, em or rem (16px), resolutions
+    /// dppx, x, dpi or dpcm. As in browsers, a query that doesn't parse never matches.
+    /// </summary>
+    public class MediaQuery {
+        const float RemPx = 16f;
+
+        public string Text => _text;
+
+        readonly string _text;
+        readonly List<Branch> _branches = new List<Branch>();
+
+        MediaQuery(string text) {
+            _text = text;
+        }
+
+        public static MediaQuery Parse(string text) {
+            var query = new MediaQuery(text);
+            foreach (var part in SplitTopLevel(text ?? "", ',')) {
+                Branch branch;
+                try {
+                    branch = ParseBranch(part);
+                } catch (FormatException) {
+                    branch = null;
+                }
+                // An invalid branch is "not all", which leaves the others alone
+                query._branches.Add(branch ?? Branch.Never);
+            }
+            return query;
+        }
+
+        public bool Evaluate(MediaFeatures features) {
+            foreach (var branch in _branches) {
+                if (branch.Evaluate(features))
+                    return true;
+            }
+            return false;
+        }
+
+        #region Parsing
+        static Branch ParseBranch(string text) {
+            var tokens = Tokenize(text);
+            if (tokens.Count == 0)
+                return Branch.Always; // An empty query matches everything
+            var branch = new Branch();
+            var i = 0;
+            var keyword = tokens[0].ToLowerInvariant();
+            if (tokens[0][0] == '(' || (keyword == "not" && tokens.Count > 1 && tokens[1][0] == '(')) {
+                // Just a condition: "(min-width: 600px)", "not (orientation: portrait)", "(a) or (b)"
+                branch.condition = ParseCondition(tokens, ref i, true);
+            } else {
+                if (keyword == "not" || keyword == "only") {
+                    branch.negate = keyword == "not";
+                    i++;
+                }
+                if (i == tokens.Count || tokens[i][0] == '(')
+                    throw new FormatException(); // not/only need a media type
+                var type = tokens[i++].ToLowerInvariant();
+                branch.typeMatches = type == "all" || type == "screen";
+                // After a media type, conditions can only be and-ed
+                if (i < tokens.Count) {
+                    Expect(tokens, ref i, "and");
+                    branch.condition = ParseCondition(tokens, ref i, false);
+                }
+            }
+            if (i != tokens.Count)
+                throw new FormatException();
+            return branch;
+        }
+
+        /// <summary>
+        /// "not (a)", or "(a)" followed by any number of "and (b)" or of "or (b)" (mixing them needs parentheses).
+        /// Stops at the first token that doesn't continue it.
+        /// </summary>
+        static Func<MediaFeatures, bool> ParseCondition(List<string> tokens, ref int i, bool allowOr) {
+            if (i < tokens.Count && tokens[i].Equals("not", StringComparison.OrdinalIgnoreCase)) {
+                i++;
+                if (i == tokens.Count)
+                    throw new FormatException();
+                var negated = ParseInParens(tokens[i++]);
+                return f => !negated(f);
+            }
+            if (i == tokens.Count)
+                throw new FormatException();
+            var conditions = new List<Func<MediaFeatures, bool>> { ParseInParens(tokens[i++]) };
+            string combinator = null;
+            while (i < tokens.Count) {
+                var word = tokens[i].ToLowerInvariant();
+                if (word != "and" && !(allowOr && word == "or"))
+                    break;
+                if (combinator != null && word != combinator)
+                    throw new FormatException();
+                combinator = word;
+                i++;
+                if (i == tokens.Count)
+                    throw new FormatException();
+                conditions.Add(ParseInParens(tokens[i++]));
+            }
+            if (conditions.Count == 1)
+                return conditions[0];
+            if (combinator == "or") {
+                return f => {
+                    foreach (var condition in conditions) {
+                        if (condition(f))
+                            return true;
+                    }
+                    return false;
+                };
+            }
+            return f => {
+                foreach (var condition in conditions) {
+                    if (!condition(f))
+                        return false;
+                }
+                return true;
+            };
+        }
+
+        /// <summary>
+        /// A parenthesized feature, i.e. "(width &gt;= 600px)", or a nested condition, i.e. "(not (hover))".
+        /// </summary>
+        static Func<MediaFeatures, bool> ParseInParens(string token) {
+            if (token[0] != '(')
+                throw new FormatException();
+            var inner = token.Substring(1, token.Length - 2).Trim();
+            var nested = inner.StartsWith("(") || (inner.Length > 3 &&
+                inner.StartsWith("not", StringComparison.OrdinalIgnoreCase) &&
+                (char.IsWhiteSpace(inner[3]) || inner[3] == '('));
+            if (!nested)
+                return ParseFeature(inner);
+            var tokens = Tokenize(inner);
+            var i = 0;
+            var condition = ParseCondition(tokens, ref i, true);
+            if (i != tokens.Count)
+                throw new FormatException();
+            return condition;
+        }
+
+        static void Expect(List<string> tokens, ref int i, string keyword) {
+            if (!tokens[i].Equals(keyword, StringComparison.OrdinalIgnoreCase))
+                throw new FormatException();
+            i++;
+        }
+
+        /// <summary>
+        /// Words and whole parenthesized groups
+        /// </summary>
+        static List<string> Tokenize(string text) {
+            var tokens = new List<string>();
+            var i = 0;
+            while (i < text.Length) {
+                if (char.IsWhiteSpace(text[i])) {
+                    i++;
+                    continue;
+                }
+                var start = i;
+                if (text[i] == '(') {
+                    var depth = 0;
+                    do {
+                        if (text[i] == '(') depth++;
+                        else if (text[i] == ')') depth--;
+                        i++;
+                    } while (i < text.Length && depth > 0);
+                    if (depth != 0)
+                        throw new FormatException();
+                } else {
+                    while (i < text.Length && !char.IsWhiteSpace(text[i]) && text[i] != '(')
+                        i++;
+                }
+                tokens.Add(text.Substring(start, i - start));
+            }
+            return tokens;
+        }
+
+        static IEnumerable<string> SplitTopLevel(string text, char separator) {
+            var depth = 0;
+            var start = 0;
+            for (int i = 0; i < text.Length; i++) {
+                if (text[i] == '(') depth++;
+                else if (text[i] == ')') depth--;
+                else if (text[i] == separator && depth == 0) {
+                    yield return text.Substring(start, i - start);
+                    start = i + 1;
+                }
+            }
+            yield return text.Substring(start);
+        }
+
+        static Func<MediaFeatures, bool> ParseFeature(string text) {
+            text = text.Trim();
+            var colon = text.IndexOf(':');
+            if (colon >= 0) {
+                var name = text.Substring(0, colon).Trim().ToLowerInvariant();
+                var value = text.Substring(colon + 1).Trim();
+                if (name == "orientation") {
+                    var orientation = value.ToLowerInvariant();
+                    if (orientation != "portrait" && orientation != "landscape")
+                        throw new FormatException();
+                    return f => (f.height >= f.width) == (orientation == "portrait");
+                }
+                var op = Op.Equal;
+                if (name.StartsWith("min-")) {
+                    op = Op.GreaterOrEqual;
+                    name = name.Substring(4);
+                } else if (name.StartsWith("max-")) {
+                    op = Op.LessOrEqual;
+                    name = name.Substring(4);
+                }
+                var getter = GetFeature(name);
+                var target = ParseValue(name, value);
+                return f => Compare(getter(f), op, target);
+            }
+            if (text.IndexOfAny(new[] { '<', '>', '=' }) >= 0)
+                return ParseRange(text);
+            // Boolean context, i.e. "(width)": true if the feature isn't zero
+            if (text.Equals("orientation", StringComparison.OrdinalIgnoreCase))
+                return f => true;
+            var feature = GetFeature(text.ToLowerInvariant());
+            return f => feature(f) != 0;
+        }
+
+        /// <summary>
+        /// "width >= 600px", "600px &lt;= width", "400px &lt; width &lt;= 700px"
+        /// </summary>
+        static Func<MediaFeatures, bool> ParseRange(string text) {
+            var parts = new List<string>();
+            var ops = new List<Op>();
+            var start = 0;
+            for (int i = 0; i < text.Length; i++) {
+                var c = text[i];
+                if (c != '<' && c != '>' && c != '=')
+                    continue;
+                parts.Add(text.Substring(start, i - start).Trim());
+                var withEquals = c != '=' && i + 1 < text.Length && text[i + 1] == '=';
+                ops.Add(c == '=' ? Op.Equal : c == '<' ? (withEquals ? Op.LessOrEqual : Op.Less) : (withEquals ? Op.GreaterOrEqual : Op.Greater));
+                if (withEquals)
+                    i++;
+                start = i + 1;
+            }
+            parts.Add(text.Substring(start).Trim());
+
+            if (parts.Count == 2) {
+                if (IsFeatureName(parts[0])) {
+                    var name = parts[0].ToLowerInvariant();
+                    var getter = GetFeature(name);
+                    var value = ParseValue(name, parts[1]);
+                    var op = ops[0];
+                    return f => Compare(getter(f), op, value);
+                } else {
+                    var name = parts[1].ToLowerInvariant();
+                    var getter = GetFeature(name);
+                    var value = ParseValue(name, parts[0]);
+                    var op = Flip(ops[0]);
+                    return f => Compare(getter(f), op, value);
+                }
+            }
+            if (parts.Count == 3 && IsFeatureName(parts[1])) {
+                // Both operators have to point the same way
+                var ascending = ops[0] == Op.Less || ops[0] == Op.LessOrEqual;
+                if (ascending != (ops[1] == Op.Less || ops[1] == Op.LessOrEqual) || ops[0] == Op.Equal || ops[1] == Op.Equal)
+                    throw new FormatException();
+                var name = parts[1].ToLowerInvariant();
+                var getter = GetFeature(name);
+                var low = ParseValue(name, parts[0]);
+                var high = ParseValue(name, parts[2]);
+                var lowOp = Flip(ops[0]);
+                var highOp = ops[1];
+                return f => {
+                    var v = getter(f);
+                    return Compare(v, lowOp, low) && Compare(v, highOp, high);
+                };
+            }
+            throw new FormatException();
+        }
+
+        static bool IsFeatureName(string text) {
+            return text.Length > 0 && char.IsLetter(text[0]);
+        }
+
+        static Func<MediaFeatures, float> GetFeature(string name) {
+            switch (name) {
+                case "width": return f => f.width;
+                case "height": return f => f.height;
+                case "aspect-ratio": return f => f.height > 0 ? f.width / f.height : 0;
+                case "resolution": return f => f.dppx;
+                case "device-width": return f => f.deviceWidth;
+                case "device-height": return f => f.deviceHeight;
+                case "device-aspect-ratio": return f => f.deviceHeight > 0 ? f.deviceWidth / f.deviceHeight : 0;
+                default: throw new FormatException();
+            }
+        }
+
+        /// <summary>
+        /// Lengths to px, ratios to a single number, resolutions to dppx.
+        /// </summary>
+        static float ParseValue(string feature, string text) {
+            text = text.Trim().ToLowerInvariant();
+            if (feature.EndsWith("aspect-ratio")) {
+                var slash = text.IndexOf('/');
+                if (slash < 0)
+                    return ParseNumber(text);
+                var denominator = ParseNumber(text.Substring(slash + 1));
+                return denominator == 0 ? float.PositiveInfinity : ParseNumber(text.Substring(0, slash)) / denominator;
+            }
+            if (feature == "resolution") {
+                if (text.EndsWith("dppx")) return ParseNumber(text.Substring(0, text.Length - 4));
+                if (text.EndsWith("dpcm")) return ParseNumber(text.Substring(0, text.Length - 4)) * 2.54f / 96f;
+                if (text.EndsWith("dpi")) return ParseNumber(text.Substring(0, text.Length - 3)) / 96f;
+                if (text.EndsWith("x")) return ParseNumber(text.Substring(0, text.Length - 1));
+                throw new FormatException();
+            }
+            if (text.EndsWith("px")) return ParseNumber(text.Substring(0, text.Length - 2));
+            if (text.EndsWith("rem")) return ParseNumber(text.Substring(0, text.Length - 3)) * RemPx;
+            if (text.EndsWith("em")) return ParseNumber(text.Substring(0, text.Length - 2)) * RemPx;
+            var number = ParseNumber(text);
+            if (number != 0)
+                throw new FormatException(); // Only 0 can go without a unit
+            return 0;
+        }
+
+        static float ParseNumber(string text) {
+            if (!float.TryParse(text.Trim(), NumberStyles.Float, CultureInfo.InvariantCulture, out var value))
+                throw new FormatException();
+            return value;
+        }
+        #endregion
+
+        enum Op { Equal, Less, LessOrEqual, Greater, GreaterOrEqual }
+
+        static Op Flip(Op op) {
+            switch (op) {
+                case Op.Less: return Op.Greater;
+                case Op.LessOrEqual: return Op.GreaterOrEqual;
+                case Op.Greater: return Op.Less;
+                case Op.GreaterOrEqual: return Op.LessOrEqual;
+                default: return op;
+            }
+        }
+
+        static bool Compare(float actual, Op op, float target) {
+            switch (op) {
+                case Op.Less: return actual < target;
+                case Op.LessOrEqual: return actual <= target + 0.001f;
+                case Op.Greater: return actual > target;
+                case Op.GreaterOrEqual: return actual >= target - 0.001f;
+                default: return Math.Abs(actual - target) <= 0.001f;
+            }
+        }
+
+        class Branch {
+            public static readonly Branch Never = new Branch { typeMatches = false };
+            public static readonly Branch Always = new Branch();
+
+            public bool negate;
+            public bool typeMatches = true;
+            public Func<MediaFeatures, bool> condition;
+
+            public bool Evaluate(MediaFeatures features) {
+                var matches = typeMatches && (condition == null || condition(features));
+                return matches != negate;
+            }
+        }
+    }
+}
@@ -0,0 +1,169 @@
+﻿using System;
+using System.Collections.Generic;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Evaluates media queries against a root element, and re-evaluates them only when the root's geometry changes
+    /// (GeometryChangedEvent), instead of polling every frame. Listeners are called only for queries whose result
+    /// actually changed. Queries with the same text share one MediaQueryList.
+    ///
+    /// Main thread only. Dispose() (i.e. on reload) unregisters from the root and drops every listener.
+    /// </summary>
+    public class MediaQueryWatcher : IDisposable {
+        public VisualElement Root => _root;
+        public MediaFeatures Features => _features;
+
+        readonly VisualElement _root;
+        readonly Dictionary<string, MediaQueryList> _lists = new Dictionary<string, MediaQueryList>();
+        readonly List<MediaQueryList> _changed = new List<MediaQueryList>();
+        MediaFeatures _features;
+        bool _disposed;
+
+        public MediaQueryWatcher(VisualElement root) {
+            _root = root;
+            _features = ReadFeatures();
+            _root.RegisterCallback<GeometryChangedEvent>(OnGeometryChanged);
+        }
+
+        public MediaQueryList Match(string query) {
+            query = (query ?? "").Trim();
+            if (!_lists.TryGetValue(query, out var list)) {
+                var parsed = MediaQuery.Parse(query);
+                list = new MediaQueryList(parsed, parsed.Evaluate(_features));
+                _lists[query] = list;
+            }
+            return list;
+        }
+
+        /// <summary>
+        /// Re-reads the root's size and the screen, and notifies listeners of any results that changed. Called on
+        /// GeometryChangedEvent; call it directly after something else a query depends on changed (i.e. Screen.dpi).
+        /// </summary>
+        public void Refresh() {
+            if (_disposed)
+                return;
+            var features = ReadFeatures();
+            if (features.Equals(_features))
+                return;
+            _features = features;
+            foreach (var list in _lists.Values) {
+                var matches = list.query.Evaluate(features);
+                if (matches == list.matches)
+                    continue;
+                list.matches = matches;
+                _changed.Add(list);
+            }
+            // Listeners may add queries, so they're called after the loop
+            foreach (var list in _changed)
+                list.Notify();
+            _changed.Clear();
+        }
+
+        public void Dispose() {
+            if (_disposed)
+                return;
+            _disposed = true;
+            _root.UnregisterCallback<GeometryChangedEvent>(OnGeometryChanged);
+            foreach (var list in _lists.Values)
+                list.ClearListeners();
+            _lists.Clear();
+        }
+
+        void OnGeometryChanged(GeometryChangedEvent evt) {
+            Refresh();
+        }
+
+        MediaFeatures ReadFeatures() {
+            var width = _root.resolvedStyle.width;
+            var height = _root.resolvedStyle.height;
+            // The panel scale isn't public, so it's taken from how many screen pixels the (full-screen) root covers
+            var dppx = width > 0 && Screen.width > 0 ? Screen.width / width : 1f;
+            return new MediaFeatures {
+                width = width,
+                height = height,
+                dppx = dppx,
+                deviceWidth = Screen.width / dppx,
+                deviceHeight = Screen.height / dppx
+            };
+        }
+    }
+
+    /// <summary>
+    /// The result of Document.matchMedia(), as in the DOM: `matches` is kept up to date, and change listeners are
+    /// called whenever it flips.
+    /// </summary>
+    public class MediaQueryList {
+        public string media => query.Text;
+        public bool matches { get; internal set; }
+
+        /// <summary>
+        /// Called (besides the listeners) when `matches` changes
+        /// </summary>
+        public Action<MediaQueryListEvent> onchange;
+
+        internal readonly MediaQuery query;
+        readonly List<Action<MediaQueryListEvent>> _listeners = new List<Action<MediaQueryListEvent>>();
+
+        /// <summary>
+        /// Without a MediaQueryWatcher, `matches` stays as given.
+        /// </summary>
+        public MediaQueryList(MediaQuery query, bool matches) {
+            this.query = query;
+            this.matches = matches;
+        }
+
+        public void addEventListener(string type, Action<MediaQueryListEvent> listener) {
+            if (type == "change")
+                addListener(listener);
+        }
+
+        public void removeEventListener(string type, Action<MediaQueryListEvent> listener) {
+            if (type == "change")
+                removeListener(listener);
+        }
+
+        public void addListener(Action<MediaQueryListEvent> listener) {
+            if (listener != null && !_listeners.Contains(listener))
+                _listeners.Add(listener);
+        }
+
+        public void removeListener(Action<MediaQueryListEvent> listener) {
+            _listeners.Remove(listener);
+        }
+
+        internal void Notify() {
+            var evt = new MediaQueryListEvent(media, matches);
+            Invoke(onchange, evt);
+            foreach (var listener in _listeners.ToArray())
+                Invoke(listener, evt);
+        }
+
+        internal void ClearListeners() {
+            onchange = null;
+            _listeners.Clear();
+        }
+
+        static void Invoke(Action<MediaQueryListEvent> listener, MediaQueryListEvent evt) {
+            if (listener == null)
+                return;
+            try {
+                listener(evt);
+            } catch (Exception e) {
+                Debug.LogException(e);
+            }
+        }
+    }
+
+    public class MediaQueryListEvent {
+        public string type => "change";
+        public string media { get; }
+        public bool matches { get; }
+
+        public MediaQueryListEvent(string media, bool matches) {
+            this.media = media;
+            this.matches = matches;
+        }
+    }
+}
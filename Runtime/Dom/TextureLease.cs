@@ -0,0 +1,69 @@
+﻿using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Dom {
+    /// <summary>
+    /// Keeps the cached texture (or atlas sprite, or SVG) an element displays retained in the document's
+    /// TextureCache (or ImageAtlas, or SvgLoader) while the element is attached to a panel, so it can't be evicted
+    /// from under it. Detached elements release theirs.
+    /// </summary>
+    public class TextureLease {
+        readonly IDocument _document;
+        readonly VisualElement _element;
+        Texture2D _texture;
+        Sprite _sprite;
+        VectorImage _vectorImage;
+        bool _retained;
+
+        public TextureLease(IDocument document, VisualElement element) {
+            _document = document;
+            _element = element;
+            element.RegisterCallback<AttachToPanelEvent>(OnAttach);
+            element.RegisterCallback<DetachFromPanelEvent>(OnDetach);
+        }
+
+        /// <summary>
+        /// Switches to a new texture (null to just let go of the current one).
+        /// </summary>
+        public void Set(Texture2D texture) {
+            Set(texture, null, null);
+        }
+
+        public void Set(Background background) {
+            Set(background.texture, background.sprite, background.vectorImage);
+        }
+
+        void Set(Texture2D texture, Sprite sprite, VectorImage vectorImage) {
+            if (texture == _texture && sprite == _sprite && vectorImage == _vectorImage)
+                return;
+            Release();
+            _texture = texture;
+            _sprite = sprite;
+            _vectorImage = vectorImage;
+            if (_element.panel != null)
+                Retain();
+        }
+
+        void OnAttach(AttachToPanelEvent evt) => Retain();
+
+        void OnDetach(DetachFromPanelEvent evt) => Release();
+
+        void Retain() {
+            if (_retained || (_texture == null && _sprite == null && _vectorImage == null))
+                return;
+            _document.textureCache.Retain(_texture);
+            _document.imageAtlas?.Retain(_sprite);
+            _document.svgLoader.Retain(_vectorImage);
+            _retained = true;
+        }
+
+        void Release() {
+            if (!_retained)
+                return;
+            _document.textureCache.Release(_texture);
+            _document.imageAtlas?.Release(_sprite);
+            _document.svgLoader.Release(_vectorImage);
+            _retained = false;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+﻿using OneJS.Utils;
+using Puerts;
+
+namespace OneJS {
+    /// <summary>
+    /// Serves JS modules straight from a BundleArchive, so nothing needs to be extracted before the JsEnv can
+    /// start. Module paths are looked up under basePath (i.e. "@outputs/esbuild/"). Anything not in the archive,
+    /// like Puerts' own built-in modules, goes to the fallback loader.
+    ///
+    /// Specifiers reach it already resolved (Puerts normalizes them and only asks FileExists/ReadFile), so there's
+    /// no IResolvableLoader here.
+    /// </summary>
+    public class ArchiveLoader : ILoader, IModuleChecker, IConcurrentLoader {
+        readonly BundleArchive _archive;
+        readonly string _basePath;
+        readonly ILoader _fallback;
+
+        public ArchiveLoader(BundleArchive archive, string basePath, ILoader fallback) {
+            _archive = archive;
+            _basePath = BundleArchive.NormalizePath(basePath ?? "");
+            if (_basePath.Length > 0 && !_basePath.EndsWith("/"))
+                _basePath += "/";
+            _fallback = fallback;
+        }
+
+        public bool FileExists(string filepath) {
+            return _archive.Contains(ArchivePath(filepath)) || (_fallback != null && _fallback.FileExists(filepath));
+        }
+
+        public string ReadFile(string filepath, out string debugpath) {
+            if (TryReadFile(filepath, out var content, out debugpath))
+                return content;
+            if (_fallback != null)
+                return _fallback.ReadFile(filepath, out debugpath);
+            return null;
+        }
+
+        public bool TryReadFile(string filepath, out string content, out string debugpath) {
+            debugpath = ArchivePath(filepath);
+            content = _archive.ReadAllText(debugpath);
+            return content != null;
+        }
+
+        public bool IsESM(string filepath) {
+            if (!_archive.Contains(ArchivePath(filepath)) && _fallback is IModuleChecker checker)
+                return checker.IsESM(filepath);
+            return filepath.Length >= 4 && !filepath.EndsWith(".cjs");
+        }
+
+        string ArchivePath(string filepath) {
+            return _basePath + BundleArchive.NormalizePath(filepath);
+        }
+    }
+}
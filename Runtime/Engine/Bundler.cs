@@ -2,8 +2,7 @@
 using System.Collections.Generic;
 using System.Diagnostics;
 using System.IO;
-using ICSharpCode.SharpZipLib.GZip;
-using ICSharpCode.SharpZipLib.Tar;
+using System.Linq;
 using Newtonsoft.Json;
 using OneJS.Utils;
 using UnityEditor;
@@ -32,6 +31,12 @@ namespace OneJS {
         public string version = "1.0";
         [Tooltip("Force extract on every game start, irregardless of version.")]
         public bool forceExtract;
+        [Tooltip("Standalone Player only. Serve scripts and assets straight from the in-memory bundle instead of extracting it to the WorkingDir first. Startup doesn't wait on disk writes, but the bundled files can't be modified on the device.")]
+        public bool serveFromArchive;
+        [Tooltip("Gzip gives the smallest bundle. LZ4 is larger but decompresses several times faster, and every file can be decompressed on its own (good with Serve From Archive).")]
+        public BundleCodec codec = BundleCodec.Gzip;
+        [Tooltip("Minify .js files with NUglify when packaging. Minified output is cached under Library/OneJS/MinifyCache, so unchanged sources aren't minified again.")]
+        public bool minifyJS;
         [Tooltip("Files and folders that you don't want to be packaged. Can use glob patterns.")] [PlainString]
         public string[] ignoreList = new string[] { "@outputs/tsc", "node_modules", "tmp" };
 
@@ -42,7 +47,10 @@ namespace OneJS {
             _engine = GetComponent<ScriptEngine>();
             var versionString = PlayerPrefs.GetString("ONEJS_VERSION", "0.0.0");
 #if !UNITY_EDITOR && (UNITY_STANDALONE || UNITY_IOS || UNITY_ANDROID || UNITY_WEBGL)
-            ExtractForStandalone();
+            if (serveFromArchive)
+                ServeFromArchive();
+            else
+                ExtractForStandalone();
 #else
             if (versionString != _onejsVersion) {
                 // DeleteEverythingInPath(Path.Combine(_engine.WorkingDir, "onejs-core"));
@@ -143,24 +151,106 @@ namespace OneJS {
             var outputPath = _engine.WorkingDir;
             if (forceExtract || deployVersion != version) {
                 Debug.Log($"Extracting for Standalone Player. Deployment Version: {version}");
-                if (Directory.Exists(outputPath))
+                // With a manifest from the previous extraction, only changed files get rewritten. Force Extract
+                // (or a missing manifest) still starts from a clean WorkingDir.
+                var prevManifest = forceExtract ? null : BundleManifest.Load(Path.Combine(outputPath, BundleManifest.FileName));
+                if (prevManifest == null && Directory.Exists(outputPath))
                     DeleteEverythingInPath(outputPath);
-                Extract(bundleZip.bytes);
+                ExtractDelta(bundleZip.bytes, prevManifest ?? new BundleManifest());
                 Debug.Log($"Bundle Zip extracted.");
 
                 PlayerPrefs.SetString("ONEJS_APP_DEPLOYMENT_VERSION", version);
             }
         }
 
+        /// <summary>
+        /// Indexes the bundle in memory and hands it to the ScriptEngine. Runs before ScriptEngine.Awake
+        /// (see DefaultExecutionOrder), so the JsEnv loader picks it up.
+        /// </summary>
+        public void ServeFromArchive() {
+            var t = DateTime.Now;
+            var archive = BundleArchive.FromBytes(bundleZip.bytes);
+            _engine.SetArchive(archive);
+            Debug.Log($"Serving {archive.Count} files from the bundle archive. {(DateTime.Now - t).TotalMilliseconds}ms");
+        }
+
         void Extract(byte[] bytes) {
-            Stream inStream = new MemoryStream(bytes);
-            Stream gzipStream = new GZipInputStream(inStream);
-
-            TarArchive tarArchive = TarArchive.CreateInputTarArchive(gzipStream);
-            tarArchive.ExtractContents(_engine.WorkingDir);
-            tarArchive.Close();
-            gzipStream.Close();
-            inStream.Close();
+            var outputPath = Path.GetFullPath(_engine.WorkingDir).TrimEnd(Path.DirectorySeparatorChar) +
+                             Path.DirectorySeparatorChar;
+            foreach (var kv in BundleFormat.ReadEntries(bytes)) {
+                if (kv.Key == BundleManifest.FileName)
+                    continue;
+                var destPath = Path.GetFullPath(Path.Combine(outputPath, kv.Key));
+                if (!destPath.StartsWith(outputPath))
+                    continue;
+                Directory.CreateDirectory(Path.GetDirectoryName(destPath));
+                File.WriteAllBytes(destPath, kv.Value);
+            }
+        }
+
+        /// <summary>
+        /// Extracts only the files whose hash differs from the previous manifest, deletes files that are no longer
+        /// in the bundle, and saves the new manifest to the WorkingDir.
+        /// </summary>
+        void ExtractDelta(byte[] bytes, BundleManifest prevManifest) {
+            var outputPath = Path.GetFullPath(_engine.WorkingDir).TrimEnd(Path.DirectorySeparatorChar) +
+                             Path.DirectorySeparatorChar;
+            var newManifest = new BundleManifest();
+            BundleManifest bundledManifest = null;
+            int written = 0, skipped = 0, deleted = 0;
+
+            foreach (var kv in BundleFormat.ReadEntries(bytes)) {
+                var name = kv.Key;
+                var data = kv.Value;
+                if (name == BundleManifest.FileName) {
+                    bundledManifest = BundleManifest.FromBytes(data);
+                    continue;
+                }
+                var destPath = Path.GetFullPath(Path.Combine(outputPath, name));
+                if (!destPath.StartsWith(outputPath)) {
+                    Debug.LogWarning($"Skipping bundle entry outside of WorkingDir: {name}");
+                    continue;
+                }
+
+                // Entries are hashed as they stream by, since the bundled manifest comes last
+                var hash = BundleManifest.ComputeHash(data);
+                newManifest.Add(name, hash, data.Length);
+                if (prevManifest.TryGetEntry(name, out var prev) && prev.hash == hash &&
+                    prev.size == data.Length && File.Exists(destPath) && new FileInfo(destPath).Length == data.Length) {
+                    skipped++;
+                    continue;
+                }
+                Directory.CreateDirectory(Path.GetDirectoryName(destPath));
+                File.WriteAllBytes(destPath, data);
+                written++;
+            }
+
+            // Older bundles have no manifest; what we just extracted is the complete list then
+            var currentManifest = bundledManifest ?? newManifest;
+            foreach (var prev in prevManifest.files) {
+                if (currentManifest.TryGetEntry(prev.path, out _))
+                    continue;
+                var path = Path.GetFullPath(Path.Combine(outputPath, prev.path));
+                if (path.StartsWith(outputPath) && File.Exists(path)) {
+                    File.Delete(path);
+                    DeleteEmptyParents(path, outputPath);
+                    deleted++;
+                }
+            }
+            newManifest.Save(Path.Combine(outputPath, BundleManifest.FileName));
+            Debug.Log($"Bundle delta: {written} written, {skipped} unchanged, {deleted} deleted.");
+        }
+
+        /// <summary>
+        /// Removes the directories a deleted file leaves empty, up to (but not including) root.
+        /// </summary>
+        static void DeleteEmptyParents(string filepath, string root) {
+            var dir = Path.GetDirectoryName(filepath);
+            while (dir != null && dir.Length >= root.Length && dir.StartsWith(root) && Directory.Exists(dir) &&
+                   !Directory.EnumerateFileSystemEntries(dir).Any()) {
+                Directory.Delete(dir);
+                dir = Path.GetDirectoryName(dir);
+            }
         }
 
         /// <summary>
@@ -238,15 +328,29 @@ namespace OneJS {
             var binPath = AssetDatabase.GetAssetPath(bundleZip);
             binPath = Path.GetFullPath(Path.Combine(Application.dataPath, @".." + Path.DirectorySeparatorChar,
                 binPath));
-            var outStream = File.Create(binPath);
-            var gzoStream = new GZipOutputStream(outStream);
-            gzoStream.SetLevel(3);
-            var tarOutputStream = new TarOutputStream(gzoStream);
-            var tarCreator = new TarCreator(_engine.WorkingDir, _engine.WorkingDir) { IgnoreList = ignoreList };
-            tarCreator.CreateTarFromIncludes(includes, tarOutputStream);
-
-            Debug.Log($"bundle.tgz.bytes file updated. {tarOutputStream.Length} bytes {(DateTime.Now - t).TotalMilliseconds}ms");
-            tarOutputStream.Close();
+            WriteBundle(File.Create(binPath), codec);
+
+            Debug.Log($"bundle.tgz.bytes file updated ({codec}). {new FileInfo(binPath).Length} bytes {(DateTime.Now - t).TotalMilliseconds}ms");
+        }
+
+        /// <summary>
+        /// Packages the includes into the given stream and closes it.
+        /// </summary>
+        /// <param name="minifyCacheDir">Where to cache minified JS (entries the run didn't use are pruned). Defaults
+        /// to Library/OneJS/MinifyCache.</param>
+        public void WriteBundle(Stream outStream, BundleCodec bundleCodec, string minifyCacheDir = null) {
+            _engine = GetComponent<ScriptEngine>();
+            var minifyCache = minifyJS
+                ? new MinifyCache(minifyCacheDir ?? Path.Combine(Application.dataPath, "..", "Library", "OneJS", "MinifyCache"))
+                : null;
+            using (var writer = BundleFormat.CreateWriter(outStream, bundleCodec)) {
+                var tarCreator = new TarCreator(_engine.WorkingDir, _engine.WorkingDir) {
+                    IgnoreList = ignoreList, UglifyJS = minifyJS, MinifyCache = minifyCache
+                };
+                tarCreator.CreateFromIncludes(includes, writer);
+                tarCreator.WriteManifest(writer);
+            }
+            minifyCache?.PruneUnused();
         }
 
         [ContextMenu("Zero Out bundle.tgz")]
@@ -0,0 +1,132 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading.Tasks;
+using Puerts;
+
+namespace OneJS {
+    /// <summary>
+    /// Wraps another loader and memoizes FileExists() and IsESM(), which Puerts calls for every module it imports
+    /// (often the same paths over and over). Existence checks can be expensive (i.e. DefaultLoader does a full
+    /// Resources.Load). Reads are passed through as is.
+    ///
+    /// Changed files are forgotten via Invalidate() (driven by the live reload watcher); negative results are
+    /// also dropped on every ScriptEngine.Reload(). Safe to use from multiple threads.
+    ///
+    /// Module sources can also be prefetched on thread pool threads (see Prefetch), so the reads that module.mjs
+    /// does one at a time on the main thread are already done by the time they're asked for.
+    /// </summary>
+    public class CachingLoader : ILoader, IModuleChecker {
+        public ILoader Inner => _inner;
+
+        readonly ILoader _inner;
+        readonly string _root;
+        readonly ConcurrentDictionary<string, bool> _exists = new ConcurrentDictionary<string, bool>();
+        readonly ConcurrentDictionary<string, bool> _esm = new ConcurrentDictionary<string, bool>();
+        readonly ConcurrentDictionary<string, Task<Prefetched>> _prefetched = new ConcurrentDictionary<string, Task<Prefetched>>();
+
+        /// <param name="inner">The loader doing the actual work</param>
+        /// <param name="root">Directory the module paths are relative to. Used to map full paths in Invalidate().</param>
+        public CachingLoader(ILoader inner, string root) {
+            _inner = inner;
+            _root = string.IsNullOrEmpty(root) ? null : Path.GetFullPath(root);
+        }
+
+        public bool FileExists(string filepath) {
+            return _exists.GetOrAdd(filepath, p => _inner.FileExists(p));
+        }
+
+        public string ReadFile(string filepath, out string debugpath) {
+            if (TryTakePrefetched(filepath, out var content, out debugpath))
+                return content;
+            return _inner.ReadFile(filepath, out debugpath);
+        }
+
+        /// <summary>
+        /// Starts reading (and decoding) the given modules on thread pool threads. Only does anything if the inner
+        /// loader is an IConcurrentLoader. Each prefetched source is handed out once, by ReadFile().
+        /// </summary>
+        public void Prefetch(IEnumerable<string> filepaths) {
+            if (!(_inner is IConcurrentLoader concurrent))
+                return;
+            foreach (var filepath in filepaths) {
+                if (_prefetched.ContainsKey(filepath))
+                    continue;
+                _prefetched[filepath] = Task.Run(() => {
+                    var found = concurrent.TryReadFile(filepath, out var content, out var debugpath);
+                    return new Prefetched(found ? content : null, debugpath);
+                });
+            }
+        }
+
+        /// <summary>
+        /// Hands out a prefetched source, waiting for the read to finish if needed. False if the file wasn't
+        /// prefetched (or couldn't be read), in which case it should be read normally.
+        /// </summary>
+        public bool TryTakePrefetched(string filepath, out string content, out string debugpath) {
+            content = null;
+            debugpath = null;
+            if (!_prefetched.TryRemove(filepath, out var task))
+                return false;
+            try {
+                var result = task.Result;
+                content = result.content;
+                debugpath = result.debugpath;
+                return content != null;
+            } catch (AggregateException) {
+                return false;
+            }
+        }
+
+        /// <summary>
+        /// Drops prefetched sources nobody asked for (i.e. once the entry file has run, which imports all of its
+        /// static dependencies).
+        /// </summary>
+        public void ClearPrefetched() {
+            _prefetched.Clear();
+        }
+
+        public bool IsESM(string filepath) {
+            if (_inner is IModuleChecker checker)
+                return _esm.GetOrAdd(filepath, p => checker.IsESM(p));
+            return filepath.Length >= 4 && !filepath.EndsWith(".cjs");
+        }
+
+        /// <summary>
+        /// Forgets what's known about the given files. Negative results and prefetched sources are dropped
+        /// entirely, since a new file can make a previously missing path exist.
+        /// </summary>
+        /// <param name="fullpaths">Full paths of changed, created or deleted files</param>
+        public void Invalidate(IReadOnlyList<string> fullpaths) {
+            _prefetched.Clear();
+            foreach (var fullpath in fullpaths) {
+                if (_root == null)
+                    break;
+                var relative = Path.GetRelativePath(_root, fullpath).Replace('\\', '/');
+                _exists.TryRemove(relative, out _);
+                _esm.TryRemove(relative, out _);
+            }
+            foreach (var kv in _exists) {
+                if (!kv.Value)
+                    _exists.TryRemove(kv.Key, out _);
+            }
+        }
+
+        public void Clear() {
+            _prefetched.Clear();
+            _exists.Clear();
+            _esm.Clear();
+        }
+
+        readonly struct Prefetched {
+            public readonly string content;
+            public readonly string debugpath;
+
+            public Prefetched(string content, string debugpath) {
+                this.content = content;
+                this.debugpath = debugpath;
+            }
+        }
+    }
+}
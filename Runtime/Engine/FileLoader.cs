@@ -0,0 +1,57 @@
+﻿using System;
+using System.IO;
+using Puerts;
+
+namespace OneJS {
+    /// <summary>
+    /// Loads modules from a directory on disk (i.e. WorkingDir/basePath). Anything not found there, like Puerts'
+    /// own built-in modules, goes to the fallback loader.
+    ///
+    /// Note the order: a file in the directory wins over a Resources module of the same path (before FileLoader,
+    /// modules only ever came from Resources). Checking the disk first keeps the per-module Resources.Load probe
+    /// off the common path.
+    /// </summary>
+    public class FileLoader : ILoader, IModuleChecker, IConcurrentLoader {
+        readonly string _root;
+        readonly ILoader _fallback;
+
+        public FileLoader(string root, ILoader fallback) {
+            _root = Path.GetFullPath(root);
+            _fallback = fallback;
+        }
+
+        public bool FileExists(string filepath) {
+            return File.Exists(FullPath(filepath)) || (_fallback != null && _fallback.FileExists(filepath));
+        }
+
+        public string ReadFile(string filepath, out string debugpath) {
+            if (TryReadFile(filepath, out var content, out debugpath))
+                return content;
+            if (_fallback != null)
+                return _fallback.ReadFile(filepath, out debugpath);
+            return null;
+        }
+
+        public bool TryReadFile(string filepath, out string content, out string debugpath) {
+            debugpath = FullPath(filepath);
+            try {
+                content = File.ReadAllText(debugpath);
+                return true;
+            } catch (IOException) {
+            } catch (UnauthorizedAccessException) {
+            }
+            content = null;
+            return false;
+        }
+
+        public bool IsESM(string filepath) {
+            if (!File.Exists(FullPath(filepath)) && _fallback is IModuleChecker checker)
+                return checker.IsESM(filepath);
+            return filepath.Length >= 4 && !filepath.EndsWith(".cjs");
+        }
+
+        string FullPath(string filepath) {
+            return Path.Combine(_root, filepath.Replace('/', Path.DirectorySeparatorChar));
+        }
+    }
+}
@@ -0,0 +1,219 @@
+﻿using System;
+using System.Collections;
+using System.Collections.Generic;
+using System.IO;
+using UnityEngine;
+using UnityEngine.TextCore.Text;
+using UnityEngine.UIElements;
+using Object = UnityEngine.Object;
+
+namespace OneJS {
+    /// <summary>
+    /// Process-wide font cache, shared by every ScriptEngine, Document and Resource. Fonts, their dynamic FontAssets
+    /// and FontDefinitions are created once per font file (keyed by full path) and kept until Purge() (engines purge
+    /// the fonts they loaded on reload, so edited fonts are picked up) or Clear(). Entries remember who loaded them
+    /// rather than where the file is, since archive-backed engines load fonts from copies outside their WorkingDir
+    /// (see ScriptEngine.GetDiskPath).
+    ///
+    /// FontDefinitions are made from the cached FontAsset (FontDefinition.FromSDFFont), so glyphs can be pre-warmed:
+    /// Prewarm() rasterizes a character set into the FontAsset's atlas a batch per frame, ahead of the first text
+    /// that needs it, instead of all at once during that text's first layout.
+    ///
+    /// Main thread only.
+    /// </summary>
+    public class FontManager {
+        static FontManager _shared;
+
+        public static FontManager Shared => _shared ??= new FontManager();
+
+        /// <summary>
+        /// How many characters Prewarm() adds to a FontAsset per frame.
+        /// </summary>
+        public int PrewarmCharactersPerFrame { get; set; } = 64;
+
+        public int Count => _entries.Count;
+
+        readonly Dictionary<string, Entry> _entries = new Dictionary<string, Entry>();
+        readonly Dictionary<string, List<Action<FontDefinition>>> _pending = new Dictionary<string, List<Action<FontDefinition>>>();
+
+        /// <param name="path">Full path of a font file</param>
+        /// <param name="owner">Who's loading it (i.e. a ScriptEngine), for Purge()</param>
+        /// <returns>Null if the file doesn't exist or isn't a font</returns>
+        public Font GetFont(string path, object owner = null) {
+            return GetEntry(path, owner)?.font;
+        }
+
+        /// <param name="path">Full path of a font file</param>
+        /// <param name="owner">Who's loading it (i.e. a ScriptEngine), for Purge()</param>
+        /// <returns>Null if the file doesn't exist or isn't a font</returns>
+        public FontAsset GetFontAsset(string path, object owner = null) {
+            return GetEntry(path, owner)?.fontAsset;
+        }
+
+        /// <param name="path">Full path of a font file</param>
+        /// <param name="owner">Who's loading it (i.e. a ScriptEngine), for Purge()</param>
+        /// <returns>An empty FontDefinition if the file doesn't exist or isn't a font</returns>
+        public FontDefinition GetFontDefinition(string path, object owner = null) {
+            return GetEntry(path, owner)?.fontDefinition ?? default;
+        }
+
+        /// <summary>
+        /// Like GetFontDefinition, but creates the font on the next frame instead of during the caller's (a Font
+        /// can only be made from a path, on the main thread, so there's nothing to move off it). The callback is
+        /// invoked right away if the font is already loaded, and so is everything outside of play mode. Concurrent
+        /// loads of the same file are shared.
+        /// </summary>
+        /// <param name="path">Full path of a font file</param>
+        /// <param name="prewarmCharacters">Characters to pre-warm once it's loaded (see Prewarm), or null</param>
+        /// <param name="owner">Who's loading it (i.e. a ScriptEngine), for Purge()</param>
+        public void LoadAsync(string path, Action<FontDefinition> callback, string prewarmCharacters = null,
+            object owner = null) {
+            if (_entries.TryGetValue(path, out var entry)) {
+                AddOwner(entry, owner);
+                Prewarm(path, prewarmCharacters);
+                callback(entry.fontDefinition);
+                return;
+            }
+            if (_pending.TryGetValue(path, out var callbacks)) {
+                callbacks.Add(fd => {
+                    if (_entries.TryGetValue(path, out var loaded))
+                        AddOwner(loaded, owner);
+                    Prewarm(path, prewarmCharacters);
+                    callback(fd);
+                });
+                return;
+            }
+            // Coroutines don't run in edit mode
+            if (!Application.isPlaying) {
+                var fontDefinition = GetFontDefinition(path, owner);
+                Prewarm(path, prewarmCharacters);
+                callback(fontDefinition);
+                return;
+            }
+            _pending[path] = new List<Action<FontDefinition>> { callback };
+            StaticCoroutine.Start(LoadNextFrame(path, prewarmCharacters, owner));
+        }
+
+        /// <summary>
+        /// Adds glyphs for the given characters to a font's atlas, PrewarmCharactersPerFrame at a time (all at once
+        /// outside of play mode). Characters already in the atlas are skipped.
+        /// </summary>
+        /// <param name="path">Full path of a font file</param>
+        /// <param name="owner">Who's loading it (i.e. a ScriptEngine), for Purge()</param>
+        public void Prewarm(string path, string characters, object owner = null) {
+            if (string.IsNullOrEmpty(characters))
+                return;
+            var entry = GetEntry(path, owner);
+            if (entry?.fontAsset == null)
+                return;
+            if (!Application.isPlaying || PrewarmCharactersPerFrame <= 0) {
+                entry.fontAsset.TryAddCharacters(characters, out _);
+                return;
+            }
+            StaticCoroutine.Start(PrewarmCo(entry.fontAsset, characters));
+        }
+
+        /// <summary>
+        /// Destroys the cached Fonts and FontAssets loaded by an owner (i.e. an engine on reload), so they're read
+        /// again next time. Anything still displaying them loses its text, other owners' elements included.
+        /// </summary>
+        public void Purge(object owner) {
+            var purged = new List<string>();
+            foreach (var kv in _entries) {
+                if (kv.Value.owners.Contains(owner))
+                    purged.Add(kv.Key);
+            }
+            foreach (var path in purged) {
+                var entry = _entries[path];
+                DestroyObject(entry.fontAsset);
+                DestroyObject(entry.font);
+                _entries.Remove(path);
+            }
+        }
+
+        /// <summary>
+        /// Destroys every cached Font and FontAsset. Anything still displaying them loses its text.
+        /// </summary>
+        public void Clear() {
+            foreach (var entry in _entries.Values) {
+                DestroyObject(entry.fontAsset);
+                DestroyObject(entry.font);
+            }
+            _entries.Clear();
+        }
+
+        IEnumerator LoadNextFrame(string path, string prewarmCharacters, object owner) {
+            yield return null;
+            var fontDefinition = GetFontDefinition(path, owner);
+            Prewarm(path, prewarmCharacters);
+            if (!_pending.TryGetValue(path, out var waiting))
+                yield break;
+            _pending.Remove(path);
+            foreach (var cb in waiting) {
+                try {
+                    cb(fontDefinition);
+                } catch (Exception e) {
+                    Debug.LogException(e);
+                }
+            }
+        }
+
+        IEnumerator PrewarmCo(FontAsset fontAsset, string characters) {
+            var i = 0;
+            while (i < characters.Length && fontAsset != null) {
+                // Don't split surrogate pairs across batches
+                var end = Mathf.Min(i + PrewarmCharactersPerFrame, characters.Length);
+                if (end < characters.Length && char.IsHighSurrogate(characters[end - 1]))
+                    end++;
+                fontAsset.TryAddCharacters(characters.Substring(i, end - i), out _);
+                i = end;
+                yield return null;
+            }
+        }
+
+        Entry GetEntry(string path, object owner) {
+            if (_entries.TryGetValue(path, out var entry)) {
+                AddOwner(entry, owner);
+                return entry;
+            }
+            if (!File.Exists(path)) {
+                Debug.LogError($"Failed to load font: {path}");
+                return null;
+            }
+            var font = new Font(path);
+            var fontAsset = FontAsset.CreateFontAsset(font);
+            if (fontAsset != null)
+                fontAsset.name = font.name;
+            entry = new Entry {
+                font = font,
+                fontAsset = fontAsset,
+                // Falls back to letting UI Toolkit make its own FontAsset
+                fontDefinition = fontAsset != null ? FontDefinition.FromSDFFont(fontAsset) : FontDefinition.FromFont(font)
+            };
+            AddOwner(entry, owner);
+            _entries[path] = entry;
+            return entry;
+        }
+
+        static void AddOwner(Entry entry, object owner) {
+            if (owner != null)
+                entry.owners.Add(owner);
+        }
+
+        static void DestroyObject(Object obj) {
+            if (obj == null)
+                return;
+            if (Application.isPlaying)
+                Object.Destroy(obj);
+            else
+                Object.DestroyImmediate(obj);
+        }
+
+        class Entry {
+            public Font font;
+            public FontAsset fontAsset;
+            public FontDefinition fontDefinition;
+            public readonly HashSet<object> owners = new HashSet<object>();
+        }
+    }
+}
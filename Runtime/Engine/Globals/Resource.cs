@@ -9,47 +9,79 @@ namespace OneJS {
 
     public class Resource {
         IScriptEngine _engine;
-        Dictionary<string, Texture2D> _imageCache = new();
-        Dictionary<string, Font> _fontCache = new();
-        Dictionary<string, FontDefinition> _fontDefinitionCache = new();
+        TextureCache _textureCache;
 
         public Resource(IScriptEngine engine) {
             _engine = engine;
+            // Shares the ScriptEngine's image cache with Document and WebApi
+            _textureCache = engine is ScriptEngine scriptEngine ? scriptEngine.TextureCache : new TextureCache();
         }
 
+        // Fonts are cached process-wide, shared with Document and other engines (see FontManager)
         public Font loadFont(string path) {
-            var fullPath = Path.IsPathRooted(path)
-                ? path
-                : Path.GetFullPath(Path.Combine(_engine.WorkingDir, path));
-            if (_fontCache.TryGetValue(fullPath, out var cached))
-                return cached;
-            var font = new Font(fullPath);
-            _fontCache[fullPath] = font;
-            return font;
+            return FontManager.Shared.GetFont(GetFontPath(path), _engine);
         }
 
         public FontDefinition loadFontDefinition(string path) {
-            var fullPath = Path.IsPathRooted(path)
-                ? path
-                : Path.GetFullPath(Path.Combine(_engine.WorkingDir, path));
-            if (_fontDefinitionCache.TryGetValue(fullPath, out var cached))
-                return cached;
-            var font = loadFont(path);
-            var fd = FontDefinition.FromFont(font);
-            _fontDefinitionCache[fullPath] = fd;
-            return fd;
+            return FontManager.Shared.GetFontDefinition(GetFontPath(path), _engine);
+        }
+
+        public void loadFontDefinitionAsync(string path, Action<FontDefinition> callback, string prewarmCharacters = null) {
+            FontManager.Shared.LoadAsync(GetFontPath(path), callback, prewarmCharacters, _engine);
+        }
+
+        public void prewarmFont(string path, string characters) {
+            FontManager.Shared.Prewarm(GetFontPath(path), characters, _engine);
+        }
+
+        string GetFontPath(string path) {
+            var fullPath = Path.GetFullPath(Path.IsPathRooted(path) ? path : Path.Combine(_engine.WorkingDir, path));
+            // ScriptEngine may be serving files from a bundle archive; fonts need a real file
+            return _engine is ScriptEngine scriptEngine ? scriptEngine.GetDiskPath(fullPath) : fullPath;
         }
 
         public Texture2D loadImage(string path) {
-            var fullPath = Path.IsPathRooted(path) ? path : Path.Combine(_engine.WorkingDir, path);
-            if (_imageCache.TryGetValue(fullPath, out var cached))
+            var fullPath = Path.GetFullPath(Path.IsPathRooted(path) ? path : Path.Combine(_engine.WorkingDir, path));
+            if (_textureCache.TryGet(fullPath, out var cached))
                 return cached;
-            var rawData = System.IO.File.ReadAllBytes(fullPath);
+            // ScriptEngine may be serving files from a bundle archive instead of the WorkingDir
+            var rawData = _engine is ScriptEngine scriptEngine
+                ? scriptEngine.ReadAllBytes(fullPath)
+                : System.IO.File.ReadAllBytes(fullPath);
             Texture2D tex = new Texture2D(2, 2);
             tex.LoadImage(rawData);
             tex.filterMode = FilterMode.Bilinear;
-            _imageCache[fullPath] = tex;
-            return tex;
+            return _textureCache.Add(fullPath, tex);
+        }
+
+        /// <summary>
+        /// Like loadImage, but reads and decodes the image off the main thread (see ImageLoader). The callback gets
+        /// the texture, or null if it couldn't be loaded.
+        /// </summary>
+        public void loadImageAsync(string path, Action<Texture2D> callback) {
+            var fullPath = Path.GetFullPath(Path.IsPathRooted(path) ? path : Path.Combine(_engine.WorkingDir, path));
+            if (_textureCache.TryGet(fullPath, out var cached)) {
+                callback(cached);
+                return;
+            }
+            if (!(_engine is ScriptEngine scriptEngine)) {
+                callback(loadImage(path));
+                return;
+            }
+            scriptEngine.ImageLoader.Load(fullPath, FilterMode.Bilinear, tex => {
+                callback(tex != null ? _textureCache.Add(fullPath, tex) : null);
+            });
+        }
+
+        /// <summary>
+        /// Keeps a texture from loadImage or loadImageAsync cached until releaseImage (see Document.retainImage).
+        /// </summary>
+        public void retainImage(Texture2D texture) {
+            _textureCache.HandOut(texture);
+        }
+
+        public void releaseImage(Texture2D texture) {
+            _textureCache.ReleaseHandOut(texture);
         }
     }
 }
\ No newline at end of file
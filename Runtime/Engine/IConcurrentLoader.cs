@@ -0,0 +1,12 @@
+﻿namespace OneJS {
+    /// <summary>
+    /// Loaders that can read (some of) their files from any thread, i.e. straight from disk or from an archive.
+    /// Only these get their modules prefetched (see CachingLoader.Prefetch).
+    /// </summary>
+    public interface IConcurrentLoader {
+        /// <summary>
+        /// Reads a file without going to any fallback loader. Returns false if the file isn't there.
+        /// </summary>
+        bool TryReadFile(string filepath, out string content, out string debugpath);
+    }
+}
@@ -0,0 +1,350 @@
+﻿using System.Collections.Generic;
+using UnityEngine;
+
+namespace OneJS {
+    /// <summary>
+    /// Packs small images (i.e. icons) into shared RGBA32 atlas pages and hands out Sprites for them, so UI
+    /// Toolkit can batch the elements showing them instead of switching textures for every icon.
+    ///
+    /// Pages are shelf-packed with a 1px extruded gutter around each image (no bleeding with bilinear filtering).
+    /// New pages are added as needed, up to maxPages. Sprites are reference counted like TextureCache entries (and
+    /// handed out to scripts the same way): when space runs out, the least recently used unreferenced sprite whose
+    /// slot fits the new image (and that wasn't used this frame, same as in TextureCache) is evicted and the slot
+    /// reused, and a page that ends up with nothing on it is repacked from scratch. Freed slots aren't merged, so
+    /// if no single slot fits, Add() gives up instead of evicting everything.
+    /// Pixel changes are uploaded in one go per page on Flush() (ScriptEngine calls it every frame).
+    ///
+    /// Main thread only.
+    /// </summary>
+    public class ImageAtlas {
+        const int Padding = 1;
+
+        public int PageSize => _pageSize;
+        public int MaxImageSize => _maxImageSize;
+        public int PageCount => _pages.Count;
+        public int Count => _entries.Count;
+
+        readonly int _pageSize;
+        readonly int _maxImageSize;
+        readonly int _maxPages;
+        readonly List<Page> _pages = new List<Page>();
+        readonly Dictionary<string, Entry> _entries = new Dictionary<string, Entry>();
+        readonly Dictionary<Sprite, Entry> _bySprite = new Dictionary<Sprite, Entry>();
+        readonly LinkedList<Entry> _lru = new LinkedList<Entry>(); // Unreferenced entries, least recently used first
+
+        public ImageAtlas(int pageSize = 1024, int maxImageSize = 128, int maxPages = 4) {
+            _pageSize = pageSize;
+            _maxImageSize = Mathf.Min(maxImageSize, pageSize - Padding * 2);
+            _maxPages = maxPages;
+        }
+
+        /// <summary>
+        /// Whether an image of this size goes into the atlas.
+        /// </summary>
+        public bool Accepts(int width, int height) {
+            return width <= _maxImageSize && height <= _maxImageSize;
+        }
+
+        public bool TryGet(string key, out Sprite sprite) {
+            if (_entries.TryGetValue(key, out var entry)) {
+                entry.frame = Time.frameCount;
+                if (entry.node.List != null) {
+                    _lru.Remove(entry.node);
+                    _lru.AddLast(entry.node);
+                }
+                sprite = entry.sprite;
+                return true;
+            }
+            sprite = null;
+            return false;
+        }
+
+        /// <summary>
+        /// Copies a (readable) texture into the atlas and returns its sprite, or null if it's too big or there's
+        /// no room left. The texture itself is left alone.
+        /// </summary>
+        public Sprite Add(string key, Texture2D source) {
+            if (TryGet(key, out var existing))
+                return existing;
+            if (!Accepts(source.width, source.height) || !source.isReadable)
+                return null;
+            if (!TryAllocate(source.width + Padding * 2, source.height + Padding * 2, out var page, out var slot))
+                return null;
+
+            page.Blit(source.GetPixels32(), source.width, source.height, slot.x + Padding, slot.y + Padding);
+            var rect = new Rect(slot.x + Padding, slot.y + Padding, source.width, source.height);
+            var sprite = Sprite.Create(page.texture, rect, new Vector2(0.5f, 0.5f), 100, 0, SpriteMeshType.FullRect);
+            sprite.name = key;
+            var entry = new Entry(key, page, slot, sprite) { frame = Time.frameCount };
+            page.entryCount++;
+            _entries[key] = entry;
+            _bySprite[sprite] = entry;
+            _lru.AddLast(entry.node);
+            return sprite;
+        }
+
+        public bool Contains(Sprite sprite) {
+            return sprite != null && _bySprite.ContainsKey(sprite);
+        }
+
+        /// <summary>
+        /// Marks an atlas sprite as in use, so it can't be evicted. Other sprites are ignored.
+        /// </summary>
+        public void Retain(Sprite sprite) {
+            if (sprite == null || !_bySprite.TryGetValue(sprite, out var entry))
+                return;
+            if (entry.refCount++ == 0 && entry.node.List != null)
+                _lru.Remove(entry.node);
+        }
+
+        public void Release(Sprite sprite) {
+            // Hand-outs are only released through ReleaseHandOut()
+            if (sprite == null || !_bySprite.TryGetValue(sprite, out var entry) || entry.refCount <= entry.handOuts)
+                return;
+            Release(entry, 1);
+        }
+
+        /// <summary>
+        /// Retains a sprite on behalf of a script (see TextureCache.HandOut).
+        /// </summary>
+        public Sprite HandOut(Sprite sprite) {
+            if (sprite == null || !_bySprite.TryGetValue(sprite, out var entry))
+                return sprite;
+            entry.handOuts++;
+            Retain(sprite);
+            return sprite;
+        }
+
+        public void ReleaseHandOut(Sprite sprite) {
+            if (sprite == null || !_bySprite.TryGetValue(sprite, out var entry) || entry.handOuts == 0)
+                return;
+            entry.handOuts--;
+            Release(entry, 1);
+        }
+
+        /// <summary>
+        /// Lets go of everything handed to scripts (i.e. when the JsEnv holding them is disposed).
+        /// </summary>
+        public void ReleaseHandOuts() {
+            foreach (var entry in _entries.Values) {
+                var count = entry.handOuts;
+                entry.handOuts = 0;
+                Release(entry, count);
+            }
+        }
+
+        void Release(Entry entry, int count) {
+            if (count == 0 || entry.refCount == 0)
+                return;
+            entry.refCount = Mathf.Max(0, entry.refCount - count);
+            if (entry.refCount == 0)
+                _lru.AddLast(entry.node);
+        }
+
+        /// <summary>
+        /// Evicts every unreferenced sprite (i.e. on reload, so edited images are picked up).
+        /// </summary>
+        public void Purge() {
+            while (_lru.First != null)
+                Evict(_lru.First.Value);
+        }
+
+        /// <summary>
+        /// Uploads pending pixel changes to the GPU.
+        /// </summary>
+        public void Flush() {
+            foreach (var page in _pages) {
+                if (page.dirty) {
+                    page.texture.Apply(false);
+                    page.dirty = false;
+                }
+            }
+        }
+
+        public void Dispose() {
+            foreach (var entry in _entries.Values)
+                DestroyObject(entry.sprite);
+            foreach (var page in _pages)
+                DestroyObject(page.texture);
+            _entries.Clear();
+            _bySprite.Clear();
+            _lru.Clear();
+            _pages.Clear();
+        }
+
+        bool TryAllocate(int width, int height, out Page page, out RectInt slot) {
+            while (true) {
+                foreach (var p in _pages) {
+                    if (p.TryAllocate(width, height, out slot)) {
+                        page = p;
+                        return true;
+                    }
+                }
+                if (_pages.Count < _maxPages) {
+                    page = new Page(_pageSize, _pages.Count);
+                    _pages.Add(page);
+                    return page.TryAllocate(width, height, out slot);
+                }
+                // Make room in a slot that's big enough by itself; evicting smaller ones wouldn't help
+                var victim = FindEvictable(width, height);
+                if (victim == null)
+                    break;
+                Evict(victim);
+            }
+            page = null;
+            slot = default;
+            return false;
+        }
+
+        /// <summary>
+        /// The least recently used unreferenced entry whose slot (gutter included) fits the given size, and that
+        /// wasn't used this frame.
+        /// </summary>
+        Entry FindEvictable(int width, int height) {
+            for (var node = _lru.First; node != null; node = node.Next) {
+                var slot = node.Value.slot;
+                if (slot.width >= width && slot.height >= height && node.Value.frame != Time.frameCount)
+                    return node.Value;
+            }
+            return null;
+        }
+
+        void Evict(Entry entry) {
+            _lru.Remove(entry.node);
+            _entries.Remove(entry.key);
+            _bySprite.Remove(entry.sprite);
+            DestroyObject(entry.sprite);
+            entry.page.Free(entry.slot);
+            if (--entry.page.entryCount == 0)
+                entry.page.Reset(); // Nothing left on it, so start packing it from scratch
+        }
+
+        static void DestroyObject(Object obj) {
+            if (obj == null)
+                return;
+            if (Application.isPlaying)
+                Object.Destroy(obj);
+            else
+                Object.DestroyImmediate(obj);
+        }
+
+        class Entry {
+            public readonly string key;
+            public readonly Page page;
+            public readonly RectInt slot;
+            public readonly Sprite sprite;
+            public readonly LinkedListNode<Entry> node;
+            public int refCount;
+            /// <summary>
+            /// How much of refCount is from HandOut()
+            /// </summary>
+            public int handOuts;
+            /// <summary>
+            /// Last frame it was looked up or added
+            /// </summary>
+            public int frame;
+
+            public Entry(string key, Page page, RectInt slot, Sprite sprite) {
+                this.key = key;
+                this.page = page;
+                this.slot = slot;
+                this.sprite = sprite;
+                node = new LinkedListNode<Entry>(this);
+            }
+        }
+
+        /// <summary>
+        /// One atlas texture, packed in horizontal shelves. Freed slots are kept per shelf and reused for images
+        /// that fit in them.
+        /// </summary>
+        class Page {
+            public readonly Texture2D texture;
+            public bool dirty;
+            public int entryCount;
+
+            readonly int _size;
+            readonly List<Shelf> _shelves = new List<Shelf>();
+            int _nextShelfY;
+
+            public Page(int size, int index) {
+                _size = size;
+                texture = new Texture2D(size, size, TextureFormat.RGBA32, false) {
+                    name = $"OneJS Image Atlas {index}",
+                    filterMode = FilterMode.Bilinear,
+                    wrapMode = TextureWrapMode.Clamp
+                };
+                var data = texture.GetPixelData<Color32>(0);
+                for (int i = 0; i < data.Length; i++)
+                    data[i] = default;
+                dirty = true;
+            }
+
+            public bool TryAllocate(int width, int height, out RectInt slot) {
+                // Reuse a freed slot first, then the end of a shelf that isn't much taller than the image
+                foreach (var shelf in _shelves) {
+                    for (int i = 0; i < shelf.free.Count; i++) {
+                        var free = shelf.free[i];
+                        if (free.width >= width && free.height >= height) {
+                            shelf.free.RemoveAt(i);
+                            slot = new RectInt(free.x, free.y, width, shelf.height);
+                            if (free.width > width)
+                                shelf.free.Add(new RectInt(free.x + width, free.y, free.width - width, shelf.height));
+                            return true;
+                        }
+                    }
+                }
+                foreach (var shelf in _shelves) {
+                    if (height <= shelf.height && height * 2 > shelf.height && shelf.x + width <= _size) {
+                        slot = new RectInt(shelf.x, shelf.y, width, shelf.height);
+                        shelf.x += width;
+                        return true;
+                    }
+                }
+                if (_nextShelfY + height <= _size && width <= _size) {
+                    var shelf = new Shelf { y = _nextShelfY, height = height, x = width };
+                    _shelves.Add(shelf);
+                    _nextShelfY += height;
+                    slot = new RectInt(0, shelf.y, width, height);
+                    return true;
+                }
+                slot = default;
+                return false;
+            }
+
+            public void Free(RectInt slot) {
+                foreach (var shelf in _shelves) {
+                    if (shelf.y == slot.y) {
+                        shelf.free.Add(slot);
+                        return;
+                    }
+                }
+            }
+
+            public void Reset() {
+                _shelves.Clear();
+                _nextShelfY = 0;
+            }
+
+            /// <summary>
+            /// Writes an image at (x, y) and extrudes its edges into the surrounding gutter.
+            /// </summary>
+            public void Blit(Color32[] pixels, int width, int height, int x, int y) {
+                var data = texture.GetPixelData<Color32>(0);
+                for (int row = -Padding; row < height + Padding; row++) {
+                    var srcRow = Mathf.Clamp(row, 0, height - 1) * width;
+                    var dst = (y + row) * _size + x;
+                    for (int col = -Padding; col < width + Padding; col++)
+                        data[dst + col] = pixels[srcRow + Mathf.Clamp(col, 0, width - 1)];
+                }
+                dirty = true;
+            }
+
+            class Shelf {
+                public int y;
+                public int height;
+                public int x;
+                public readonly List<RectInt> free = new List<RectInt>();
+            }
+        }
+    }
+}
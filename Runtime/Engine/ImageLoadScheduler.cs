@@ -0,0 +1,184 @@
+﻿using System;
+using System.Collections.Generic;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS {
+    /// <summary>
+    /// Queues image loads for elements (see Dom.Img) and starts at most MaxConcurrent of them at a time, those
+    /// closest to the viewport first. Lazy requests (loading="lazy") wait until their element is laid out within
+    /// LazyMargin pixels of the viewport. The viewport is the panel, narrowed down by any ScrollView the element is
+    /// in. Requests are re-evaluated on every Pump() (ScriptEngine calls it every frame), so scrolling is picked up.
+    ///
+    /// Main thread only.
+    /// </summary>
+    public class ImageLoadScheduler {
+        /// <summary>
+        /// Maximum number of loads in flight. 0 or less means unlimited.
+        /// </summary>
+        public int MaxConcurrent { get; set; }
+
+        /// <summary>
+        /// How close (in pixels) a lazy element has to get to the viewport before it starts loading.
+        /// </summary>
+        public float LazyMargin { get; set; }
+
+        public int QueuedCount => _queuedCount;
+        public int ActiveCount => _active.Count;
+
+        // Requests that leave the queue are only marked (see State) and dropped in one pass on the next Pump()
+        readonly List<ImageLoadRequest> _queue = new List<ImageLoadRequest>();
+        readonly HashSet<ImageLoadRequest> _active = new HashSet<ImageLoadRequest>();
+        readonly List<(ImageLoadRequest request, float distance)> _ready = new List<(ImageLoadRequest, float)>();
+        static readonly Predicate<ImageLoadRequest> NotQueued = r => r.state != ImageLoadRequest.State.Queued;
+        int _queuedCount;
+
+        public ImageLoadScheduler(int maxConcurrent = 6, float lazyMargin = 300) {
+            MaxConcurrent = maxConcurrent;
+            LazyMargin = lazyMargin;
+        }
+
+        /// <summary>
+        /// Queues a load. `start` is called once the request's turn comes, and has to call request.Complete()
+        /// when the load is done (successful or not). Starting happens on the next Pump(), so attributes set right
+        /// after still apply.
+        /// </summary>
+        public ImageLoadRequest Schedule(VisualElement element, bool lazy, Action<ImageLoadRequest> start) {
+            var request = new ImageLoadRequest(this, element, lazy, start);
+            _queue.Add(request);
+            _queuedCount++;
+            return request;
+        }
+
+        /// <summary>
+        /// Starts as many ready requests as there are free slots, closest to the viewport first.
+        /// </summary>
+        public void Pump() {
+            if (_queuedCount == 0)
+                _queue.Clear();
+            if (_queuedCount == 0 || (MaxConcurrent > 0 && _active.Count >= MaxConcurrent))
+                return;
+            _ready.Clear();
+            foreach (var request in _queue) {
+                if (request.state != ImageLoadRequest.State.Queued)
+                    continue;
+                var distance = DistanceToViewport(request.element);
+                // Lazy elements wait for layout; eager ones that aren't laid out yet are assumed to be visible
+                if (float.IsNaN(distance)) {
+                    if (request.lazy)
+                        continue;
+                    distance = 0;
+                }
+                if (request.lazy && distance > LazyMargin)
+                    continue;
+                _ready.Add((request, distance));
+            }
+            _ready.Sort((a, b) => a.distance.CompareTo(b.distance));
+            foreach (var (request, _) in _ready) {
+                if (MaxConcurrent > 0 && _active.Count >= MaxConcurrent)
+                    break;
+                _queuedCount--;
+                _active.Add(request);
+                request.state = ImageLoadRequest.State.Active;
+                try {
+                    request.start(request);
+                } catch (Exception e) {
+                    Debug.LogException(e);
+                    request.Complete();
+                }
+            }
+            _ready.Clear();
+            _queue.RemoveAll(NotQueued);
+        }
+
+        /// <summary>
+        /// Cancels every queued and in-flight request (i.e. when the document goes away on reload).
+        /// </summary>
+        public void CancelAll() {
+            foreach (var request in _queue.ToArray())
+                request.Cancel();
+            foreach (var request in new List<ImageLoadRequest>(_active))
+                request.Cancel();
+        }
+
+        internal void Finish(ImageLoadRequest request) {
+            if (!_active.Remove(request))
+                _queuedCount--; // Still in _queue, dropped on the next Pump()
+        }
+
+        /// <summary>
+        /// Pixels between the element and the viewport (0 if it's at least partly visible), infinity if it isn't
+        /// on a panel, and NaN if it hasn't been laid out yet.
+        /// </summary>
+        static float DistanceToViewport(VisualElement element) {
+            if (element.panel == null)
+                return float.PositiveInfinity;
+            var bound = element.worldBound;
+            if (float.IsNaN(bound.x) || float.IsNaN(bound.y) || float.IsNaN(bound.width) || float.IsNaN(bound.height))
+                return float.NaN;
+            var viewport = element.panel.visualTree.worldBound;
+            for (var ve = element.hierarchy.parent; ve != null; ve = ve.hierarchy.parent) {
+                if (ve is ScrollView scrollView)
+                    viewport = Intersect(viewport, scrollView.contentViewport.worldBound);
+            }
+            var dx = Mathf.Max(viewport.xMin - bound.xMax, bound.xMin - viewport.xMax, 0);
+            var dy = Mathf.Max(viewport.yMin - bound.yMax, bound.yMin - viewport.yMax, 0);
+            return Mathf.Max(dx, dy);
+        }
+
+        static Rect Intersect(Rect a, Rect b) {
+            var xMin = Mathf.Max(a.xMin, b.xMin);
+            var yMin = Mathf.Max(a.yMin, b.yMin);
+            // An empty intersection keeps its position, so distances to it still make sense
+            return Rect.MinMaxRect(xMin, yMin, Mathf.Max(xMin, Mathf.Min(a.xMax, b.xMax)),
+                Mathf.Max(yMin, Mathf.Min(a.yMax, b.yMax)));
+        }
+    }
+
+    public class ImageLoadRequest {
+        public enum State { Queued, Active, Done, Cancelled }
+
+        public State state { get; internal set; }
+        public bool isCancelled => state == State.Cancelled;
+
+        /// <summary>
+        /// Called if the request is cancelled while in flight, to abort the underlying load (if possible).
+        /// </summary>
+        public Action onCancel;
+
+        internal readonly VisualElement element;
+        internal bool lazy;
+        internal readonly Action<ImageLoadRequest> start;
+        readonly ImageLoadScheduler _scheduler;
+
+        internal ImageLoadRequest(ImageLoadScheduler scheduler, VisualElement element, bool lazy, Action<ImageLoadRequest> start) {
+            _scheduler = scheduler;
+            this.element = element;
+            this.lazy = lazy;
+            this.start = start;
+        }
+
+        /// <summary>
+        /// Frees the request's slot. Called by whoever started the load once it's done.
+        /// </summary>
+        public void Complete() {
+            if (state == State.Done || state == State.Cancelled)
+                return;
+            state = State.Done;
+            _scheduler.Finish(this);
+        }
+
+        /// <summary>
+        /// Drops a queued request, or frees the slot of an in-flight one and aborts it (see onCancel).
+        /// </summary>
+        public void Cancel() {
+            if (state == State.Done || state == State.Cancelled)
+                return;
+            var wasActive = state == State.Active;
+            state = State.Cancelled;
+            _scheduler.Finish(this);
+            if (wasActive)
+                onCancel?.Invoke();
+        }
+    }
+}
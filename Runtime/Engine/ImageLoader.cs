@@ -0,0 +1,132 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Threading.Tasks;
+using OneJS.Utils;
+using UnityEngine;
+using Object = UnityEngine.Object;
+
+namespace OneJS {
+    /// <summary>
+    /// Loads images without stalling the main thread. Files are read on the thread pool, PNGs are decoded to raw
+    /// pixels on the thread pool too (see PngDecoder), and only the texture upload (SetPixelData, plus generating
+    /// mipmaps) happens on the main thread. Other formats (i.e. JPG) are still decoded by Texture2D.LoadImage on
+    /// the main thread, but are read asynchronously. Concurrent requests for the same path share one load.
+    ///
+    /// Has to be created on the main thread; callbacks are invoked there.
+    /// </summary>
+    public class ImageLoader {
+        readonly ScriptEngine _engine;
+        readonly TaskScheduler _mainThread;
+        readonly Dictionary<string, List<Action<Texture2D>>> _pending = new Dictionary<string, List<Action<Texture2D>>>();
+        int _generation;
+
+        public ImageLoader(ScriptEngine engine) {
+            _engine = engine;
+            _mainThread = TaskScheduler.FromCurrentSynchronizationContext();
+        }
+
+        /// <summary>
+        /// Number of loads in flight.
+        /// </summary>
+        public int PendingCount => _pending.Count;
+
+        /// <summary>
+        /// Loads an image and calls back (on the main thread) with the texture, or null if it couldn't be loaded.
+        /// Every load creates a new texture; caching is up to the caller.
+        /// </summary>
+        /// <param name="path">Relative to the WorkingDir, or a full path</param>
+        /// <param name="exclusive">Only coalesced with other exclusive loads, so the callbacks may destroy the
+        /// texture once they're done with it (i.e. after copying it into the ImageAtlas). Shared loads hand the same
+        /// texture to every callback.</param>
+        public void Load(string path, FilterMode filterMode, Action<Texture2D> callback, bool exclusive = false) {
+            var key = (exclusive ? "exclusive:" : "") + filterMode + ":" + path;
+            if (_pending.TryGetValue(key, out var callbacks)) {
+                callbacks.Add(callback);
+                return;
+            }
+            _pending[key] = new List<Action<Texture2D>> { callback };
+
+            var generation = _generation;
+            Task<byte[]> read;
+            try {
+                read = _engine.ReadAllBytesAsync(path);
+            } catch (Exception e) {
+                read = Task.FromException<byte[]>(e);
+            }
+            read.ContinueWith(t => Decode(t.Result), TaskScheduler.Default)
+                .ContinueWith(t => Complete(key, path, filterMode, generation, t), _mainThread);
+        }
+
+        /// <summary>
+        /// Drops all pending callbacks (i.e. on reload, when they'd call into a disposed JsEnv). Loads in flight
+        /// are discarded when they finish.
+        /// </summary>
+        public void Cancel() {
+            _generation++;
+            _pending.Clear();
+        }
+
+        /// <summary>
+        /// The thread pool half of a load: PNGs to raw pixels, anything else is kept encoded for CreateTexture.
+        /// Also used by WebApi for disk-cached images.
+        /// </summary>
+        internal static DecodedImage Decode(byte[] bytes) {
+            if (!PngDecoder.IsPng(bytes))
+                return new DecodedImage { encoded = bytes };
+            var pixels = PngDecoder.Decode(bytes, out var width, out var height);
+            return new DecodedImage { pixels = pixels, width = width, height = height };
+        }
+
+        void Complete(string key, string path, FilterMode filterMode, int generation, Task<DecodedImage> task) {
+            if (generation != _generation)
+                return;
+            Texture2D texture = null;
+            if (task.IsFaulted) {
+                Debug.LogError($"Failed to load image: {path}");
+            } else {
+                texture = CreateTexture(task.Result, filterMode);
+                if (texture == null)
+                    Debug.LogError($"Failed to load image: {path}");
+            }
+            if (!_pending.TryGetValue(key, out var callbacks))
+                return;
+            _pending.Remove(key);
+            foreach (var callback in callbacks) {
+                try {
+                    callback(texture);
+                } catch (Exception e) {
+                    Debug.LogException(e);
+                }
+            }
+        }
+
+        /// <summary>
+        /// The main thread half: uploads the pixels (or decodes other formats with LoadImage). Null if the image
+        /// couldn't be decoded.
+        /// </summary>
+        internal static Texture2D CreateTexture(DecodedImage image, FilterMode filterMode) {
+            Texture2D texture;
+            if (image.pixels != null) {
+                // With mipmaps, same as what LoadImage gives the sync path (Document.loadImage)
+                texture = new Texture2D(image.width, image.height, TextureFormat.RGBA32, true);
+                texture.SetPixelData(image.pixels, 0);
+                texture.Apply(true);
+            } else {
+                texture = new Texture2D(2, 2); // Create an empty Texture; size doesn't matter
+                if (!texture.LoadImage(image.encoded)) {
+                    Object.Destroy(texture);
+                    return null;
+                }
+            }
+            texture.filterMode = filterMode;
+            return texture;
+        }
+
+        internal class DecodedImage {
+            public byte[] pixels; // RGBA32, bottom row first
+            public int width;
+            public int height;
+            public byte[] encoded; // Formats that aren't decoded off the main thread
+        }
+    }
+}
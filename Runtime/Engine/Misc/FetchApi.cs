@@ -0,0 +1,291 @@
+﻿using System;
+using System.Collections;
+using System.Collections.Generic;
+using System.Text;
+using Newtonsoft.Json;
+using Puerts;
+using UnityEngine;
+using UnityEngine.Networking;
+
+namespace OneJS {
+    /// <summary>
+    /// Backs the JS `fetch` global (see Resources/onejs/fetch.js.txt). Bodies go both ways as ArrayBuffers (or
+    /// strings), never through text or base64 conversions, and responses are streamed: whatever arrived during a
+    /// frame is handed to JS in one chunk.
+    ///
+    /// Disposing (on reload) aborts every request in flight, so nothing calls into a disposed JsEnv.
+    /// </summary>
+    public class FetchApi : IDisposable {
+        readonly HashSet<FetchRequest> _active = new HashSet<FetchRequest>();
+
+        public int ActiveCount => _active.Count;
+
+        /// <summary>
+        /// Creates a request. Nothing happens until its send() is called.
+        /// </summary>
+        /// <param name="headersJson">Request headers as a JSON object, or null</param>
+        /// <param name="bodyText">String body, or null</param>
+        /// <param name="bodyBytes">Binary body, or null</param>
+        /// <param name="onEvent">Called with a FetchRequest.Event code whenever there's something to pick up</param>
+        public FetchRequest request(string url, string method, string headersJson, string bodyText, ArrayBuffer bodyBytes,
+            Action<int> onEvent) {
+            var headers = string.IsNullOrEmpty(headersJson)
+                ? new Dictionary<string, string>()
+                : JsonConvert.DeserializeObject<Dictionary<string, string>>(headersJson);
+            byte[] body = null;
+            if (bodyBytes?.Bytes != null) {
+                body = bodyBytes.Bytes;
+                if (bodyBytes.Count != body.Length) {
+                    body = new byte[bodyBytes.Count];
+                    Buffer.BlockCopy(bodyBytes.Bytes, 0, body, 0, body.Length);
+                }
+            } else if (bodyText != null) {
+                body = Encoding.UTF8.GetBytes(bodyText);
+                if (!ContainsHeader(headers, "Content-Type"))
+                    headers["Content-Type"] = "text/plain;charset=UTF-8";
+            }
+            var request = new FetchRequest(this, url, string.IsNullOrEmpty(method) ? "GET" : method.ToUpperInvariant(),
+                headers, body, onEvent);
+            _active.Add(request);
+            return request;
+        }
+
+        public void Dispose() {
+            foreach (var request in new List<FetchRequest>(_active))
+                request.Cancel();
+            _active.Clear();
+        }
+
+        internal void Finish(FetchRequest request) {
+            _active.Remove(request);
+        }
+
+        static bool ContainsHeader(Dictionary<string, string> headers, string name) {
+            foreach (var key in headers.Keys) {
+                if (string.Equals(key, name, StringComparison.OrdinalIgnoreCase))
+                    return true;
+            }
+            return false;
+        }
+    }
+
+    /// <summary>
+    /// One fetch. JS gets Event codes through its callback and pulls the details (status, headers, body chunks).
+    /// </summary>
+    public class FetchRequest {
+        public enum Event {
+            Headers = 1,
+            Data = 2,
+            Done = 3,
+            Error = 4
+        }
+
+        public int status { get; private set; }
+        public string url { get; private set; }
+        public string error { get; private set; }
+        public bool aborted { get; private set; }
+
+        readonly FetchApi _api;
+        readonly string _method;
+        readonly Dictionary<string, string> _headers;
+        readonly byte[] _body;
+        Action<int> _onEvent;
+        Coroutine _coroutine;
+        UnityWebRequest _request;
+        ChunkHandler _handler;
+        string _responseHeaders = "{}";
+        bool _headersSent;
+        bool _finished;
+
+        internal FetchRequest(FetchApi api, string url, string method, Dictionary<string, string> headers, byte[] body,
+            Action<int> onEvent) {
+            _api = api;
+            this.url = url;
+            _method = method;
+            _headers = headers;
+            _body = body;
+            _onEvent = onEvent;
+        }
+
+        /// <summary>
+        /// Response headers as a JSON object (names lowercased, as in the Fetch API).
+        /// </summary>
+        public string getResponseHeaders() {
+            return _responseHeaders;
+        }
+
+        /// <summary>
+        /// Takes everything received since the last call, or null if there's nothing new.
+        /// </summary>
+        public ArrayBuffer readChunk() {
+            var bytes = _handler?.Take();
+            return bytes != null ? new ArrayBuffer(bytes) : null;
+        }
+
+        /// <summary>
+        /// Starts the request.
+        /// </summary>
+        public void send() {
+            if (_coroutine == null && !_finished)
+                _coroutine = StaticCoroutine.Start(Run());
+        }
+
+        /// <summary>
+        /// Aborts the request. JS gets an Error event (with `aborted` set) unless it's already done. A request
+        /// aborted before send() fails on send() without going out.
+        /// </summary>
+        public void abort() {
+            if (_finished)
+                return;
+            aborted = true;
+            _request?.Abort();
+        }
+
+        /// <summary>
+        /// Aborts without calling back into JS (i.e. the JsEnv is going away).
+        /// </summary>
+        internal void Cancel() {
+            _onEvent = null;
+            StaticCoroutine.Stop(_coroutine);
+            _request?.Abort();
+            Cleanup();
+        }
+
+        internal IEnumerator Run() {
+            if (aborted) {
+                // Aborted before send()
+                Fail("The operation was aborted.");
+                yield break;
+            }
+            _handler = new ChunkHandler();
+            _request = new UnityWebRequest(url, _method) { downloadHandler = _handler };
+            if (_body != null)
+                _request.uploadHandler = new UploadHandlerRaw(_body);
+            foreach (var kv in _headers) {
+                try {
+                    _request.SetRequestHeader(kv.Key, kv.Value);
+                } catch (InvalidOperationException e) {
+                    Debug.LogWarning($"fetch: couldn't set the {kv.Key} header: {e.Message}");
+                }
+            }
+            if (_request.uploadHandler != null && _request.GetRequestHeader("Content-Type") is string contentType &&
+                contentType.Length > 0) {
+                _request.uploadHandler.contentType = contentType;
+            }
+
+            var op = _request.SendWebRequest();
+            while (!op.isDone) {
+                Flush();
+                if (_request == null)
+                    yield break; // Cancelled from a callback
+                yield return null;
+            }
+            Flush();
+            if (_request == null)
+                yield break;
+
+            if (aborted) {
+                Fail("The operation was aborted.");
+            } else if (_request.result == UnityWebRequest.Result.ConnectionError ||
+                       _request.result == UnityWebRequest.Result.DataProcessingError) {
+                Fail(_request.error);
+            } else {
+                // HTTP error statuses (ProtocolError) are still responses as far as fetch is concerned
+                SendHeaders();
+                _finished = true;
+                Raise(Event.Done);
+                Cleanup();
+            }
+        }
+
+        /// <summary>
+        /// Reports headers once they're in, and whatever body arrived this frame.
+        /// </summary>
+        void Flush() {
+            if (_request.responseCode > 0)
+                SendHeaders();
+            if (_headersSent && _handler.HasData)
+                Raise(Event.Data);
+        }
+
+        void SendHeaders() {
+            if (_headersSent)
+                return;
+            _headersSent = true;
+            status = (int)_request.responseCode;
+            url = _request.url;
+            var headers = new Dictionary<string, string>();
+            var responseHeaders = _request.GetResponseHeaders();
+            if (responseHeaders != null) {
+                foreach (var kv in responseHeaders)
+                    headers[kv.Key.ToLowerInvariant()] = kv.Value;
+            }
+            _responseHeaders = JsonConvert.SerializeObject(headers);
+            Raise(Event.Headers);
+        }
+
+        void Fail(string message) {
+            error = message;
+            _finished = true;
+            Raise(Event.Error);
+            Cleanup();
+        }
+
+        void Raise(Event e) {
+            try {
+                _onEvent?.Invoke((int)e);
+            } catch (Exception ex) {
+                Debug.LogException(ex);
+            }
+        }
+
+        void Cleanup() {
+            _finished = true;
+            _api.Finish(this);
+            _request?.Dispose();
+            _request = null;
+        }
+
+        /// <summary>
+        /// Collects the body as it streams in. Unity calls ReceiveData on the main thread, with a reused buffer.
+        /// </summary>
+        class ChunkHandler : DownloadHandlerScript {
+            readonly List<byte[]> _chunks = new List<byte[]>();
+            int _length;
+
+            public ChunkHandler() : base(new byte[64 * 1024]) {
+            }
+
+            public bool HasData => _length > 0;
+
+            public byte[] Take() {
+                if (_length == 0)
+                    return null;
+                byte[] bytes;
+                if (_chunks.Count == 1) {
+                    bytes = _chunks[0];
+                } else {
+                    bytes = new byte[_length];
+                    var offset = 0;
+                    foreach (var chunk in _chunks) {
+                        Buffer.BlockCopy(chunk, 0, bytes, offset, chunk.Length);
+                        offset += chunk.Length;
+                    }
+                }
+                _chunks.Clear();
+                _length = 0;
+                return bytes;
+            }
+
+            protected override bool ReceiveData(byte[] data, int dataLength) {
+                if (data == null || dataLength <= 0)
+                    return true;
+                var chunk = new byte[dataLength];
+                Buffer.BlockCopy(data, 0, chunk, 0, dataLength);
+                _chunks.Add(chunk);
+                _length += dataLength;
+                return true;
+            }
+        }
+    }
+}
@@ -0,0 +1,327 @@
+﻿using System;
+using System.Collections;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using Newtonsoft.Json;
+using UnityEngine;
+
+namespace OneJS {
+    /// <summary>
+    /// Persistent HTTP cache for downloaded files (used by WebApi for images), so they survive restarts.
+    /// Follows the usual private-cache rules: Cache-Control (no-store, no-cache, max-age), Expires/Date/Age, and a
+    /// heuristic lifetime from Last-Modified. Stale entries are revalidated with conditional requests (ETag and
+    /// Last-Modified). Bodies are stored one file per URL; an index (index.json) is loaded once at startup so
+    /// lookups don't touch the disk, and written back at most once per SaveDelay (and on quit). Least recently used
+    /// entries are dropped once maxBytes is exceeded.
+    ///
+    /// Main thread only.
+    /// </summary>
+    public class HttpDiskCache {
+        const string IndexFileName = "index.json";
+        /// <summary>
+        /// Seconds index changes are batched for before it's written
+        /// </summary>
+        const float SaveDelay = 2f;
+        // Heuristic freshness for responses with only Last-Modified: 10% of its age, capped (RFC 9111 4.2.2)
+        static readonly TimeSpan MaxHeuristicLifetime = TimeSpan.FromDays(1);
+
+        static HttpDiskCache _default;
+
+        /// <summary>
+        /// The cache under persistentDataPath, shared by every WebApi.
+        /// </summary>
+        public static HttpDiskCache Default => _default ??= new HttpDiskCache(Path.Combine(Application.persistentDataPath, "onejs-http-cache"));
+
+        public string Dir => _dir;
+        public long MaxBytes { get; set; }
+        public int Count => _index.entries.Count;
+
+        readonly string _dir;
+        Index _index;
+        bool _saveScheduled;
+
+        public HttpDiskCache(string dir, long maxBytes = 256L * 1024 * 1024) {
+            _dir = dir;
+            MaxBytes = maxBytes;
+            Directory.CreateDirectory(dir);
+            _index = LoadIndex();
+            Application.quitting += Flush;
+        }
+
+        /// <summary>
+        /// Writes pending index changes right away.
+        /// </summary>
+        public void Flush() {
+            if (!_saveScheduled)
+                return;
+            _saveScheduled = false;
+            SaveIndex();
+        }
+
+        /// <summary>
+        /// Looks up a URL. Entries whose file has gone missing are dropped.
+        /// </summary>
+        public bool TryGetEntry(string url, out HttpCacheEntry entry) {
+            if (_index.entries.TryGetValue(url, out entry)) {
+                if (File.Exists(GetPath(entry))) {
+                    entry.lastUsed = Now();
+                    return true;
+                }
+                Remove(url);
+            }
+            entry = null;
+            return false;
+        }
+
+        public bool IsFresh(HttpCacheEntry entry) {
+            return Now() < entry.expires;
+        }
+
+        public string GetPath(HttpCacheEntry entry) {
+            return Path.Combine(_dir, entry.file);
+        }
+
+        /// <summary>
+        /// Request headers that turn a request for a cached URL into a conditional one (answered with 304 if the
+        /// cached copy is still good).
+        /// </summary>
+        public static IEnumerable<KeyValuePair<string, string>> GetValidators(HttpCacheEntry entry) {
+            if (!string.IsNullOrEmpty(entry.etag))
+                yield return new KeyValuePair<string, string>("If-None-Match", entry.etag);
+            if (!string.IsNullOrEmpty(entry.lastModified))
+                yield return new KeyValuePair<string, string>("If-Modified-Since", entry.lastModified);
+        }
+
+        /// <summary>
+        /// Stores a 200 response. Returns null if it isn't cacheable (no-store, or nothing to keep it fresh or
+        /// revalidate it by).
+        /// </summary>
+        /// <param name="getHeader">Response header lookup, i.e. UnityWebRequest.GetResponseHeader</param>
+        public HttpCacheEntry Store(string url, byte[] body, Func<string, string> getHeader) {
+            var cacheControl = ParseCacheControl(getHeader("Cache-Control"));
+            if (cacheControl.ContainsKey("no-store")) {
+                Remove(url);
+                return null;
+            }
+            var entry = new HttpCacheEntry {
+                file = HashUrl(url),
+                etag = getHeader("ETag"),
+                lastModified = getHeader("Last-Modified"),
+                size = body.Length,
+                lastUsed = Now()
+            };
+            entry.expires = ComputeExpiry(getHeader, cacheControl, Now());
+            if (entry.expires <= Now() && string.IsNullOrEmpty(entry.etag) && string.IsNullOrEmpty(entry.lastModified)) {
+                Remove(url);
+                return null;
+            }
+
+            var path = GetPath(entry);
+            var tmpPath = path + ".tmp";
+            File.WriteAllBytes(tmpPath, body);
+            if (File.Exists(path))
+                File.Delete(path);
+            File.Move(tmpPath, path);
+
+            _index.entries[url] = entry;
+            Trim();
+            ScheduleSave();
+            return entry;
+        }
+
+        /// <summary>
+        /// Updates an entry after a 304 Not Modified: new freshness lifetime (and validators, if sent).
+        /// </summary>
+        public void Revalidated(string url, HttpCacheEntry entry, Func<string, string> getHeader) {
+            var etag = getHeader("ETag");
+            var lastModified = getHeader("Last-Modified");
+            if (!string.IsNullOrEmpty(etag))
+                entry.etag = etag;
+            if (!string.IsNullOrEmpty(lastModified))
+                entry.lastModified = lastModified;
+            // Freshness headers of a 304 describe the stored response, whose Last-Modified may not be resent
+            entry.expires = ComputeExpiry(h => h == "Last-Modified" ? entry.lastModified : getHeader(h),
+                ParseCacheControl(getHeader("Cache-Control")), Now());
+            entry.lastUsed = Now();
+            _index.entries[url] = entry;
+            ScheduleSave();
+        }
+
+        public void Remove(string url) {
+            if (!_index.entries.TryGetValue(url, out var entry))
+                return;
+            _index.entries.Remove(url);
+            DeleteFile(entry);
+            ScheduleSave();
+        }
+
+        public void Clear() {
+            foreach (var entry in _index.entries.Values)
+                DeleteFile(entry);
+            _index.entries.Clear();
+            ScheduleSave();
+        }
+
+        /// <summary>
+        /// Absolute expiry time (Unix ms) of a response received at `now`. `now` or earlier means it has to be
+        /// revalidated before every use.
+        /// </summary>
+        public static long ComputeExpiry(Func<string, string> getHeader, Dictionary<string, string> cacheControl, long now) {
+            if (cacheControl.ContainsKey("no-cache"))
+                return now;
+            var age = ParseSeconds(getHeader("Age")) ?? 0;
+            if (cacheControl.TryGetValue("max-age", out var maxAgeValue) && ParseSeconds(maxAgeValue) is long maxAge)
+                return now + (maxAge - age) * 1000;
+            var date = ParseHttpDate(getHeader("Date"));
+            var expires = getHeader("Expires");
+            if (!string.IsNullOrEmpty(expires)) {
+                // An invalid Expires (i.e. "0") means already expired
+                var expiresDate = ParseHttpDate(expires);
+                if (expiresDate == null)
+                    return now;
+                return now + (long)(expiresDate.Value - (date ?? DateTimeOffset.FromUnixTimeMilliseconds(now))).TotalMilliseconds - age * 1000;
+            }
+            var lastModified = ParseHttpDate(getHeader("Last-Modified"));
+            if (lastModified != null) {
+                var sinceModified = (date ?? DateTimeOffset.FromUnixTimeMilliseconds(now)) - lastModified.Value;
+                if (sinceModified > TimeSpan.Zero) {
+                    var lifetime = TimeSpan.FromTicks(Math.Min(sinceModified.Ticks / 10, MaxHeuristicLifetime.Ticks));
+                    return now + (long)lifetime.TotalMilliseconds - age * 1000;
+                }
+            }
+            return now;
+        }
+
+        /// <summary>
+        /// Directive name (lowercase) -> value (empty for valueless directives).
+        /// </summary>
+        public static Dictionary<string, string> ParseCacheControl(string header) {
+            var directives = new Dictionary<string, string>();
+            if (string.IsNullOrEmpty(header))
+                return directives;
+            foreach (var part in header.Split(',')) {
+                var directive = part.Trim();
+                if (directive.Length == 0)
+                    continue;
+                var eq = directive.IndexOf('=');
+                if (eq < 0)
+                    directives[directive.ToLowerInvariant()] = "";
+                else
+                    directives[directive.Substring(0, eq).Trim().ToLowerInvariant()] = directive.Substring(eq + 1).Trim().Trim('"');
+            }
+            return directives;
+        }
+
+        static long? ParseSeconds(string value) {
+            return long.TryParse(value, NumberStyles.None, CultureInfo.InvariantCulture, out var seconds) ? seconds : (long?)null;
+        }
+
+        static DateTimeOffset? ParseHttpDate(string value) {
+            if (string.IsNullOrEmpty(value))
+                return null;
+            return DateTimeOffset.TryParseExact(value.Trim(), "r", CultureInfo.InvariantCulture,
+                DateTimeStyles.AssumeUniversal, out var date) ? date : (DateTimeOffset?)null;
+        }
+
+        static long Now() {
+            return DateTimeOffset.UtcNow.ToUnixTimeMilliseconds();
+        }
+
+        static string HashUrl(string url) {
+            using (var sha = SHA1.Create()) {
+                var bytes = sha.ComputeHash(Encoding.UTF8.GetBytes(url));
+                return BitConverter.ToString(bytes).Replace("-", "").ToLowerInvariant();
+            }
+        }
+
+        void Trim() {
+            var total = _index.entries.Values.Sum(e => e.size);
+            if (MaxBytes <= 0 || total <= MaxBytes)
+                return;
+            foreach (var kv in _index.entries.OrderBy(kv => kv.Value.lastUsed).ToList()) {
+                if (total <= MaxBytes)
+                    break;
+                _index.entries.Remove(kv.Key);
+                DeleteFile(kv.Value);
+                total -= kv.Value.size;
+            }
+        }
+
+        void DeleteFile(HttpCacheEntry entry) {
+            try {
+                File.Delete(GetPath(entry));
+            } catch (Exception e) when (e is IOException || e is UnauthorizedAccessException) {
+                Debug.LogWarning($"Couldn't delete {entry.file} from the HTTP cache: {e.Message}");
+            }
+        }
+
+        Index LoadIndex() {
+            var path = Path.Combine(_dir, IndexFileName);
+            try {
+                if (File.Exists(path))
+                    return JsonConvert.DeserializeObject<Index>(File.ReadAllText(path)) ?? new Index();
+            } catch (Exception e) {
+                Debug.LogWarning($"Couldn't read the HTTP cache index, starting over: {e.Message}");
+            }
+            return new Index();
+        }
+
+        void ScheduleSave() {
+            if (_saveScheduled)
+                return;
+            _saveScheduled = true;
+            // Coroutines don't run in edit mode
+            if (Application.isPlaying)
+                StaticCoroutine.Start(SaveLater());
+            else
+                Flush();
+        }
+
+        IEnumerator SaveLater() {
+            yield return new WaitForSecondsRealtime(SaveDelay);
+            Flush();
+        }
+
+        /// <summary>
+        /// Failures are only logged: the bodies are still there, and the index is written again on the next change.
+        /// </summary>
+        void SaveIndex() {
+            var path = Path.Combine(_dir, IndexFileName);
+            var tmpPath = path + ".tmp";
+            try {
+                File.WriteAllText(tmpPath, JsonConvert.SerializeObject(_index));
+                if (File.Exists(path))
+                    File.Delete(path);
+                File.Move(tmpPath, path);
+            } catch (Exception e) when (e is IOException || e is UnauthorizedAccessException) {
+                Debug.LogWarning($"Couldn't write the HTTP cache index: {e.Message}");
+            }
+        }
+
+        [Serializable]
+        class Index {
+            public int version = 1;
+            public Dictionary<string, HttpCacheEntry> entries = new Dictionary<string, HttpCacheEntry>();
+        }
+    }
+
+    [Serializable]
+    public class HttpCacheEntry {
+        /// <summary>
+        /// Body file name, relative to the cache dir
+        /// </summary>
+        public string file;
+        public string etag;
+        public string lastModified;
+        /// <summary>
+        /// Unix time (ms) until which the entry can be used without revalidating
+        /// </summary>
+        public long expires;
+        public long lastUsed;
+        public long size;
+    }
+}
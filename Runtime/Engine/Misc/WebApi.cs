@@ -1,18 +1,39 @@
 ﻿using System;
 using System.Collections;
 using System.Collections.Generic;
+using System.IO;
+using System.Threading.Tasks;
 using Puerts;
 using UnityEngine;
 using UnityEngine.Networking;
 
 namespace OneJS {
     /// <summary>
-    /// Caches images and coalesces multiple requests for the same image.
+    /// Caches images (in memory in a TextureCache, and on disk in an HttpDiskCache, both keyed by URL) and
+    /// coalesces multiple requests for the same image. Textures given to getImage callbacks aren't retained: the
+    /// receiver shows them on an element (or retains them itself) before the TextureCache may evict them.
     /// Supports custom headers and an optional force-refresh mode.
     /// </summary>
     public class WebApi {
-        Dictionary<string, Texture2D> _imageCache = new();
+        TextureCache _textureCache;
+        HttpDiskCache _diskCache;
         Dictionary<string, List<Action<Texture2D>>> _ongoingRequests = new Dictionary<string, List<Action<Texture2D>>>();
+        Dictionary<List<Action<Texture2D>>, UnityWebRequest> _inFlight = new Dictionary<List<Action<Texture2D>>, UnityWebRequest>(); // Keyed by waiting list
+
+        /// <param name="textureCache">Usually the ScriptEngine's (see ScriptEngine.TextureCache). A private,
+        /// unbounded one is used if null.</param>
+        /// <param name="diskCache">HttpDiskCache.Default if null. Not used on WebGL, whose persistent storage isn't a
+        /// plain file system (downloads still go through the browser's own HTTP cache there).</param>
+        public WebApi(TextureCache textureCache = null, HttpDiskCache diskCache = null) {
+            _textureCache = textureCache ?? new TextureCache();
+            _diskCache = diskCache;
+        }
+
+#if UNITY_WEBGL && !UNITY_EDITOR
+        HttpDiskCache DiskCache => null;
+#else
+        HttpDiskCache DiskCache => _diskCache ??= HttpDiskCache.Default;
+#endif
 
         public Coroutine getText(string uri, Action<string> callback, string headersJson = null) {
             Dictionary<string, string> headers = null;
@@ -44,7 +65,7 @@ namespace OneJS {
                 headers = Newtonsoft.Json.JsonConvert.DeserializeObject<Dictionary<string, string>>(headersJson);
             }
             if (!forceRefresh) {
-                if (_imageCache.TryGetValue(url, out var value)) {
+                if (_textureCache.TryGet(url, out var value)) {
                     callback(value);
                     return null;
                 }
@@ -52,56 +73,141 @@ namespace OneJS {
                     _ongoingRequests[url].Add(callback);
                     return null;
                 }
-                _ongoingRequests[url] = new List<Action<Texture2D>> { callback };
+                var waiting = new List<Action<Texture2D>> { callback };
+                _ongoingRequests[url] = waiting;
 
-                return StaticCoroutine.Start(GetImageCo(url, headers));
+                return StaticCoroutine.Start(GetImageCo(url, headers, waiting));
             } else {
                 return StaticCoroutine.Start(GetImageCoForced(url, headers, callback));
             }
         }
 
-        IEnumerator GetImageCo(string url, Dictionary<string, string> headers) {
-            using (UnityWebRequest request = UnityWebRequestTexture.GetTexture(url)) {
-                if (headers != null) {
-                    foreach (var kv in headers) {
-                        request.SetRequestHeader(kv.Key, kv.Value);
-                    }
-                }
-                yield return request.SendWebRequest();
-                Texture2D texture = null;
-                if (request.result == UnityWebRequest.Result.Success) {
-                    texture = ((DownloadHandlerTexture)request.downloadHandler).texture;
-                    _imageCache[url] = texture;
-                } else {
-                    Debug.LogError(request.result);
-                }
+        /// <summary>
+        /// Stops waiting for an image requested with getImage: the callback won't be called. The download is aborted
+        /// if nobody else is waiting for it.
+        /// </summary>
+        public void cancelImage(string url, Action<Texture2D> callback) {
+            if (!_ongoingRequests.TryGetValue(url, out var callbacks))
+                return;
+            callbacks.Remove(callback);
+            if (callbacks.Count > 0)
+                return;
+            _ongoingRequests.Remove(url);
+            if (_inFlight.TryGetValue(callbacks, out var request))
+                request.Abort();
+        }
 
-                if (_ongoingRequests.TryGetValue(url, out var callbacks)) {
-                    _ongoingRequests.Remove(url);
-                    foreach (var cb in callbacks)
-                        cb(texture);
-                }
-            }
+        /// <param name="waiting">The callbacks waiting for this download. It's been cancelled once that list isn't
+        /// the one in _ongoingRequests anymore (a new download may have been started for the same URL since).</param>
+        IEnumerator GetImageCo(string url, Dictionary<string, string> headers, List<Action<Texture2D>> waiting) {
+            Texture2D texture = null;
+            yield return FetchImage(url, headers, waiting, tex => texture = tex);
+            if (texture != null)
+                texture = _textureCache.Add(url, texture);
+            if (!IsWaiting(url, waiting))
+                yield break;
+            _ongoingRequests.Remove(url);
+            foreach (var cb in waiting)
+                cb(texture);
+        }
+
+        bool IsWaiting(string url, List<Action<Texture2D>> waiting) {
+            return _ongoingRequests.TryGetValue(url, out var current) && current == waiting;
         }
 
         IEnumerator GetImageCoForced(string url, Dictionary<string, string> headers, Action<Texture2D> callback) {
+            Texture2D texture = null;
+            yield return FetchImage(url, headers, null, tex => texture = tex);
+            if (texture != null) {
+                // Update the cache so future calls get the fresh image. The stale one is destroyed once
+                // nothing displays it anymore.
+                _textureCache.Remove(url);
+                texture = _textureCache.Add(url, texture);
+            }
+            callback(texture);
+        }
+
+        /// <summary>
+        /// Gets an image through the disk cache (see HttpDiskCache): fresh entries are used as is, stale ones are
+        /// revalidated with a conditional request, and anything else is downloaded (and stored if cacheable).
+        /// Forced refreshes (no waiting list) always download it again, and can't be cancelled.
+        /// </summary>
+        IEnumerator FetchImage(string url, Dictionary<string, string> headers, List<Action<Texture2D>> waiting, Action<Texture2D> done) {
+            var diskCache = DiskCache;
+            var forceRefresh = waiting == null;
+            HttpCacheEntry entry = null;
+            var cached = !forceRefresh && diskCache != null && diskCache.TryGetEntry(url, out entry);
+            if (cached && diskCache.IsFresh(entry)) {
+                Texture2D fromDisk = null;
+                yield return LoadCachedImage(entry, tex => fromDisk = tex);
+                if (fromDisk != null) {
+                    done(fromDisk);
+                    yield break;
+                }
+                // Unreadable, so download it again
+                diskCache.Remove(url);
+                cached = false;
+            }
+
+            // DownloadHandlerTexture decodes off the main thread, and still keeps the raw body for the disk cache
             using (UnityWebRequest request = UnityWebRequestTexture.GetTexture(url)) {
                 if (headers != null) {
                     foreach (var kv in headers) {
                         request.SetRequestHeader(kv.Key, kv.Value);
                     }
                 }
+                if (cached) {
+                    foreach (var kv in HttpDiskCache.GetValidators(entry)) {
+                        request.SetRequestHeader(kv.Key, kv.Value);
+                    }
+                }
+                if (!forceRefresh)
+                    _inFlight[waiting] = request;
                 yield return request.SendWebRequest();
-                Texture2D texture = null;
-                if (request.result == UnityWebRequest.Result.Success) {
-                    texture = ((DownloadHandlerTexture)request.downloadHandler).texture;
-                    // Update the cache so future calls get the fresh image.
-                    _imageCache[url] = texture;
-                } else {
-                    Debug.LogError(request.result);
+                if (!forceRefresh)
+                    _inFlight.Remove(waiting);
+
+                if (!forceRefresh && !IsWaiting(url, waiting)) {
+                    // Cancelled (see cancelImage)
+                    done(null);
+                    yield break;
+                }
+                if (cached && request.responseCode == 304) {
+                    diskCache.Revalidated(url, entry, request.GetResponseHeader);
+                    yield return LoadCachedImage(entry, done);
+                    yield break;
+                }
+                if (request.result != UnityWebRequest.Result.Success) {
+                    Debug.LogError($"Failed to load image: {url} ({request.error})");
+                    done(null);
+                    yield break;
+                }
+
+                var texture = DownloadHandlerTexture.GetContent(request);
+                if (texture == null) {
+                    Debug.LogError($"Failed to decode image: {url}");
+                    done(null);
+                    yield break;
+                }
+                try {
+                    diskCache?.Store(url, request.downloadHandler.data, request.GetResponseHeader);
+                } catch (Exception e) when (e is IOException || e is UnauthorizedAccessException) {
+                    Debug.LogWarning($"Couldn't cache {url}: {e.Message}");
                 }
-                callback(texture);
+                done(texture);
             }
         }
+
+        /// <summary>
+        /// Loads a cached body like ImageLoader does: read and (for PNGs) decoded on the thread pool, only uploaded
+        /// on the main thread. Other formats are still decoded by LoadImage. Null if it can't be read or decoded.
+        /// </summary>
+        IEnumerator LoadCachedImage(HttpCacheEntry entry, Action<Texture2D> done) {
+            var path = DiskCache.GetPath(entry);
+            var read = Task.Run(() => ImageLoader.Decode(File.ReadAllBytes(path)));
+            while (!read.IsCompleted)
+                yield return null;
+            done(read.IsFaulted ? null : ImageLoader.CreateTexture(read.Result, FilterMode.Bilinear));
+        }
     }
 }
\ No newline at end of file
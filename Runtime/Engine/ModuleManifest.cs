@@ -0,0 +1,60 @@
+﻿using System;
+using System.Collections.Generic;
+using Newtonsoft.Json;
+
+namespace OneJS {
+    /// <summary>
+    /// The module dependency graph emitted next to the esbuild outputs (see the dependency manifest plugin in
+    /// esbuild.mjs). All paths are relative to the esbuild output dir, i.e. ScriptEngine.basePath.
+    /// </summary>
+    [Serializable]
+    public class ModuleManifest {
+        public const string FileName = "modules.json";
+
+        public int version = 1;
+        /// <summary>
+        /// esbuild output format. "esm" means the entry points are ES modules (i.e. built with code splitting) and
+        /// have to be executed as modules rather than evaluated as scripts.
+        /// </summary>
+        public string format = "cjs";
+        /// <summary>
+        /// Outputs that are entry points (i.e. app.js)
+        /// </summary>
+        public List<string> entries = new List<string>();
+        public Dictionary<string, ModuleManifestEntry> modules = new Dictionary<string, ModuleManifestEntry>();
+
+        public bool IsESM => format == "esm";
+
+        public static ModuleManifest FromJson(string json) {
+            return JsonConvert.DeserializeObject<ModuleManifest>(json);
+        }
+
+        /// <summary>
+        /// Everything reachable from the entry points through static imports, i.e. all modules that will be
+        /// loaded at startup. Chunks only reachable through dynamic import() are left out.
+        /// </summary>
+        public List<string> CollectStaticDependencies() {
+            var result = new List<string>();
+            var visited = new HashSet<string>();
+            var stack = new Stack<string>(entries);
+            while (stack.Count > 0) {
+                var path = stack.Pop();
+                if (!visited.Add(path))
+                    continue;
+                result.Add(path);
+                if (modules.TryGetValue(path, out var entry) && entry.imports != null) {
+                    foreach (var dep in entry.imports)
+                        stack.Push(dep);
+                }
+            }
+            return result;
+        }
+    }
+
+    [Serializable]
+    public class ModuleManifestEntry {
+        public List<string> imports = new List<string>();
+        public List<string> dynamicImports = new List<string>();
+        public long bytes;
+    }
+}
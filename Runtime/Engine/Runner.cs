@@ -2,8 +2,10 @@
 using System.IO;
 using System.Collections;
 using System.Collections.Generic;
+using OneJS.Utils;
 using UnityEngine;
 using UnityEngine.SceneManagement;
+using UnityEngine.Serialization;
 using UnityEngine.UIElements;
 
 namespace OneJS {
@@ -19,8 +21,9 @@ namespace OneJS {
 
         [Tooltip("Watch entry file for changes and reload.")]
         public bool liveReload = true;
-        [Tooltip("How often to check for changes in the entry file in milliseconds.")]
-        public int pollingInterval = 300;
+        [Tooltip("How long a changed file must stay quiet before it triggers a reload, in milliseconds.")]
+        [FormerlySerializedAs("pollingInterval")]
+        public int debounceInterval = 50;
         public bool clearGameObjects = true;
         public bool clearLogs = true;
         [Tooltip("Respawn the Janitor during scene loads so that it doesn't clean up your additively loaded scenes.")]
@@ -30,11 +33,14 @@ namespace OneJS {
         [Tooltip("Enable Live Reload for Standalone build.")]
         public bool standalone;
 
+        [Obsolete("Changes are no longer polled for. Use debounceInterval instead.")]
+        public int pollingInterval { get => debounceInterval; set => debounceInterval = value; }
+
         ScriptEngine _engine;
         Janitor _janitor;
 
-        float _lastCheckTime;
-        DateTime _lastWriteTime;
+        FileWatcher _watcher;
+        bool _watcherUnavailable;
         Coroutine _evalCoroutine;
 
         void Awake() {
@@ -49,13 +55,13 @@ namespace OneJS {
         void OnEnable() {
             Respawn();
             _engine.OnReload += OnReload;
+            _engine.OnStyleSheetFileLoaded += OnStyleSheetFileLoaded;
 
-            var fullpath = _engine.GetFullPath(entryFile);
-            if (!File.Exists(fullpath)) {
-                Debug.LogError($"Entry file not found: {fullpath}");
+            StartWatching(); // This needs to be before EvalFile in case EvalFile crashes
+            if (!_engine.FileExists(entryFile)) {
+                Debug.LogError($"Entry file not found: {_engine.GetFullPath(entryFile)}");
                 return;
             }
-            _lastWriteTime = File.GetLastWriteTime(fullpath); // This needs to be before EvalFile in case EvalFile crashes
             if (runOnStart) {
                 // _engine.EvalFile(entryFile);
                 _evalCoroutine = StartCoroutine(DelayEvalFile());
@@ -64,19 +70,24 @@ namespace OneJS {
 
         void OnDisable() {
             _engine.OnReload -= OnReload;
+            _engine.OnStyleSheetFileLoaded -= OnStyleSheetFileLoaded;
+            StopWatching();
         }
 
         void Update() {
-            if (!liveReload) return;
-#if !UNITY_EDITOR && (UNITY_STANDALONE || UNITY_IOS || UNITY_ANDROID)
-            if (!standalone) return;
-#endif
-            if (Time.time - _lastCheckTime < pollingInterval / 1000f) return;
-            _lastCheckTime = Time.time;
-            CheckForChanges();
+            // liveReload can be flipped at runtime (i.e. from the inspector)
+            if (liveReload != (_watcher != null)) {
+                if (liveReload)
+                    StartWatching();
+                else
+                    StopWatching();
+            }
+            if (_watcher == null) return;
 #if UNITY_EDITOR
-            CheckForStylesheetChanges();
+            if (!SameAsTrackedStyleSheets(_engine.styleSheets))
+                WatchStyleSheets();
 #endif
+            _watcher.Poll();
         }
 
         public void Reload() {
@@ -92,47 +103,96 @@ namespace OneJS {
             _engine.EvalFile(entryFile);
         }
 
-        void CheckForChanges() {
-            var writeTime = File.GetLastWriteTime(_engine.GetFullPath(entryFile));
-            if (_lastWriteTime == writeTime) return; // No change
-            _lastWriteTime = writeTime;
-            Reload();
+        void StartWatching() {
+            if (!liveReload || _watcherUnavailable) return;
+#if !UNITY_EDITOR && (UNITY_STANDALONE || UNITY_IOS || UNITY_ANDROID)
+            if (!standalone) return;
+#endif
+            StopWatching();
+            try {
+                _watcher = new FileWatcher(debounceInterval);
+                _watcher.WatchFile(_engine.GetFullPath(entryFile));
+            } catch (Exception e) {
+                // FileSystemWatcher isn't available on every platform
+                Debug.LogWarning($"Live Reload is unavailable: {e.Message}");
+                StopWatching();
+                _watcherUnavailable = true;
+                return;
+            }
+            _watcher.OnChanged += OnFilesChanged;
+#if UNITY_EDITOR
+            WatchStyleSheets();
+#endif
+        }
+
+        void StopWatching() {
+            if (_watcher == null) return;
+            _watcher.Dispose();
+            _watcher = null;
+#if UNITY_EDITOR
+            _trackedStyleSheets.Clear();
+#endif
+        }
+
+        /// <summary>
+        /// Stylesheet-only changes are refreshed in place, keeping JS state and the DOM. Anything else
+        /// (i.e. the entry file) triggers a full reload.
+        /// </summary>
+        void OnFilesChanged(IReadOnlyList<string> paths) {
+            var styleSheetPaths = new List<string>();
+            var reload = false;
+            foreach (var path in paths) {
+                if (IsStyleSheetFile(path))
+                    styleSheetPaths.Add(path);
+                else
+                    reload = true;
+            }
+            if (styleSheetPaths.Count > 0)
+                _engine.RefreshStyleSheets(styleSheetPaths);
+            if (reload) {
+                _engine.InvalidateLoaderCache(paths);
+                Reload();
+            }
+        }
+
+        void OnStyleSheetFileLoaded(string fullpath) {
+            _watcher?.WatchFile(fullpath);
+        }
 
-            // _engine.OnReload += () => {
-            //     _engine.JsEnv.UsingAction<bool>();
-            //     // Add more here
-            // };
+        static bool IsStyleSheetFile(string path) {
+            return path.EndsWith(".uss", StringComparison.OrdinalIgnoreCase) ||
+                   path.EndsWith(".tss", StringComparison.OrdinalIgnoreCase) ||
+                   path.EndsWith(".css", StringComparison.OrdinalIgnoreCase);
         }
 
 #if UNITY_EDITOR
-        Dictionary<StyleSheet, (string, DateTime)> _trackedStylesheets = new Dictionary<StyleSheet, (string, DateTime)>();
-
-        void CheckForStylesheetChanges() {
-            if (SameAsTrackedStyleSheet(_engine.styleSheets)) return;
-            foreach (var sheet in _engine.styleSheets) {
-                var path = UnityEditor.AssetDatabase.GetAssetPath(sheet);
-                if (string.IsNullOrEmpty(path)) continue;
-                UnityEditor.AssetDatabase.ImportAsset(path, UnityEditor.ImportAssetOptions.ForceUpdate);
-                var lastWriteTime = File.GetLastWriteTime(path);
-                if (_trackedStylesheets.TryGetValue(sheet, out var tracked)) {
-                    if (tracked.Item1.Equals(path, StringComparison.Ordinal) && tracked.Item2 == lastWriteTime) continue;
-                }
-                _trackedStylesheets[sheet] = (path, lastWriteTime);
+        HashSet<string> _trackedStyleSheets = new HashSet<string>();
+        StyleSheet[] _watchedStyleSheets = new StyleSheet[0];
+
+        /// <summary>
+        /// Asset paths are only looked up here, when the stylesheet list itself changes, not on every event.
+        /// </summary>
+        void WatchStyleSheets() {
+            var sheets = _engine.styleSheets ?? new StyleSheet[0];
+            _watchedStyleSheets = (StyleSheet[])sheets.Clone();
+            foreach (var sheet in sheets) {
+                if (sheet == null) continue;
+                var assetPath = UnityEditor.AssetDatabase.GetAssetPath(sheet);
+                if (string.IsNullOrEmpty(assetPath)) continue;
+                var fullpath = Path.GetFullPath(assetPath);
+                if (_trackedStyleSheets.Add(fullpath))
+                    _watcher.WatchFile(fullpath);
             }
         }
 
         /// <summary>
-        /// Returns true if the provided StyleSheet array matches the tracked stylesheets.
-        /// Same SS obj, assetPath, and GetLastWriteTime
+        /// Returns true if the provided StyleSheet array is the same set of sheets we are already watching.
         /// </summary>
-        bool SameAsTrackedStyleSheet(StyleSheet[] styleSheets) {
-            if (styleSheets.Length != _trackedStylesheets.Count) return false;
+        bool SameAsTrackedStyleSheets(StyleSheet[] styleSheets) {
+            if (styleSheets == null) return _watchedStyleSheets.Length == 0;
+            if (styleSheets.Length != _watchedStyleSheets.Length) return false;
             for (int i = 0; i < styleSheets.Length; i++) {
-                var sheet = styleSheets[i];
-                if (!_trackedStylesheets.TryGetValue(sheet, out var tracked)) return false;
-                var path = UnityEditor.AssetDatabase.GetAssetPath(sheet);
-                if (!path.Equals(tracked.Item1, StringComparison.Ordinal)) return false;
-                if (File.GetLastWriteTime(path) != tracked.Item2) return false;
+                if (styleSheets[i] != _watchedStyleSheets[i]) return false;
             }
             return true;
         }
@@ -1,12 +1,15 @@
 ﻿using System;
 using System.Collections.Generic;
+using OneJS.Dom;
 using UnityEngine;
 using UnityEngine.Serialization;
 using UnityEngine.UIElements;
 
 namespace OneJS {
     /// <summary>
-    /// Watch for screen size changes and apply media classes to the root element.
+    /// Applies media classes to the root element as its width crosses the breakpoints. Event-driven (see
+    /// MediaQueryWatcher); per frame, it only checks whether the UIDocument's root showed up or was replaced (it's
+    /// null until the document has a panel, and rebuilt when its source asset changes).
     /// </summary>
     [DefaultExecutionOrder(10)]
     [RequireComponent(typeof(UIDocument))] [AddComponentMenu("OneJS/Screen Monitor")]
@@ -21,44 +24,64 @@ namespace OneJS {
         public bool standalone;
 
         UIDocument _uiDocument;
-        float _lastScreenWidth;
+        VisualElement _root;
+        MediaQueryWatcher _watcher;
+        bool _laidOut;
+        readonly List<(MediaQueryList list, string className)> _queries = new List<(MediaQueryList, string)>();
 
         void Awake() {
             _uiDocument = GetComponent<UIDocument>();
         }
 
-        void Start() {
-            PollScreenChange();
+        void OnEnable() {
+            Attach(_uiDocument.rootVisualElement);
         }
 
         void Update() {
-#if !UNITY_EDITOR && (UNITY_STANDALONE || UNITY_IOS || UNITY_ANDROID)
-            if (standalone) {
-                PollScreenChange();
+            var root = _uiDocument.rootVisualElement;
+            if (root != _root) {
+                Attach(root);
+                return;
             }
-#else
-            PollScreenChange();
-#endif
+            if (_laidOut || _root == null || float.IsNaN(_root.layout.width))
+                return;
+            // The root usually isn't laid out yet when it's attached
+            _laidOut = true;
+            _watcher.Refresh();
+            foreach (var (list, className) in _queries)
+                _root.EnableInClassList(className, list.matches);
         }
 
-        void PollScreenChange() {
-            var width = _uiDocument.rootVisualElement.resolvedStyle.width;
-            if (!Mathf.Approximately(_lastScreenWidth, width)) {
-                SetRootMediaClass(width);
-                _lastScreenWidth = width;
-            }
+        void OnDisable() {
+            Detach();
         }
 
-        void SetRootMediaClass(float width) {
-            foreach (var sc in screenClasses) {
-                _uiDocument.rootVisualElement.RemoveFromClassList(sc);
-            }
-            for (int i = 0; i < breakpoints.Length; i++) {
-                if (screenClasses.Length <= i) break;
-                if (width >= breakpoints[i]) {
-                    _uiDocument.rootVisualElement.AddToClassList(screenClasses[i]);
-                }
+        void Attach(VisualElement root) {
+            Detach();
+            _root = root;
+            if (root == null)
+                return;
+            // Classes follow (min-width) queries, which are only re-evaluated when the root's geometry changes
+            _watcher = new MediaQueryWatcher(root);
+            for (int i = 0; i < breakpoints.Length && i < screenClasses.Length; i++) {
+                var list = _watcher.Match($"(min-width: {breakpoints[i]}px)");
+                var className = screenClasses[i];
+                root.EnableInClassList(className, list.matches);
+                _queries.Add((list, className));
+#if !UNITY_EDITOR && (UNITY_STANDALONE || UNITY_IOS || UNITY_ANDROID)
+                if (!standalone)
+                    continue;
+#endif
+                list.addListener(e => root.EnableInClassList(className, e.matches));
             }
         }
+
+        void Detach() {
+            _watcher?.Dispose();
+            _watcher = null;
+            _root = null;
+            _laidOut = false;
+            _queries.Clear();
+        }
     }
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 ﻿using System;
-using System.Collections;
+using System.Collections.Generic;
 using System.IO;
 using System.Linq;
+using System.Threading.Tasks;
 using OneJS.Dom;
+using OneJS.Utils;
 using Puerts;
 using UnityEngine;
 using UnityEngine.UIElements;
@@ -36,7 +38,25 @@ namespace OneJS {
         public bool debuggerSupport = false;
         public string basePath = "@outputs/esbuild/";
         public int port = 8080;
+        [Obsolete("Stylesheets are now re-imported as soon as they change.")] [HideInInspector]
         public MiscSettings miscSettings;
+
+        [Tooltip("Memory budget for cached images (local files and web images), in MB. Once it's exceeded, images that aren't displayed anymore are destroyed, least recently used first. 0 means unbounded.")]
+        public int textureCacheBudget = 256;
+
+        [Tooltip("Pack small local images (i.e. icons used as backgrounds or in Img) into shared atlas pages at runtime, so elements showing them can be batched together.")]
+        public bool useImageAtlas = false;
+        [Tooltip("Images up to this size (in pixels, on both sides) go into the atlas.")]
+        public int atlasMaxImageSize = 128;
+        [Tooltip("Size of each atlas page, in pixels.")]
+        public int atlasPageSize = 1024;
+        [Tooltip("Maximum number of atlas pages. Images that don't fit once they're all full are loaded as separate textures.")]
+        public int atlasMaxPages = 4;
+
+        [Tooltip("Maximum number of Img loads in flight at once. Images closest to the viewport are loaded first. 0 means unlimited.")]
+        public int maxConcurrentImageLoads = 6;
+        [Tooltip("How close (in pixels) an Img with loading=\"lazy\" has to get to the viewport before it starts loading.")]
+        public float lazyLoadMargin = 300;
         #endregion
 
         #region Events
@@ -44,6 +64,10 @@ namespace OneJS {
         public event Action<JsEnv> OnPostInit;
         public event Action OnReload;
         public event Action OnDispose;
+        /// <summary>
+        /// Raised with the full path whenever a runtime stylesheet is loaded from a file (see Document.loadRuntimeUSS).
+        /// </summary>
+        public event Action<string> OnStyleSheetFileLoaded;
         public event Action<Exception> OnError;
         #endregion
 
@@ -55,8 +79,23 @@ namespace OneJS {
         Document _document;
         Resource _resource;
         ILoader _jsEnvLoader;
+        bool _customLoader;
+        BundleArchive _archive;
+        readonly HashSet<string> _diskCopies = new HashSet<string>(); // Archive entries written out by GetDiskPath
+        ModuleManifest _moduleManifest;
+        ImageLoader _imageLoader;
+        SvgLoader _svgLoader;
+        TextureCache _textureCache;
+        ImageAtlas _imageAtlas;
+        ImageLoadScheduler _imageLoadScheduler;
+        FetchApi _fetchApi;
         int _tick;
 
+        /// <summary>
+        /// Resources evaluated right after the globals are set up (fetch, canvas getContext)
+        /// </summary>
+        static readonly string[] Polyfills = { "onejs/fetch.js", "onejs/canvas.js" };
+
         Action<string, object> _addToGlobal;
         #endregion
 
@@ -65,7 +104,7 @@ namespace OneJS {
             _uiDocument = GetComponent<UIDocument>();
             _resource = new Resource(this);
             if (_jsEnvLoader == null)
-                _jsEnvLoader = new DefaultLoader(Path.Combine(WorkingDir, basePath));
+                _jsEnvLoader = CreateDefaultLoader();
         }
 
         void OnEnable() {
@@ -85,6 +124,15 @@ namespace OneJS {
                 OnError?.Invoke(e);
             }
         }
+
+        void LateUpdate() {
+            // Uploads whatever got packed into the image atlas this frame, once per page
+            _imageAtlas?.Flush();
+            // Evicts what was kept over budget because it was used this frame (see TextureCache.Trim)
+            _textureCache?.Trim();
+            // Starts queued Img loads after this frame's DOM changes, so they're prioritized by the new layout
+            _imageLoadScheduler?.Pump();
+        }
         #endregion
 
         #region Properties
@@ -129,6 +177,45 @@ namespace OneJS {
         public UIDocument UIDocument => _uiDocument;
 
         public Action<string, object> AddToGlobal => _addToGlobal;
+
+        /// <summary>
+        /// The bundle files are served from instead of the WorkingDir (see Bundler.serveFromArchive). Null when
+        /// everything is read from disk.
+        /// </summary>
+        public BundleArchive Archive => _archive;
+
+        /// <summary>
+        /// Loads images off the main thread (see Document.loadImageAsync). Created on first use.
+        /// </summary>
+        public ImageLoader ImageLoader => _imageLoader ??= new ImageLoader(this);
+
+        /// <summary>
+        /// Loads .svg files as VectorImages (see Document.loadVectorImageAsync). Created on first use.
+        /// </summary>
+        public SvgLoader SvgLoader => _svgLoader ??= new SvgLoader(ReadAllBytesAsync);
+
+        /// <summary>
+        /// Shared by Document, Resource and WebApi. Survives reloads, but unreferenced textures are dropped on
+        /// every Reload(). Created on first use.
+        /// </summary>
+        public TextureCache TextureCache => _textureCache ??= new TextureCache(textureCacheBudget * 1024L * 1024L);
+
+        /// <summary>
+        /// Null unless useImageAtlas is on. Created on first use.
+        /// </summary>
+        public ImageAtlas ImageAtlas {
+            get {
+                if (_imageAtlas == null && useImageAtlas)
+                    _imageAtlas = new ImageAtlas(atlasPageSize, atlasMaxImageSize, atlasMaxPages);
+                return _imageAtlas;
+            }
+        }
+
+        /// <summary>
+        /// Schedules Img loads (see Dom.Img.Loading). Created on first use.
+        /// </summary>
+        public ImageLoadScheduler ImageLoadScheduler =>
+            _imageLoadScheduler ??= new ImageLoadScheduler(maxConcurrentImageLoads, lazyLoadMargin);
         #endregion
 
         #region Public Methods
@@ -143,11 +230,108 @@ namespace OneJS {
             return Path.GetFullPath(Path.Combine(WorkingDir, normalizedPath));
         }
 
+        /// <summary>
+        /// Checks the archive first (if any), then the disk.
+        /// </summary>
+        /// <param name="filepath">Relative to the WorkingDir, or a full path</param>
+        public bool FileExists(string filepath) {
+            if (_archive != null && TryGetArchivePath(filepath, out var archivePath) && _archive.Contains(archivePath))
+                return true;
+            return File.Exists(GetFullPath(filepath));
+        }
+
+        /// <summary>
+        /// Reads a file from the archive (if any) or the disk. Throws FileNotFoundException if it's in neither.
+        /// </summary>
+        /// <param name="filepath">Relative to the WorkingDir, or a full path</param>
+        public byte[] ReadAllBytes(string filepath) {
+            if (_archive != null && TryGetArchivePath(filepath, out var archivePath)) {
+                var bytes = _archive.ReadAllBytes(archivePath);
+                if (bytes != null)
+                    return bytes;
+            }
+            return File.ReadAllBytes(GetFullPath(filepath));
+        }
+
+        /// <summary>
+        /// Like ReadAllBytes(), but the read happens on the thread pool. The path is resolved right away, on the
+        /// calling thread (WorkingDir needs the main thread).
+        /// </summary>
+        /// <param name="filepath">Relative to the WorkingDir, or a full path</param>
+        public Task<byte[]> ReadAllBytesAsync(string filepath) {
+            var archive = _archive;
+            string archivePath = null;
+            if (archive != null && !TryGetArchivePath(filepath, out archivePath))
+                archive = null;
+            var fullpath = GetFullPath(filepath);
+            return Task.Run(() => {
+                var bytes = archive?.ReadAllBytes(archivePath);
+                return bytes ?? File.ReadAllBytes(fullpath);
+            });
+        }
+
+        /// <summary>
+        /// Reads a text file from the archive (if any) or the disk. Throws FileNotFoundException if it's in neither.
+        /// </summary>
+        /// <param name="filepath">Relative to the WorkingDir, or a full path</param>
+        public string ReadAllText(string filepath) {
+            if (_archive != null && TryGetArchivePath(filepath, out var archivePath)) {
+                var text = _archive.ReadAllText(archivePath);
+                if (text != null)
+                    return text;
+            }
+            return File.ReadAllText(GetFullPath(filepath));
+        }
+
+        /// <summary>
+        /// Returns a path to a real file, for Unity APIs that only accept file paths (i.e. new Font(path)).
+        /// Archive entries are written out under temporaryCachePath the first time they're asked for, and deleted on
+        /// Reload().
+        /// </summary>
+        /// <param name="filepath">Relative to the WorkingDir, or a full path</param>
+        public string GetDiskPath(string filepath) {
+            var fullpath = GetFullPath(filepath);
+            if (_archive == null || File.Exists(fullpath) || !TryGetArchivePath(filepath, out var archivePath) ||
+                !_archive.TryGetSegment(archivePath, out var segment))
+                return fullpath;
+            var cachePath = Path.Combine(Application.temporaryCachePath, "onejs-archive", archivePath);
+            if (!File.Exists(cachePath) || new FileInfo(cachePath).Length != segment.Count) {
+                Directory.CreateDirectory(Path.GetDirectoryName(cachePath));
+                using (var stream = File.Create(cachePath)) {
+                    stream.Write(segment.Array, segment.Offset, segment.Count);
+                }
+            }
+            _diskCopies.Add(cachePath);
+            return cachePath;
+        }
+
+        /// <summary>
+        /// Serves bundle files (JS modules, images, fonts, USS) from the given archive instead of the WorkingDir.
+        /// Unless a custom loader was set via SetJsEnvLoader(), the JsEnv loader is switched over too; this takes
+        /// effect on the next Init (i.e. set it before OnEnable, or Reload() afterwards).
+        /// </summary>
+        public void SetArchive(BundleArchive archive) {
+            _archive = archive;
+            if (!_customLoader)
+                _jsEnvLoader = CreateDefaultLoader();
+        }
+
         public void Dispose() {
             OnDispose?.Invoke();
+            _imageLoader?.Cancel();
+            _svgLoader?.Cancel();
+            _imageLoadScheduler?.CancelAll();
+            _fetchApi?.Dispose();
+            _document?.Dispose();
+            (_jsEnvLoader as CachingLoader)?.ClearPrefetched();
+            // No texture job may write into (or resolve a promise of) the disposed JsEnv's textures
+            TextureKernels.CancelAll();
             if (_jsEnv != null) {
                 _jsEnv.Dispose();
             }
+            // Nothing can give back what was handed to the disposed JsEnv
+            _textureCache?.ReleaseHandOuts();
+            _imageAtlas?.ReleaseHandOuts();
             if (_uiDocument.rootVisualElement != null) {
                 _uiDocument.rootVisualElement.Clear();
                 _uiDocument.rootVisualElement.styleSheets.Clear();
@@ -157,10 +341,47 @@ namespace OneJS {
         public void Reload() {
             OnReload?.Invoke();
             Dispose();
+            // The old DOM is gone, so this drops every image it displayed; edited image files get picked up
+            _textureCache?.Purge();
+            _imageAtlas?.Purge();
+            _svgLoader?.Purge();
+            FontManager.Shared.Purge(this);
+            DeleteDiskCopies();
+            // Keeps known-existing files warm, but new files may have shown up since
+            InvalidateLoaderCache(Array.Empty<string>());
             Init();
+        }
+
+        /// <summary>
+        /// Drops cached loader lookups (see CachingLoader) for the given files.
+        /// </summary>
+        /// <param name="fullpaths">Full paths of changed files</param>
+        public void InvalidateLoaderCache(IReadOnlyList<string> fullpaths) {
+            (_jsEnvLoader as CachingLoader)?.Invalidate(fullpaths);
+        }
+
+        /// <summary>
+        /// Refreshes stylesheets in place without touching the JsEnv or the DOM. Global StyleSheet assets
+        /// are re-imported (Editor only) and file-backed runtime stylesheets are rebuilt.
+        /// </summary>
+        /// <param name="fullpaths">Full paths of the changed stylesheet files</param>
+        public void RefreshStyleSheets(IReadOnlyList<string> fullpaths) {
+            foreach (var fullpath in fullpaths) {
 #if UNITY_EDITOR
-            StartCoroutine(RefreshStyleSheets());
+                foreach (var ss in styleSheets) {
+                    if (ss == null) continue;
+                    string assetPath = UnityEditor.AssetDatabase.GetAssetPath(ss);
+                    if (string.IsNullOrEmpty(assetPath) || Path.GetFullPath(assetPath) != fullpath) continue;
+                    // Stylesheets need explicit re-importing when Unity Editor doesn't have focus.
+                    UnityEditor.AssetDatabase.ImportAsset(assetPath, UnityEditor.ImportAssetOptions.ForceUpdate);
+                }
 #endif
+                _document?.reloadRuntimeUSS(fullpath);
+            }
+        }
+
+        internal void NotifyStyleSheetFileLoaded(string fullpath) {
+            OnStyleSheetFileLoaded?.Invoke(fullpath);
         }
 
         /**
@@ -186,6 +407,7 @@ namespace OneJS {
                 _jsEnv.Dispose();
             }
 
+            LoadModuleManifest();
             _jsEnv = new JsEnv(_jsEnvLoader, debuggerSupport ? port : -1);
 
 #if UNITY_WEBGL && UNITY_STANDALONE
@@ -224,6 +446,13 @@ namespace OneJS {
             _addToGlobal("___workingDir", WorkingDir);
             _addToGlobal("resource", _resource);
             _addToGlobal("onejs", _engineHost);
+            _fetchApi = new FetchApi();
+            _addToGlobal("___fetch", _fetchApi);
+            foreach (var path in Polyfills) {
+                var polyfill = Resources.Load<TextAsset>(path);
+                if (polyfill != null)
+                    _jsEnv.Eval(polyfill.text, path);
+            }
             foreach (var obj in globalObjects) {
                 _addToGlobal(obj.name, obj.obj);
             }
@@ -235,14 +464,24 @@ namespace OneJS {
         /// </summary>
         /// <param name="filepath">Relative to the WorkingDir</param>
         public void EvalFile(string filepath) {
-            var fullpath = GetFullPath(filepath);
-            if (!File.Exists(fullpath)) {
-                Debug.LogError($"Entry file not found: {fullpath}");
+            if (!FileExists(filepath)) {
+                Debug.LogError($"Entry file not found: {GetFullPath(filepath)}");
                 return;
             }
-            // var filename = Path.GetFileName(fullpath);
-            var code = File.ReadAllText(fullpath);
-            _jsEnv.Eval(code, filepath);
+            try {
+                if (_moduleManifest != null && _moduleManifest.IsESM && TryGetModulePath(filepath, out var modulePath)) {
+                    // Code-split output: run it as a module. Its import()s of chunks are resolved by Puerts and read
+                    // through the same loader, so they work from the WorkingDir and from bundle archives alike.
+                    _jsEnv.ExecuteModule(modulePath);
+                    return;
+                }
+                // var filename = Path.GetFileName(fullpath);
+                var code = TryTakePrefetchedModule(filepath, out var prefetched) ? prefetched : ReadAllText(filepath);
+                _jsEnv.Eval(code, filepath);
+            } finally {
+                // Static imports are all done by now; anything left over would never be read
+                (_jsEnvLoader as CachingLoader)?.ClearPrefetched();
+            }
         }
 
         /// <summary>
@@ -256,28 +495,88 @@ namespace OneJS {
 
         public void SetJsEnvLoader(ILoader loader) {
             _jsEnvLoader = loader;
+            _customLoader = loader != null;
         }
         #endregion
 
         #region Private Methods
-#if UNITY_EDITOR
+        ILoader CreateDefaultLoader() {
+            var root = Path.Combine(WorkingDir, basePath);
+            ILoader loader = new DefaultLoader(root);
+            loader = _archive != null ? new ArchiveLoader(_archive, basePath, loader) : new FileLoader(root, loader);
+            return new CachingLoader(loader, root);
+        }
+
         /// <summary>
-        /// This is for convenience for Live-Reload. Stylesheets need explicit refreshing
-        /// when Unity Editor doesn't have focus. Otherwise, stylesheet changes won't be
-        /// reflected in the Editor until it gains focus.
+        /// Reads the esbuild dependency manifest, if any, and starts reading every module the entry points
+        /// statically depend on on thread pool threads, so it overlaps with JsEnv startup and compiling the entry
+        /// file. Chunks only reachable through dynamic import() are left for when they're imported.
         /// </summary>
-        IEnumerator RefreshStyleSheets() {
-            yield return new WaitForSeconds(miscSettings.styleSheetRefreshDelay);
-            foreach (var ss in styleSheets) {
-                if (ss != null) {
-                    string assetPath = UnityEditor.AssetDatabase.GetAssetPath(ss);
-                    if (!string.IsNullOrEmpty(assetPath)) {
-                        UnityEditor.AssetDatabase.ImportAsset(assetPath, UnityEditor.ImportAssetOptions.ForceUpdate);
-                    }
-                }
+        void LoadModuleManifest() {
+            _moduleManifest = null;
+            var manifestPath = Path.Combine(basePath, ModuleManifest.FileName);
+            if (!FileExists(manifestPath))
+                return;
+            try {
+                _moduleManifest = ModuleManifest.FromJson(ReadAllText(manifestPath));
+            } catch (Exception e) {
+                Debug.LogWarning($"Couldn't read {ModuleManifest.FileName}, skipping module prefetch: {e.Message}");
+                return;
             }
+            (_jsEnvLoader as CachingLoader)?.Prefetch(_moduleManifest.CollectStaticDependencies());
+        }
+
+        /// <summary>
+        /// The entry file is usually an esbuild output too, in which case it may already have been prefetched.
+        /// </summary>
+        bool TryTakePrefetchedModule(string filepath, out string code) {
+            code = null;
+            if (!(_jsEnvLoader is CachingLoader loader) || !TryGetModulePath(filepath, out var modulePath))
+                return false;
+            return loader.TryTakePrefetched(modulePath, out code, out _);
+        }
+
+        /// <summary>
+        /// Maps a WorkingDir-relative path to a loader path (relative to the basePath). False if it's outside.
+        /// </summary>
+        bool TryGetModulePath(string filepath, out string modulePath) {
+            modulePath = BundleArchive.NormalizePath(filepath);
+            var moduleRoot = BundleArchive.NormalizePath(basePath).TrimEnd('/') + "/";
+            if (Path.IsPathRooted(filepath) || !modulePath.StartsWith(moduleRoot))
+                return false;
+            modulePath = modulePath.Substring(moduleRoot.Length);
+            return true;
+        }
+
+        /// <summary>
+        /// Maps a WorkingDir-relative or full path to an archive path. False if it's outside the WorkingDir.
+        /// </summary>
+        bool TryGetArchivePath(string filepath, out string archivePath) {
+            if (!Path.IsPathRooted(filepath)) {
+                archivePath = BundleArchive.NormalizePath(filepath);
+                return true;
+            }
+            var relative = Path.GetRelativePath(WorkingDir, filepath);
+            archivePath = BundleArchive.NormalizePath(relative);
+            return !relative.StartsWith("..") && !Path.IsPathRooted(relative);
+        }
+
+        /// <summary>
+        /// Deletes the files GetDiskPath wrote out, once the fonts loaded from them are purged, so a changed archive
+        /// doesn't leave stale copies behind. Files that are still locked are retried on the next reload.
+        /// </summary>
+        void DeleteDiskCopies() {
+            _diskCopies.RemoveWhere(path => {
+                try {
+                    File.Delete(path);
+                    return true;
+                } catch (IOException) {
+                    return false;
+                } catch (UnauthorizedAccessException) {
+                    return false;
+                }
+            });
         }
-#endif
         #endregion
 
         #region ContextMenus
@@ -355,8 +654,9 @@ namespace OneJS {
     }
 
     [Serializable]
+    [Obsolete("Stylesheets are now re-imported as soon as they change.")]
     public class MiscSettings {
-        [Tooltip("Delay before forcing stylesheet re-import to allow live changes to register properly")]
+        [Tooltip("No longer used")]
         public float styleSheetRefreshDelay = 0.1f;
     }
     #endregion
@@ -0,0 +1,375 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Threading.Tasks;
+using OneJS.Dom;
+using OneJS.Utils;
+using UnityEngine;
+using UnityEngine.UIElements;
+using Object = UnityEngine.Object;
+
+namespace OneJS {
+    /// <summary>
+    /// Loads .svg files as VectorImages (for Img and backgroundImage). Files are read and parsed on the thread pool
+    /// (see SvgParser); the main thread only replays the paths into a detached Painter2D, which tessellates them into
+    /// a VectorImage. Parsed documents are cached by path, VectorImages by path and size (and color, for SVGs using
+    /// currentColor), so an icon shown in many places at the same size is tessellated once. Concurrent requests for
+    /// the same image share one load.
+    ///
+    /// VectorImages are reference counted like TextureCache entries (see Dom.TextureLease): the MaxUnused most
+    /// recently used unreferenced ones are kept around, older ones are destroyed.
+    ///
+    /// Has to be created on the main thread; callbacks are invoked there.
+    /// </summary>
+    public class SvgLoader {
+        /// <summary>
+        /// Smallest and largest size bucket (see SizeBucket)
+        /// </summary>
+        const int MinSize = 16;
+        const int MaxSize = 2048;
+        /// <summary>
+        /// Unreferenced VectorImages kept for reuse (i.e. an icon that comes back at the same size)
+        /// </summary>
+        const int MaxUnused = 32;
+
+        readonly Func<string, Task<byte[]>> _readAsync;
+        readonly TaskScheduler _mainThread;
+        readonly Dictionary<string, SvgDocument> _documents = new Dictionary<string, SvgDocument>();
+        readonly Dictionary<string, Entry> _images = new Dictionary<string, Entry>();
+        readonly Dictionary<VectorImage, Entry> _byImage = new Dictionary<VectorImage, Entry>();
+        readonly LinkedList<Entry> _lru = new LinkedList<Entry>(); // Unreferenced entries, least recently used first
+        readonly Dictionary<string, List<Action<SvgDocument>>> _pending = new Dictionary<string, List<Action<SvgDocument>>>();
+        int _generation;
+
+        /// <param name="readAsync">Reads a file given its full path</param>
+        public SvgLoader(Func<string, Task<byte[]>> readAsync) {
+            _readAsync = readAsync;
+            _mainThread = TaskScheduler.FromCurrentSynchronizationContext();
+        }
+
+        public int ImageCount => _images.Count;
+
+        public static bool IsSvg(string path) {
+            if (string.IsNullOrEmpty(path))
+                return false;
+            var query = path.IndexOfAny(new[] { '?', '#' });
+            if (query >= 0)
+                path = path.Substring(0, query);
+            return path.EndsWith(".svg", StringComparison.OrdinalIgnoreCase);
+        }
+
+        /// <summary>
+        /// Longest side of an element in screen pixels (worldBound is in panel units, which the panel scale maps
+        /// to pixels).
+        /// </summary>
+        public static float DisplaySize(VisualElement element) {
+            var bound = element.worldBound;
+            return Mathf.Max(bound.width, bound.height) * PixelsPerPoint(element);
+        }
+
+        static float PixelsPerPoint(VisualElement element) {
+            var panel = element.panel;
+            if (panel == null)
+                return 1;
+            if (panel.contextType == ContextType.Editor)
+                return GUIUtility.pixelsPerPoint;
+            // The panel scale isn't public, so it's taken from how many screen pixels the (full-screen) root covers
+            var width = panel.visualTree.resolvedStyle.width;
+            return width > 0 && Screen.width > 0 ? Screen.width / width : 1;
+        }
+
+        /// <summary>
+        /// Rounds a display size (longest side, in pixels) up to a power of two, so elements of slightly different
+        /// sizes share a VectorImage. 0 (i.e. not laid out yet) means the SVG's own size.
+        /// </summary>
+        public static int SizeBucket(float size) {
+            if (!(size > 0))
+                return 0;
+            return Mathf.NextPowerOfTwo(Mathf.Clamp(Mathf.CeilToInt(size), MinSize, MaxSize));
+        }
+
+        /// <summary>
+        /// Calls back (on the main thread) with the VectorImage, or null if the file couldn't be read or parsed;
+        /// right away if it's cached. The image isn't retained; whoever displays it does that (see Retain).
+        /// </summary>
+        /// <param name="fullpath">Also the cache key</param>
+        /// <param name="size">Size bucket (see SizeBucket)</param>
+        /// <param name="currentColor">What currentColor paints with (the element's color); black if null</param>
+        public void Load(string fullpath, int size, Action<VectorImage> callback, Color? currentColor = null) {
+            LoadDocument(fullpath,
+                document => callback(document != null ? GetImage(fullpath, document, size, currentColor) : null));
+        }
+
+        /// <summary>
+        /// Synchronous version of Load (parses on the calling thread), for editor documents.
+        /// </summary>
+        public VectorImage LoadNow(string fullpath, int size, byte[] bytes, Color? currentColor = null) {
+            if (!_documents.TryGetValue(fullpath, out var document)) {
+                try {
+                    document = SvgParser.Parse(bytes);
+                } catch (Exception e) {
+                    Debug.LogError($"Failed to load SVG: {fullpath} ({e.Message})");
+                    return null;
+                }
+                _documents[fullpath] = document;
+            }
+            return GetImage(fullpath, document, size, currentColor);
+        }
+
+        /// <summary>
+        /// Marks a VectorImage as displayed, so it isn't destroyed. Images that aren't cached are ignored.
+        /// </summary>
+        public void Retain(VectorImage image) {
+            if (image == null || !_byImage.TryGetValue(image, out var entry))
+                return;
+            if (entry.refCount++ == 0 && entry.node.List != null)
+                _lru.Remove(entry.node);
+        }
+
+        public void Release(VectorImage image) {
+            if (image == null || !_byImage.TryGetValue(image, out var entry) || entry.refCount == 0)
+                return;
+            if (--entry.refCount > 0)
+                return;
+            if (entry.removed) {
+                _byImage.Remove(image);
+                DestroyImage(image);
+                return;
+            }
+            _lru.AddLast(entry.node);
+            Trim();
+        }
+
+        /// <summary>
+        /// Forgets a file (i.e. after it was edited): its parsed document, and its VectorImages once they're
+        /// released.
+        /// </summary>
+        public void Remove(string fullpath) {
+            _documents.Remove(fullpath);
+            var removed = new List<Entry>();
+            foreach (var entry in _images.Values) {
+                if (entry.path == fullpath)
+                    removed.Add(entry);
+            }
+            foreach (var entry in removed)
+                Remove(entry);
+        }
+
+        /// <summary>
+        /// Drops pending callbacks (i.e. on reload, when they'd call into a disposed JsEnv).
+        /// </summary>
+        public void Cancel() {
+            _generation++;
+            _pending.Clear();
+        }
+
+        /// <summary>
+        /// Forgets every parsed file and VectorImage (i.e. on reload, so edits get picked up). Unreferenced images
+        /// are destroyed right away, the rest once they're released.
+        /// </summary>
+        public void Purge() {
+            foreach (var entry in new List<Entry>(_images.Values))
+                Remove(entry);
+            _documents.Clear();
+        }
+
+        void LoadDocument(string fullpath, Action<SvgDocument> callback) {
+            if (_documents.TryGetValue(fullpath, out var document)) {
+                callback(document);
+                return;
+            }
+            if (_pending.TryGetValue(fullpath, out var callbacks)) {
+                callbacks.Add(callback);
+                return;
+            }
+            _pending[fullpath] = new List<Action<SvgDocument>> { callback };
+
+            var generation = _generation;
+            Task<byte[]> read;
+            try {
+                read = _readAsync(fullpath);
+            } catch (Exception e) {
+                read = Task.FromException<byte[]>(e);
+            }
+            read.ContinueWith(t => SvgParser.Parse(t.Result), TaskScheduler.Default)
+                .ContinueWith(t => Complete(fullpath, generation, t), _mainThread);
+        }
+
+        void Complete(string fullpath, int generation, Task<SvgDocument> task) {
+            if (generation != _generation)
+                return;
+            SvgDocument document = null;
+            if (task.IsFaulted) {
+                var e = task.Exception?.GetBaseException();
+                Debug.LogError($"Failed to load SVG: {fullpath} ({e?.Message})");
+            } else {
+                document = task.Result;
+                _documents[fullpath] = document;
+            }
+            if (!_pending.TryGetValue(fullpath, out var callbacks))
+                return;
+            _pending.Remove(fullpath);
+            foreach (var callback in callbacks) {
+                try {
+                    callback(document);
+                } catch (Exception e) {
+                    Debug.LogException(e);
+                }
+            }
+        }
+
+        VectorImage GetImage(string fullpath, SvgDocument document, int size, Color? currentColor) {
+            var color = currentColor ?? Color.black;
+            // Only SVGs that use currentColor differ by color
+            var key = document.usesCurrentColor
+                ? size + ":" + ColorUtility.ToHtmlStringRGBA(color) + ":" + fullpath
+                : size + ":" + fullpath;
+            if (_images.TryGetValue(key, out var entry) && entry.image != null) {
+                if (entry.node.List != null) {
+                    _lru.Remove(entry.node);
+                    _lru.AddLast(entry.node);
+                }
+                return entry.image;
+            }
+            if (entry != null)
+                Remove(entry); // Destroyed behind the cache's back
+            var image = Build(document, size, color);
+            if (image == null)
+                return null;
+            entry = new Entry(key, fullpath, image);
+            _images[key] = entry;
+            _byImage[image] = entry;
+            _lru.AddLast(entry.node);
+            Trim();
+            return image;
+        }
+
+        void Remove(Entry entry) {
+            _images.Remove(entry.key);
+            entry.removed = true;
+            if (entry.refCount > 0)
+                return;
+            if (entry.node.List != null)
+                _lru.Remove(entry.node);
+            _byImage.Remove(entry.image);
+            DestroyImage(entry.image);
+        }
+
+        void Trim() {
+            while (_lru.Count > MaxUnused)
+                Remove(_lru.First.Value);
+        }
+
+        static void DestroyImage(VectorImage image) {
+            if (image == null)
+                return;
+            // Editor documents use SvgLoader outside of play mode
+            if (Application.isPlaying)
+                Object.Destroy(image);
+            else
+                Object.DestroyImmediate(image);
+        }
+
+        /// <summary>
+        /// Tessellates the document at the given size (longest side in pixels; 0 for its own size).
+        /// </summary>
+        /// <param name="currentColor">What currentColor paints with</param>
+        public static VectorImage Build(SvgDocument document, int size, Color currentColor) {
+            var viewBox = document.viewBox;
+            var longest = Mathf.Max(viewBox.width, viewBox.height);
+            var scale = size > 0
+                ? size / longest
+                : Mathf.Max(document.size.x / viewBox.width, document.size.y / viewBox.height);
+            if (!(scale > 0) || float.IsInfinity(scale))
+                return null;
+            var origin = viewBox.position;
+
+            var painter = new Painter2D();
+            try {
+                // SaveToVectorImage crops to what was drawn, so an invisible rect keeps the viewBox's padding
+                painter.BeginPath();
+                painter.MoveTo(Vector2.zero);
+                painter.LineTo(new Vector2(viewBox.width * scale, 0));
+                painter.LineTo(new Vector2(viewBox.width * scale, viewBox.height * scale));
+                painter.LineTo(new Vector2(0, viewBox.height * scale));
+                painter.ClosePath();
+                painter.fillColor = Color.clear;
+                painter.Fill();
+
+                foreach (var shape in document.shapes) {
+                    var fill = ResolveColor(shape.fill, shape.fillOpacity, currentColor);
+                    var stroke = ResolveColor(shape.stroke, shape.strokeOpacity, currentColor);
+                    if (fill == null && stroke == null)
+                        continue;
+                    painter.BeginPath();
+                    foreach (var c in shape.commands) {
+                        switch (c.op) {
+                            case SvgPathOp.MoveTo:
+                                painter.MoveTo((c.p0 - origin) * scale);
+                                break;
+                            case SvgPathOp.LineTo:
+                                painter.LineTo((c.p0 - origin) * scale);
+                                break;
+                            case SvgPathOp.CubicTo:
+                                painter.BezierCurveTo((c.p0 - origin) * scale, (c.p1 - origin) * scale, (c.p2 - origin) * scale);
+                                break;
+                            case SvgPathOp.QuadraticTo:
+                                painter.QuadraticCurveTo((c.p0 - origin) * scale, (c.p1 - origin) * scale);
+                                break;
+                            case SvgPathOp.Close:
+                                painter.ClosePath();
+                                break;
+                        }
+                    }
+                    if (fill != null) {
+                        painter.fillColor = fill.Value;
+                        painter.Fill(shape.evenOdd ? FillRule.OddEven : FillRule.NonZero);
+                    }
+                    if (stroke != null) {
+                        painter.strokeColor = stroke.Value;
+                        painter.lineWidth = shape.strokeWidth * scale;
+                        painter.lineCap = shape.lineCap;
+                        painter.lineJoin = shape.lineJoin;
+                        painter.miterLimit = shape.miterLimit;
+                        painter.Stroke();
+                    }
+                }
+
+                var image = ScriptableObject.CreateInstance<VectorImage>();
+                if (painter.SaveToVectorImage(image))
+                    return image;
+                DestroyImage(image);
+                return null;
+            } finally {
+                painter.Dispose();
+            }
+        }
+
+        static Color? ResolveColor(string value, float opacity, Color currentColor) {
+            if (value == null || opacity <= 0)
+                return null;
+            Color color;
+            if (value == SvgParser.CurrentColor)
+                color = currentColor;
+            else if (!CssGradient.TryParseColor(value, out color))
+                return null;
+            color.a *= opacity;
+            return color;
+        }
+
+        class Entry {
+            public readonly string key;
+            public readonly string path;
+            public readonly VectorImage image;
+            public readonly LinkedListNode<Entry> node;
+            public int refCount;
+            public bool removed;
+
+            public Entry(string key, string path, VectorImage image) {
+                this.key = key;
+                this.path = path;
+                this.image = image;
+                node = new LinkedListNode<Entry>(this);
+            }
+        }
+    }
+}
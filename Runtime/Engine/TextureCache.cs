@@ -0,0 +1,307 @@
+﻿using System.Collections.Generic;
+using UnityEngine;
+
+namespace OneJS {
+    /// <summary>
+    /// The one place loaded images (local files and web images) are cached, keyed by full path or URL.
+    /// Textures are reference counted: whoever displays one Retain()s it and Release()s it when done (see
+    /// Dom.TextureLease). Scripts only hold one if they ask to (Document.retainImage, see HandOut). Once the cached
+    /// textures go over the byte budget, unreferenced ones are destroyed, least recently used first. Referenced
+    /// textures are never evicted, so the budget can be exceeded by what's on screen. Neither are textures looked
+    /// up or added this frame, so a texture a script just loaded survives until its element is attached (Trim()
+    /// catches up the frame after).
+    ///
+    /// Main thread only.
+    /// </summary>
+    public class TextureCache {
+        /// <summary>
+        /// Byte budget. Unreferenced textures are evicted while the cache is over it. 0 or less means unbounded.
+        /// </summary>
+        public long Budget {
+            get => _budget;
+            set {
+                _budget = value;
+                Trim();
+            }
+        }
+
+        readonly Dictionary<string, Entry> _entries = new Dictionary<string, Entry>();
+        readonly Dictionary<Texture2D, Entry> _byTexture = new Dictionary<Texture2D, Entry>();
+        readonly LinkedList<Entry> _lru = new LinkedList<Entry>(); // Unreferenced entries, least recently used first
+        long _budget;
+        long _bytes;
+        long _hits;
+        long _misses;
+        long _evictions;
+
+        public TextureCache(long budget = 0) {
+            _budget = budget;
+        }
+
+        public bool TryGet(string key, out Texture2D texture) {
+            if (_entries.TryGetValue(key, out var entry) && entry.texture != null) {
+                _hits++;
+                entry.frame = Time.frameCount;
+                if (entry.node.List != null) {
+                    _lru.Remove(entry.node);
+                    _lru.AddLast(entry.node);
+                }
+                texture = entry.texture;
+                return true;
+            }
+            _misses++;
+            texture = null;
+            return false;
+        }
+
+        /// <summary>
+        /// Caches a texture under the given key and returns the cached texture. If the key is already taken, the
+        /// given texture is destroyed and the existing one is returned instead.
+        /// </summary>
+        public Texture2D Add(string key, Texture2D texture) {
+            if (_entries.TryGetValue(key, out var existing) && existing.texture != null) {
+                existing.frame = Time.frameCount;
+                if (existing.texture != texture)
+                    DestroyTexture(texture);
+                return existing.texture;
+            }
+            if (existing != null) {
+                // Destroyed behind the cache's back
+                _bytes -= existing.size;
+                Forget(existing);
+            }
+            var entry = new Entry(key, texture, EstimateSize(texture)) { frame = Time.frameCount };
+            _entries[key] = entry;
+            _byTexture[texture] = entry;
+            _bytes += entry.size;
+            _lru.AddLast(entry.node);
+            Trim();
+            return texture;
+        }
+
+        /// <summary>
+        /// Marks a cached texture as in use, so it can't be evicted. Textures that aren't cached are ignored.
+        /// </summary>
+        public void Retain(Texture2D texture) {
+            if (texture == null || !_byTexture.TryGetValue(texture, out var entry))
+                return;
+            if (entry.refCount++ == 0 && entry.node.List != null)
+                _lru.Remove(entry.node);
+        }
+
+        public void Release(Texture2D texture) {
+            // Hand-outs are only released through ReleaseHandOut()
+            if (texture == null || !_byTexture.TryGetValue(texture, out var entry) || entry.refCount <= entry.handOuts)
+                return;
+            Release(entry, 1);
+        }
+
+        /// <summary>
+        /// Retains a texture on behalf of a script, which can't be tracked otherwise (Document.retainImage). It stays
+        /// retained until ReleaseHandOut() (Document.releaseImage) or ReleaseHandOuts() (reload).
+        /// </summary>
+        public Texture2D HandOut(Texture2D texture) {
+            if (texture == null || !_byTexture.TryGetValue(texture, out var entry))
+                return texture;
+            entry.handOuts++;
+            Retain(texture);
+            return texture;
+        }
+
+        public void ReleaseHandOut(Texture2D texture) {
+            if (texture == null || !_byTexture.TryGetValue(texture, out var entry) || entry.handOuts == 0)
+                return;
+            entry.handOuts--;
+            Release(entry, 1);
+        }
+
+        /// <summary>
+        /// Lets go of everything handed to scripts (i.e. when the JsEnv holding them is disposed).
+        /// </summary>
+        public void ReleaseHandOuts() {
+            var handedOut = new List<Entry>();
+            foreach (var entry in _byTexture.Values) {
+                if (entry.handOuts > 0)
+                    handedOut.Add(entry);
+            }
+            foreach (var entry in handedOut) {
+                var count = entry.handOuts;
+                entry.handOuts = 0;
+                Release(entry, count);
+            }
+        }
+
+        void Release(Entry entry, int count) {
+            entry.refCount = Mathf.Max(0, entry.refCount - count);
+            if (entry.refCount > 0)
+                return;
+            if (entry.removed) {
+                Forget(entry);
+                Destroy(entry);
+                return;
+            }
+            _lru.AddLast(entry.node);
+            Trim();
+        }
+
+        /// <summary>
+        /// Drops a key (i.e. to refresh a web image). The texture is destroyed right away if unreferenced,
+        /// otherwise once it's released.
+        /// </summary>
+        public void Remove(string key) {
+            if (!_entries.TryGetValue(key, out var entry))
+                return;
+            _entries.Remove(key);
+            _bytes -= entry.size;
+            entry.removed = true;
+            if (entry.refCount == 0) {
+                Forget(entry);
+                Destroy(entry);
+            }
+        }
+
+        /// <summary>
+        /// Evicts unreferenced textures, least recently used first, until the cache is within budget. Textures used
+        /// this frame are kept (ScriptEngine trims again every frame).
+        /// </summary>
+        public void Trim() {
+            // Stops at the first texture used this frame (most of what's after it was too); the rest waits a frame
+            while (_budget > 0 && _bytes > _budget && _lru.First != null &&
+                   _lru.First.Value.frame != Time.frameCount) {
+                var entry = _lru.First.Value;
+                _entries.Remove(entry.key);
+                _bytes -= entry.size;
+                Forget(entry);
+                Destroy(entry);
+                _evictions++;
+            }
+        }
+
+        /// <summary>
+        /// Evicts every unreferenced texture, regardless of the budget (i.e. on reload, so edited images are
+        /// picked up).
+        /// </summary>
+        public void Purge() {
+            while (_lru.First != null) {
+                var entry = _lru.First.Value;
+                _entries.Remove(entry.key);
+                _bytes -= entry.size;
+                Forget(entry);
+                Destroy(entry);
+            }
+        }
+
+        /// <summary>
+        /// Destroys every unreferenced texture and drops the keys of the rest, so the next load reads the file again.
+        /// Referenced textures stay alive until they're released, same as with Remove().
+        /// </summary>
+        public void Clear() {
+            Purge();
+            foreach (var key in new List<string>(_entries.Keys))
+                Remove(key);
+        }
+
+        public TextureCacheStats GetStats() {
+            var referenced = 0;
+            foreach (var entry in _entries.Values) {
+                if (entry.refCount > 0)
+                    referenced++;
+            }
+            return new TextureCacheStats {
+                count = _entries.Count,
+                referenced = referenced,
+                bytes = _bytes,
+                budget = _budget,
+                hits = _hits,
+                misses = _misses,
+                evictions = _evictions
+            };
+        }
+
+        void Forget(Entry entry) {
+            if (entry.node.List != null)
+                _lru.Remove(entry.node);
+            _byTexture.Remove(entry.texture);
+        }
+
+        static void Destroy(Entry entry) {
+            DestroyTexture(entry.texture);
+        }
+
+        static void DestroyTexture(Texture2D texture) {
+            if (texture == null)
+                return;
+            // Editor documents (EditorDocument) use the cache outside of play mode
+            if (Application.isPlaying)
+                Object.Destroy(texture);
+            else
+                Object.DestroyImmediate(texture);
+        }
+
+        /// <summary>
+        /// Approximate GPU (and CPU, for readable textures) memory of a texture, mip chain included.
+        /// </summary>
+        static long EstimateSize(Texture2D texture) {
+            int bytesPerPixel;
+            switch (texture.format) {
+                case TextureFormat.Alpha8:
+                case TextureFormat.R8:
+                    bytesPerPixel = 1;
+                    break;
+                case TextureFormat.RGB24:
+                    bytesPerPixel = 3;
+                    break;
+                case TextureFormat.RGBAHalf:
+                    bytesPerPixel = 8;
+                    break;
+                case TextureFormat.RGBAFloat:
+                    bytesPerPixel = 16;
+                    break;
+                default:
+                    bytesPerPixel = 4;
+                    break;
+            }
+            var size = (long)texture.width * texture.height * bytesPerPixel;
+            return texture.mipmapCount > 1 ? size * 4 / 3 : size;
+        }
+
+        class Entry {
+            public readonly string key;
+            public readonly Texture2D texture;
+            public readonly long size;
+            public readonly LinkedListNode<Entry> node;
+            public int refCount;
+            /// <summary>
+            /// How much of refCount is from HandOut()
+            /// </summary>
+            public int handOuts;
+            /// <summary>
+            /// Last frame it was looked up or added
+            /// </summary>
+            public int frame;
+            public bool removed;
+
+            public Entry(string key, Texture2D texture, long size) {
+                this.key = key;
+                this.texture = texture;
+                this.size = size;
+                node = new LinkedListNode<Entry>(this);
+            }
+        }
+    }
+
+    public struct TextureCacheStats {
+        public int count;
+        public int referenced;
+        public long bytes;
+        public long budget;
+        public long hits;
+        public long misses;
+        public long evictions;
+
+        public override string ToString() {
+            return $"{count} textures ({referenced} in use), {bytes / (1024f * 1024f):0.0}/{budget / (1024f * 1024f):0.0} MB, " +
+                   $"{hits} hits, {misses} misses, {evictions} evictions";
+        }
+    }
+}
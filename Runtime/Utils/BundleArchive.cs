@@ -0,0 +1,169 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+using ICSharpCode.SharpZipLib.GZip;
+using ICSharpCode.SharpZipLib.Tar;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// A read-only, in-memory view of a bundle, indexed by a central directory (path -> offset, length) so lookups
+    /// are O(1) and reads don't touch the disk. A tarball is inflated once into a single buffer; a BundlePack is
+    /// used as is and each file is only decompressed the first time it's read.
+    /// Paths are relative to the bundle root (i.e. the WorkingDir) and use forward slashes.
+    /// </summary>
+    public class BundleArchive {
+        readonly byte[] _data;
+        readonly Dictionary<string, Entry> _entries;
+        // Decompressed BundlePack entries, by normalized path. Reads can come from the thread pool (prefetching).
+        readonly ConcurrentDictionary<string, byte[]> _decompressed = new ConcurrentDictionary<string, byte[]>(StringComparer.Ordinal);
+
+        BundleArchive(byte[] data, Dictionary<string, Entry> entries) {
+            _data = data;
+            _entries = entries;
+        }
+
+        public int Count => _entries.Count;
+
+        public IEnumerable<string> Paths => _entries.Keys;
+
+        /// <summary>
+        /// Size of the backing buffer, in bytes.
+        /// </summary>
+        public long Size => _data.Length;
+
+        /// <summary>
+        /// Builds an archive from bundle bytes (i.e. Bundler.bundleZip), whatever the codec.
+        /// </summary>
+        public static BundleArchive FromBytes(byte[] bytes) {
+            return BundlePack.IsPack(bytes) ? FromPack(bytes) : FromTgz(bytes);
+        }
+
+        /// <summary>
+        /// Indexes a BundlePack without decompressing anything. The archive keeps a reference to the bytes.
+        /// </summary>
+        public static BundleArchive FromPack(byte[] bytes) {
+            var directory = BundlePack.ReadDirectory(bytes);
+            var entries = new Dictionary<string, Entry>(directory.Count, StringComparer.Ordinal);
+            foreach (var e in directory)
+                entries[NormalizePath(e.path)] = new Entry((int)e.offset, e.length, e.storedLength, e.method);
+            return new BundleArchive(bytes, entries);
+        }
+
+        /// <summary>
+        /// Builds an archive from gzipped tar bytes.
+        /// </summary>
+        public static BundleArchive FromTgz(byte[] bytes) {
+            using (var gzipStream = new GZipInputStream(new MemoryStream(bytes))) {
+                return FromTar(gzipStream);
+            }
+        }
+
+        public static BundleArchive FromTar(Stream tarStream) {
+            var entries = new Dictionary<string, Entry>(StringComparer.Ordinal);
+            var data = new MemoryStream();
+            using (var tar = new TarInputStream(tarStream) { IsStreamOwner = false }) {
+                TarEntry entry;
+                while ((entry = tar.GetNextEntry()) != null) {
+                    if (entry.IsDirectory)
+                        continue;
+                    if (data.Length + entry.Size > int.MaxValue)
+                        throw new InvalidDataException($"Bundle is too large to serve from memory (over 2 GB): {entry.Name}");
+                    var offset = (int)data.Length;
+                    tar.CopyEntryContents(data);
+                    var length = (int)data.Length - offset;
+                    entries[NormalizePath(entry.Name)] = new Entry(offset, length, length, BundlePack.MethodStored);
+                }
+            }
+            return new BundleArchive(data.ToArray(), entries);
+        }
+
+        public bool Contains(string path) {
+            return _entries.ContainsKey(NormalizePath(path));
+        }
+
+        /// <summary>
+        /// Returns the file contents. The segment is a view into the archive buffer, or into the cached decompressed
+        /// entry (no copy either way), so it must not be modified.
+        /// </summary>
+        public bool TryGetSegment(string path, out ArraySegment<byte> segment) {
+            path = NormalizePath(path);
+            if (_entries.TryGetValue(path, out var entry)) {
+                if (entry.method == BundlePack.MethodStored) {
+                    segment = new ArraySegment<byte>(_data, entry.offset, entry.length);
+                } else {
+                    segment = new ArraySegment<byte>(_decompressed.GetOrAdd(path, _ => {
+                        var bytes = new byte[entry.length];
+                        Lz4.Decompress(_data, entry.offset, entry.storedLength, bytes, 0, entry.length);
+                        return bytes;
+                    }));
+                }
+                return true;
+            }
+            segment = default;
+            return false;
+        }
+
+        /// <summary>
+        /// Returns a copy of the file contents, or null if the path isn't in the archive.
+        /// </summary>
+        public byte[] ReadAllBytes(string path) {
+            if (!TryGetSegment(path, out var segment))
+                return null;
+            var bytes = new byte[segment.Count];
+            Buffer.BlockCopy(segment.Array, segment.Offset, bytes, 0, segment.Count);
+            return bytes;
+        }
+
+        /// <summary>
+        /// Returns the file contents decoded as UTF-8, or null if the path isn't in the archive.
+        /// </summary>
+        public string ReadAllText(string path) {
+            if (!TryGetSegment(path, out var segment))
+                return null;
+            return Encoding.UTF8.GetString(segment.Array, segment.Offset, segment.Count);
+        }
+
+        public Stream OpenRead(string path) {
+            if (!TryGetSegment(path, out var segment))
+                return null;
+            return new MemoryStream(segment.Array, segment.Offset, segment.Count, false);
+        }
+
+        /// <summary>
+        /// Forward slashes, no leading "./" or "/", and "." / ".." segments collapsed.
+        /// </summary>
+        public static string NormalizePath(string path) {
+            path = path.Replace('\\', '/');
+            if (path.IndexOf("./", StringComparison.Ordinal) < 0 && !path.StartsWith("/"))
+                return path;
+            var parts = new List<string>();
+            foreach (var part in path.Split('/')) {
+                if (part.Length == 0 || part == ".")
+                    continue;
+                if (part == "..") {
+                    if (parts.Count > 0)
+                        parts.RemoveAt(parts.Count - 1);
+                    continue;
+                }
+                parts.Add(part);
+            }
+            return string.Join("/", parts);
+        }
+
+        readonly struct Entry {
+            public readonly int offset;
+            public readonly int length;
+            public readonly int storedLength;
+            public readonly byte method;
+
+            public Entry(int offset, int length, int storedLength, byte method) {
+                this.offset = offset;
+                this.length = length;
+                this.storedLength = storedLength;
+                this.method = method;
+            }
+        }
+    }
+}
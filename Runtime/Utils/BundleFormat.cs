@@ -0,0 +1,98 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using ICSharpCode.SharpZipLib.GZip;
+using ICSharpCode.SharpZipLib.Tar;
+
+namespace OneJS.Utils {
+    public enum BundleCodec {
+        /// <summary>
+        /// A gzipped tarball. Smallest, but the whole thing has to be inflated sequentially.
+        /// </summary>
+        Gzip,
+        /// <summary>
+        /// A BundlePack with per-file LZ4. Somewhat bigger, much faster to decompress, and seekable.
+        /// </summary>
+        LZ4
+    }
+
+    /// <summary>
+    /// Where TarCreator writes its entries to, so packaging doesn't depend on the container format.
+    /// </summary>
+    public interface IBundleWriter : IDisposable {
+        void WriteEntry(string name, byte[] bytes);
+    }
+
+    public class TarBundleWriter : IBundleWriter {
+        readonly TarOutputStream _tarOutputStream;
+        readonly bool _ownsStream;
+
+        public TarBundleWriter(TarOutputStream tarOutputStream, bool ownsStream = true) {
+            _tarOutputStream = tarOutputStream;
+            _ownsStream = ownsStream;
+        }
+
+        public void WriteEntry(string name, byte[] bytes) {
+            TarEntry entry = TarEntry.CreateTarEntry(name);
+            entry.Size = bytes.Length;
+            _tarOutputStream.PutNextEntry(entry);
+            _tarOutputStream.Write(bytes, 0, bytes.Length);
+            _tarOutputStream.CloseEntry();
+        }
+
+        public void Dispose() {
+            if (_ownsStream)
+                _tarOutputStream.Close();
+        }
+    }
+
+    public static class BundleFormat {
+        /// <summary>
+        /// Creates a writer for the given codec. Disposing the writer finishes the bundle and closes the stream.
+        /// </summary>
+        public static IBundleWriter CreateWriter(Stream stream, BundleCodec codec) {
+            switch (codec) {
+                case BundleCodec.LZ4:
+                    return new BundlePackWriter(stream);
+                default:
+                    return new TarBundleWriter(new TarOutputStream(new ParallelGZipOutputStream(stream, 3)));
+            }
+        }
+
+        public static BundleCodec Detect(byte[] bytes) {
+            return BundlePack.IsPack(bytes) ? BundleCodec.LZ4 : BundleCodec.Gzip;
+        }
+
+        /// <summary>
+        /// Decompresses every file in the bundle in order, whatever the codec.
+        /// </summary>
+        public static IEnumerable<KeyValuePair<string, byte[]>> ReadEntries(byte[] bytes) {
+            return Detect(bytes) == BundleCodec.LZ4 ? ReadPackEntries(bytes) : ReadTarEntries(bytes);
+        }
+
+        static IEnumerable<KeyValuePair<string, byte[]>> ReadPackEntries(byte[] bytes) {
+            foreach (var entry in BundlePack.ReadDirectory(bytes))
+                yield return new KeyValuePair<string, byte[]>(entry.path, BundlePack.ReadEntry(bytes, entry));
+        }
+
+        static IEnumerable<KeyValuePair<string, byte[]>> ReadTarEntries(byte[] bytes) {
+            using (var gzipStream = new GZipInputStream(new MemoryStream(bytes)))
+            using (var tarStream = new TarInputStream(gzipStream)) {
+                TarEntry entry;
+                while ((entry = tarStream.GetNextEntry()) != null) {
+                    if (entry.IsDirectory)
+                        continue;
+                    var data = new byte[entry.Size];
+                    var read = 0;
+                    while (read < data.Length) {
+                        var n = tarStream.Read(data, read, data.Length - read);
+                        if (n <= 0)
+                            throw new EndOfStreamException($"Unexpected end of bundle in {entry.Name}");
+                        read += n;
+                    }
+                    yield return new KeyValuePair<string, byte[]>(entry.Name, data);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,73 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Security.Cryptography;
+using System.Text;
+using Newtonsoft.Json;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Path, hash and size of every file in a bundle. It's packaged as the last tar entry of bundle.tgz, and
+    /// a copy is kept in the WorkingDir after extraction so the next deployment only rewrites what changed.
+    /// </summary>
+    [Serializable]
+    public class BundleManifest {
+        public const string FileName = ".onejs-manifest.json";
+
+        public List<BundleManifestEntry> files = new List<BundleManifestEntry>();
+
+        Dictionary<string, BundleManifestEntry> _lookup;
+
+        public void Add(string path, string hash, long size) {
+            files.Add(new BundleManifestEntry { path = path, hash = hash, size = size });
+            _lookup = null;
+        }
+
+        public bool TryGetEntry(string path, out BundleManifestEntry entry) {
+            if (_lookup == null) {
+                _lookup = new Dictionary<string, BundleManifestEntry>(files.Count, StringComparer.Ordinal);
+                foreach (var file in files)
+                    _lookup[file.path] = file;
+            }
+            return _lookup.TryGetValue(path, out entry);
+        }
+
+        public byte[] ToBytes() {
+            return Encoding.UTF8.GetBytes(JsonConvert.SerializeObject(this, Formatting.Indented));
+        }
+
+        public static BundleManifest FromBytes(byte[] bytes) {
+            return JsonConvert.DeserializeObject<BundleManifest>(Encoding.UTF8.GetString(bytes));
+        }
+
+        /// <summary>
+        /// Returns null if there's no (readable) manifest at the given path.
+        /// </summary>
+        public static BundleManifest Load(string path) {
+            if (!File.Exists(path))
+                return null;
+            try {
+                return FromBytes(File.ReadAllBytes(path));
+            } catch (Exception) {
+                return null;
+            }
+        }
+
+        public void Save(string path) {
+            File.WriteAllBytes(path, ToBytes());
+        }
+
+        public static string ComputeHash(byte[] bytes) {
+            using (var md5 = MD5.Create()) {
+                return BitConverter.ToString(md5.ComputeHash(bytes)).Replace("-", "").ToLowerInvariant();
+            }
+        }
+    }
+
+    [Serializable]
+    public class BundleManifestEntry {
+        public string path;
+        public string hash;
+        public long size;
+    }
+}
@@ -0,0 +1,159 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// A seekable bundle container where every file is LZ4-compressed on its own, so any single file can be
+    /// decompressed on demand without touching the rest.
+    ///
+    /// Layout (little-endian):
+    ///   "OJSB" | u32 version
+    ///   file data...
+    ///   directory: per entry { u16 pathLength | path (UTF-8) | u64 offset | u32 storedLength | u32 length | u8 method }
+    ///   footer: u64 directoryOffset | u32 entryCount | "OJSB"
+    /// The directory goes last so the writer can stream; readers start from the fixed-size footer.
+    /// </summary>
+    public static class BundlePack {
+        public const int Version = 1;
+        public const byte MethodStored = 0;
+        public const byte MethodLz4 = 1;
+
+        internal static readonly byte[] Magic = { (byte)'O', (byte)'J', (byte)'S', (byte)'B' };
+        const int HeaderSize = 8;
+        const int FooterSize = 16;
+
+        public static bool IsPack(byte[] bytes) {
+            return bytes != null && bytes.Length >= HeaderSize + FooterSize && bytes[0] == Magic[0] &&
+                   bytes[1] == Magic[1] && bytes[2] == Magic[2] && bytes[3] == Magic[3];
+        }
+
+        /// <summary>
+        /// Reads the central directory. Entries are in the order they were written.
+        /// </summary>
+        public static List<BundlePackEntry> ReadDirectory(byte[] bytes) {
+            if (!IsPack(bytes))
+                throw new InvalidDataException("Not a OneJS bundle pack");
+            var footer = bytes.Length - FooterSize;
+            var directoryOffset = (long)BitConverter.ToUInt64(bytes, footer);
+            var count = (int)BitConverter.ToUInt32(bytes, footer + 8);
+            if (directoryOffset < HeaderSize || directoryOffset > footer)
+                throw new InvalidDataException("Corrupted bundle pack directory");
+
+            var entries = new List<BundlePackEntry>(count);
+            var pos = (int)directoryOffset;
+            for (int i = 0; i < count; i++) {
+                var pathLength = BitConverter.ToUInt16(bytes, pos);
+                var entry = new BundlePackEntry {
+                    path = Encoding.UTF8.GetString(bytes, pos + 2, pathLength)
+                };
+                pos += 2 + pathLength;
+                entry.offset = (long)BitConverter.ToUInt64(bytes, pos);
+                entry.storedLength = (int)BitConverter.ToUInt32(bytes, pos + 8);
+                entry.length = (int)BitConverter.ToUInt32(bytes, pos + 12);
+                entry.method = bytes[pos + 16];
+                pos += 17;
+                if (entry.offset < HeaderSize || entry.offset + entry.storedLength > directoryOffset)
+                    throw new InvalidDataException($"Corrupted bundle pack entry: {entry.path}");
+                entries.Add(entry);
+            }
+            return entries;
+        }
+
+        public static byte[] ReadEntry(byte[] bytes, BundlePackEntry entry) {
+            var data = new byte[entry.length];
+            if (entry.method == MethodStored) {
+                Buffer.BlockCopy(bytes, (int)entry.offset, data, 0, entry.length);
+            } else if (entry.method == MethodLz4) {
+                Lz4.Decompress(bytes, (int)entry.offset, entry.storedLength, data, 0, entry.length);
+            } else {
+                throw new InvalidDataException($"Unknown compression method {entry.method} for {entry.path}");
+            }
+            return data;
+        }
+    }
+
+    public struct BundlePackEntry {
+        public string path;
+        public long offset;
+        public int storedLength;
+        public int length;
+        public byte method;
+    }
+
+    /// <summary>
+    /// Streams files into a BundlePack. Files that don't shrink under LZ4 are stored as is.
+    /// </summary>
+    public class BundlePackWriter : IBundleWriter {
+        readonly Stream _stream;
+        readonly bool _ownsStream;
+        readonly List<BundlePackEntry> _entries = new List<BundlePackEntry>();
+        long _position;
+        byte[] _buffer = new byte[0];
+        bool _finished;
+
+        public BundlePackWriter(Stream stream, bool ownsStream = true) {
+            _stream = stream;
+            _ownsStream = ownsStream;
+            Write(BundlePack.Magic, 4);
+            Write(BitConverter.GetBytes((uint)BundlePack.Version), 4);
+        }
+
+        public void WriteEntry(string name, byte[] bytes) {
+            var needed = Lz4.MaxCompressedLength(bytes.Length);
+            if (_buffer.Length < needed)
+                _buffer = new byte[needed];
+            var compressedLength = Lz4.Compress(bytes, 0, bytes.Length, _buffer, 0);
+            var entry = new BundlePackEntry { path = name, offset = _position, length = bytes.Length };
+            if (compressedLength < bytes.Length) {
+                entry.method = BundlePack.MethodLz4;
+                entry.storedLength = compressedLength;
+                Write(_buffer, compressedLength);
+            } else {
+                entry.method = BundlePack.MethodStored;
+                entry.storedLength = bytes.Length;
+                Write(bytes, bytes.Length);
+            }
+            _entries.Add(entry);
+        }
+
+        /// <summary>
+        /// Writes the directory and footer. Called by Dispose() if not done explicitly.
+        /// </summary>
+        public void Finish() {
+            if (_finished)
+                return;
+            var directoryOffset = _position;
+            var dir = new MemoryStream();
+            using (var writer = new BinaryWriter(dir, Encoding.UTF8, true)) {
+                foreach (var entry in _entries) {
+                    var path = Encoding.UTF8.GetBytes(entry.path);
+                    writer.Write((ushort)path.Length);
+                    writer.Write(path);
+                    writer.Write((ulong)entry.offset);
+                    writer.Write((uint)entry.storedLength);
+                    writer.Write((uint)entry.length);
+                    writer.Write(entry.method);
+                }
+                writer.Write((ulong)directoryOffset);
+                writer.Write((uint)_entries.Count);
+                writer.Write(BundlePack.Magic);
+            }
+            Write(dir.GetBuffer(), (int)dir.Length);
+            _stream.Flush();
+            _finished = true;
+        }
+
+        public void Dispose() {
+            Finish();
+            if (_ownsStream)
+                _stream.Dispose();
+        }
+
+        void Write(byte[] bytes, int count) {
+            _stream.Write(bytes, 0, count);
+            _position += count;
+        }
+    }
+}
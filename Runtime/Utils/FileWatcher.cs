@@ -0,0 +1,165 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Security.Cryptography;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Event-driven file watching for live reload. Wraps one or more FileSystemWatchers, debounces bursts of
+    /// writes, and only reports files whose content hash actually changed (esbuild and postcss often rewrite
+    /// identical outputs).
+    ///
+    /// FileSystemWatcher events arrive on thread pool threads, so they are only queued there. Call Poll() from
+    /// the main thread (e.g. MonoBehaviour.Update or EditorApplication.update) to get OnChanged raised.
+    /// </summary>
+    public class FileWatcher : IDisposable {
+        /// <summary>
+        /// Raised from Poll() with the full paths of all files whose content changed since the last report.
+        /// </summary>
+        public event Action<IReadOnlyList<string>> OnChanged;
+
+        /// <summary>
+        /// How long a file must stay quiet (no further write events) before it's hashed and reported.
+        /// </summary>
+        public int DebounceMilliseconds { get; set; }
+
+        readonly List<FileSystemWatcher> _watchers = new List<FileSystemWatcher>();
+        readonly HashSet<string> _watchedFiles = new HashSet<string>();
+        readonly ConcurrentDictionary<string, long> _pending = new ConcurrentDictionary<string, long>();
+        readonly Dictionary<string, string> _hashes = new Dictionary<string, string>();
+        readonly List<string> _ready = new List<string>();
+        readonly List<string> _changed = new List<string>();
+        readonly Stopwatch _clock = Stopwatch.StartNew();
+
+        public FileWatcher(int debounceMilliseconds = 50) {
+            DebounceMilliseconds = debounceMilliseconds;
+        }
+
+        /// <summary>
+        /// Watches a single file. The current content hash is recorded so that a later write of the same
+        /// content won't be reported. Watching an already watched file is a no-op.
+        /// </summary>
+        public void WatchFile(string filepath) {
+            var fullpath = Path.GetFullPath(filepath);
+            var dir = Path.GetDirectoryName(fullpath);
+            if (string.IsNullOrEmpty(dir) || !Directory.Exists(dir) || !_watchedFiles.Add(fullpath))
+                return;
+            AddWatcher(dir, Path.GetFileName(fullpath), false);
+            Track(fullpath);
+        }
+
+        /// <summary>
+        /// Watches every file matching the filter under the given directory. Files are hashed lazily, so the
+        /// first reported write of an untracked file always counts as a change.
+        /// </summary>
+        public void WatchDirectory(string dirpath, string filter = "*.*", bool recursive = true) {
+            var fullpath = Path.GetFullPath(dirpath);
+            if (!Directory.Exists(fullpath))
+                return;
+            AddWatcher(fullpath, filter, recursive);
+        }
+
+        /// <summary>
+        /// Records the current content hash of a file as its baseline.
+        /// </summary>
+        public void Track(string filepath) {
+            var fullpath = Path.GetFullPath(filepath);
+            var hash = ComputeHash(fullpath);
+            if (hash != null)
+                _hashes[fullpath] = hash;
+        }
+
+        /// <summary>
+        /// Stops all watching and forgets every tracked hash.
+        /// </summary>
+        public void Clear() {
+            foreach (var watcher in _watchers) {
+                watcher.EnableRaisingEvents = false;
+                watcher.Dispose();
+            }
+            _watchers.Clear();
+            _watchedFiles.Clear();
+            _pending.Clear();
+            _hashes.Clear();
+        }
+
+        /// <summary>
+        /// Processes queued file events. Must be called from the main thread.
+        /// </summary>
+        public void Poll() {
+            if (_pending.IsEmpty)
+                return;
+            var now = _clock.ElapsedMilliseconds;
+            _ready.Clear();
+            foreach (var kv in _pending) {
+                if (now - kv.Value >= DebounceMilliseconds)
+                    _ready.Add(kv.Key);
+            }
+            if (_ready.Count == 0)
+                return;
+
+            _changed.Clear();
+            foreach (var path in _ready) {
+                var stamp = _pending[path];
+                var hash = ComputeHash(path);
+                if (hash == null && File.Exists(path))
+                    continue; // Still locked by the writer, try again on the next Poll()
+                // Only dequeue if no newer event came in while we were hashing
+                if (!_pending.TryRemove(path, out var latest))
+                    continue;
+                if (latest != stamp) {
+                    _pending.TryAdd(path, latest);
+                    continue;
+                }
+                if (hash == null) {
+                    // Deleted. Forget it so that re-creating the same content is reported.
+                    _hashes.Remove(path);
+                    continue;
+                }
+                if (_hashes.TryGetValue(path, out var prev) && prev == hash)
+                    continue;
+                _hashes[path] = hash;
+                _changed.Add(path);
+            }
+            if (_changed.Count > 0)
+                OnChanged?.Invoke(_changed.ToArray());
+        }
+
+        public void Dispose() {
+            Clear();
+            OnChanged = null;
+        }
+
+        void AddWatcher(string dir, string filter, bool recursive) {
+            var watcher = new FileSystemWatcher(dir, filter) {
+                IncludeSubdirectories = recursive,
+                NotifyFilter = NotifyFilters.LastWrite | NotifyFilters.FileName | NotifyFilters.Size
+            };
+            watcher.Changed += OnFileEvent;
+            watcher.Created += OnFileEvent;
+            watcher.Renamed += OnFileEvent; // Atomic "write tmp + rename" saves
+            watcher.EnableRaisingEvents = true;
+            _watchers.Add(watcher);
+        }
+
+        // Called on a thread pool thread
+        void OnFileEvent(object sender, FileSystemEventArgs e) {
+            _pending[e.FullPath] = _clock.ElapsedMilliseconds;
+        }
+
+        static string ComputeHash(string path) {
+            try {
+                using (var stream = new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.ReadWrite))
+                using (var md5 = MD5.Create()) {
+                    return Convert.ToBase64String(md5.ComputeHash(stream));
+                }
+            } catch (IOException) {
+                return null;
+            } catch (UnauthorizedAccessException) {
+                return null;
+            }
+        }
+    }
+}
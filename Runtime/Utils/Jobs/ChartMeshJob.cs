@@ -0,0 +1,301 @@
+﻿using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// One series for ChartMeshJob: where its values are in the shared array and how to draw it.
+    /// </summary>
+    public struct ChartSeriesInfo {
+        public int offset;
+        public int count;
+        public float4 lineColor;
+        /// <summary>
+        /// The area under the line; zero alpha for none
+        /// </summary>
+        public float4 fillColor;
+        /// <summary>
+        /// 0 for no line
+        /// </summary>
+        public float lineWidth;
+        /// <summary>
+        /// Start of this series' room in vertices/indices (see ChartMeshJob.Capacity)
+        /// </summary>
+        public int vertexStart;
+        public int indexStart;
+    }
+
+    /// <summary>
+    /// Builds the meshes for Chart (line + area per series) from the raw values in one pass. Series with more
+    /// points than fit in the width are decimated per pixel column down to its first, min, max and last points,
+    /// which keeps the exact same outline on screen. Points are evenly spaced and right-aligned in a `domain` of
+    /// points (so a streaming series scrolls in from the right); y goes from yMin at the bottom to yMax at the top,
+    /// both taken from the data when NaN. NaN values are skipped.
+    ///
+    /// Every series gets up to two chunks in `chunks` (area, then line), each (vertexStart, vertexCount, indexStart,
+    /// indexCount) with indices relative to the chunk's first vertex, i.e. ready for one MeshGenerationContext.Allocate
+    /// each.
+    /// </summary>
+    [BurstCompile]
+    public struct ChartMeshJob : IJob {
+        /// <summary>
+        /// Pixel columns at most, so a series' line always fits in 65535 vertices
+        /// </summary>
+        public const int MaxColumns = 3900;
+        const int LineVerticesPerPoint = 4;
+        const int LineIndicesPerSegment = 18;
+        const int AreaVerticesPerPoint = 2;
+        const int AreaIndicesPerSegment = 6;
+
+        [ReadOnly] public NativeArray<float> values;
+        [ReadOnly] public NativeArray<ChartSeriesInfo> series;
+        /// <summary>
+        /// Scratch, Capacity() points per series (x in pixels, y as a value)
+        /// </summary>
+        public NativeArray<float2> points;
+        public NativeArray<Vertex> vertices;
+        [WriteOnly] public NativeArray<ushort> indices;
+        /// <summary>
+        /// Two per series, see above
+        /// </summary>
+        [WriteOnly] public NativeArray<int4> chunks;
+        /// <summary>
+        /// The y range used (resolved from the data if NaN)
+        /// </summary>
+        [WriteOnly] public NativeArray<float2> range;
+        public float2 origin;
+        public float width;
+        public float height;
+        public int columns;
+        public int domain;
+        public float yMin;
+        public float yMax;
+        public float nearZ;
+
+        /// <summary>
+        /// Most points a series with `count` values can decimate to.
+        /// </summary>
+        public static int MaxPoints(int count, int columns) {
+            return math.min(count, columns * 4 + 4);
+        }
+
+        /// <summary>
+        /// Vertices and indices to reserve for a series with `count` values.
+        /// </summary>
+        public static int2 Capacity(int count, int columns) {
+            var points = MaxPoints(count, columns);
+            var segments = math.max(points - 1, 0);
+            return new int2(points * (LineVerticesPerPoint + AreaVerticesPerPoint),
+                segments * (LineIndicesPerSegment + AreaIndicesPerSegment));
+        }
+
+        public void Execute() {
+            var lo = float.PositiveInfinity;
+            var hi = float.NegativeInfinity;
+            var pointStarts = new NativeArray<int2>(series.Length, Allocator.Temp);
+            var pointCursor = 0;
+            for (int s = 0; s < series.Length; s++) {
+                var count = Decimate(series[s], pointCursor, ref lo, ref hi);
+                pointStarts[s] = new int2(pointCursor, count);
+                pointCursor += MaxPoints(series[s].count, columns);
+            }
+
+            var min = float.IsNaN(yMin) ? lo : yMin;
+            var max = float.IsNaN(yMax) ? hi : yMax;
+            if (float.IsInfinity(min) || float.IsInfinity(max)) {
+                min = 0;
+                max = 1;
+            } else if (max - min < 1e-6f) {
+                min -= 0.5f;
+                max += 0.5f;
+            }
+            range[0] = new float2(min, max);
+
+            var scale = height / (max - min);
+            for (int s = 0; s < series.Length; s++) {
+                var info = series[s];
+                var start = pointStarts[s].x;
+                var count = pointStarts[s].y;
+                for (int i = 0; i < count; i++) {
+                    var p = points[start + i];
+                    points[start + i] = origin + new float2(p.x, height - (p.y - min) * scale);
+                }
+                var vertex = info.vertexStart;
+                var index = info.indexStart;
+                chunks[s * 2] = info.fillColor.w > 0 ? BuildArea(info, start, count, ref vertex, ref index) : int4.zero;
+                chunks[s * 2 + 1] = info.lineWidth > 0 ? BuildLine(info, start, count, ref vertex, ref index) : int4.zero;
+            }
+            pointStarts.Dispose();
+        }
+
+        /// <summary>
+        /// Writes the series' points (pixel x, value y) from `start`, one column at a time. Returns the count.
+        /// </summary>
+        int Decimate(ChartSeriesInfo info, int start, ref float lo, ref float hi) {
+            var n = info.count;
+            if (n == 0)
+                return 0;
+            var step = domain > 1 ? width / (domain - 1) : 0;
+            var first = domain - n;
+            var decimate = n > columns * 2;
+            var columnWidth = width / columns;
+            var written = 0;
+
+            // The current column's first, min, max and last (index, value)
+            var column = int.MinValue;
+            int4 picked = default;
+            float4 pickedValues = default;
+            for (int i = 0; i < n; i++) {
+                var v = values[info.offset + i];
+                if (float.IsNaN(v))
+                    continue;
+                lo = math.min(lo, v);
+                hi = math.max(hi, v);
+                if (!decimate) {
+                    points[start + written++] = new float2((first + i) * step, v);
+                    continue;
+                }
+                var c = (int)math.clamp((first + i) * step / columnWidth, 0, columns - 1);
+                if (c != column) {
+                    if (column != int.MinValue)
+                        written += Flush(picked, pickedValues, step, first, start + written);
+                    column = c;
+                    picked = new int4(i);
+                    pickedValues = new float4(v);
+                    continue;
+                }
+                if (v < pickedValues.y) {
+                    picked.y = i;
+                    pickedValues.y = v;
+                }
+                if (v > pickedValues.z) {
+                    picked.z = i;
+                    pickedValues.z = v;
+                }
+                picked.w = i;
+                pickedValues.w = v;
+            }
+            if (decimate && column != int.MinValue)
+                written += Flush(picked, pickedValues, step, first, start + written);
+            return written;
+        }
+
+        /// <summary>
+        /// Writes a column's distinct picked points in index order.
+        /// </summary>
+        int Flush(int4 picked, float4 pickedValues, float step, int first, int at) {
+            // Sort the four by index (tiny insertion sort), then skip repeats
+            for (int i = 1; i < 4; i++) {
+                for (int j = i; j > 0 && picked[j] < picked[j - 1]; j--) {
+                    var ti = picked[j];
+                    picked[j] = picked[j - 1];
+                    picked[j - 1] = ti;
+                    var tv = pickedValues[j];
+                    pickedValues[j] = pickedValues[j - 1];
+                    pickedValues[j - 1] = tv;
+                }
+            }
+            var written = 0;
+            for (int i = 0; i < 4; i++) {
+                if (i > 0 && picked[i] == picked[i - 1])
+                    continue;
+                points[at + written++] = new float2((first + picked[i]) * step, pickedValues[i]);
+            }
+            return written;
+        }
+
+        /// <summary>
+        /// Quads from each point down to the bottom edge.
+        /// </summary>
+        int4 BuildArea(ChartSeriesInfo info, int start, int count, ref int vertex, ref int index) {
+            if (count < 2)
+                return int4.zero;
+            var chunk = new int4(vertex, count * AreaVerticesPerPoint, index, (count - 1) * AreaIndicesPerSegment);
+            var color = TextureKernelUtil.ToColor32(info.fillColor);
+            var bottom = origin.y + height;
+            for (int i = 0; i < count; i++) {
+                var p = points[start + i];
+                vertices[vertex++] = MakeVertex(p, color);
+                vertices[vertex++] = MakeVertex(new float2(p.x, bottom), color);
+                if (i == 0)
+                    continue;
+                // Clockwise (y points down): previous top, top, bottom, previous bottom
+                var a = (ushort)((i - 1) * AreaVerticesPerPoint);
+                var b = (ushort)(i * AreaVerticesPerPoint);
+                AddQuad(chunk.x, ref index, a, b, (ushort)(b + 1), (ushort)(a + 1));
+            }
+            return chunk;
+        }
+
+        /// <summary>
+        /// A mitered polyline with a one pixel feather on each side (transparent outer vertices) for anti-aliasing.
+        /// </summary>
+        int4 BuildLine(ChartSeriesInfo info, int start, int count, ref int vertex, ref int index) {
+            if (count < 2)
+                return int4.zero;
+            var chunk = new int4(vertex, count * LineVerticesPerPoint, index, (count - 1) * LineIndicesPerSegment);
+            var halfWidth = info.lineWidth * 0.5f;
+            var inner = math.max(halfWidth - 0.5f, 0);
+            var outer = halfWidth + 0.5f;
+            var solid = info.lineColor;
+            // Hairlines get fainter instead of thinner
+            solid.w *= math.min(info.lineWidth, 1);
+            var solidColor = TextureKernelUtil.ToColor32(solid);
+            var clearColor = TextureKernelUtil.ToColor32(new float4(solid.xyz, 0));
+            for (int i = 0; i < count; i++) {
+                var p = points[start + i];
+                var prev = points[start + math.max(i - 1, 0)];
+                var next = points[start + math.min(i + 1, count - 1)];
+                var d0 = math.normalizesafe(p - prev);
+                var d1 = math.normalizesafe(next - p);
+                if (i == 0)
+                    d0 = d1;
+                else if (i == count - 1)
+                    d1 = d0;
+                var tangent = math.normalizesafe(d0 + d1, d1);
+                // Points "down" on screen for a line going right
+                var normal = new float2(-tangent.y, tangent.x);
+                var cos = math.dot(normal, new float2(-d1.y, d1.x));
+                var miter = math.min(1 / math.max(cos, 0.0001f), 2);
+                var n = normal * miter;
+                vertices[vertex++] = MakeVertex(p - n * outer, clearColor);
+                vertices[vertex++] = MakeVertex(p - n * inner, solidColor);
+                vertices[vertex++] = MakeVertex(p + n * inner, solidColor);
+                vertices[vertex++] = MakeVertex(p + n * outer, clearColor);
+                if (i == 0)
+                    continue;
+                var a = (ushort)((i - 1) * LineVerticesPerPoint);
+                var b = (ushort)(i * LineVerticesPerPoint);
+                for (int k = 0; k < 3; k++)
+                    AddQuad(chunk.x, ref index, (ushort)(a + k), (ushort)(b + k), (ushort)(b + k + 1), (ushort)(a + k + 1));
+            }
+            return chunk;
+        }
+
+        void AddQuad(int baseVertex, ref int index, ushort a, ushort b, ushort c, ushort d) {
+            AddTriangle(baseVertex, ref index, a, b, c);
+            AddTriangle(baseVertex, ref index, a, c, d);
+        }
+
+        /// <summary>
+        /// UI Toolkit wants clockwise triangles (positive area, since y points down). Quads are laid out that way,
+        /// but sharp turns in noisy data can fold the mitered ones over, so check each.
+        /// </summary>
+        void AddTriangle(int baseVertex, ref int index, ushort a, ushort b, ushort c) {
+            var pa = vertices[baseVertex + a].position;
+            var pb = vertices[baseVertex + b].position;
+            var pc = vertices[baseVertex + c].position;
+            var area = (pb.x - pa.x) * (pc.y - pa.y) - (pc.x - pa.x) * (pb.y - pa.y);
+            indices[index++] = a;
+            indices[index++] = area < 0 ? c : b;
+            indices[index++] = area < 0 ? b : c;
+        }
+
+        Vertex MakeVertex(float2 p, Color32 color) {
+            return new Vertex { position = new Vector3(p.x, p.y, nearZ), tint = color };
+        }
+    }
+}
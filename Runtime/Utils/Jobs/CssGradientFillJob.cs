@@ -0,0 +1,65 @@
+﻿using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Fills pixels with a linear or radial multi-stop gradient (see TextureKernels.Gradient, which sets it up from
+    /// a CSS gradient string). Coordinates are in pixels with y pointing down, like CSS.
+    /// </summary>
+    [BurstCompile]
+    public struct CssGradientFillJob : IJobParallelFor {
+        [WriteOnly] public NativeArray<Color32> pixels;
+        [ReadOnly] public NativeArray<float> stopPositions;
+        [ReadOnly] public NativeArray<float4> stopColors;
+        public int width;
+        public int height;
+        public bool radial;
+        public bool repeating;
+        public float2 center;
+        /// <summary>
+        /// Linear: the gradient line's direction
+        /// </summary>
+        public float2 direction;
+        /// <summary>
+        /// Linear: the gradient line's length
+        /// </summary>
+        public float length;
+        /// <summary>
+        /// Radial: the ending shape's radii
+        /// </summary>
+        public float2 radii;
+
+        public void Execute(int index) {
+            var p = TextureKernelUtil.PixelPosition(index, width, height);
+            float t;
+            if (radial) {
+                t = math.length((p - center) / radii);
+            } else {
+                t = math.dot(p - center, direction) / length + 0.5f;
+            }
+            var count = stopPositions.Length;
+            var first = stopPositions[0];
+            var period = stopPositions[count - 1] - first;
+            if (repeating && period > 0.0001f)
+                t = first + math.frac((t - first) / period) * period;
+            pixels[index] = TextureKernelUtil.ToColor32(Sample(t));
+        }
+
+        float4 Sample(float t) {
+            var count = stopPositions.Length;
+            if (t <= stopPositions[0])
+                return stopColors[0];
+            for (int i = 0; i + 1 < count; i++) {
+                var t1 = stopPositions[i + 1];
+                if (t < t1) {
+                    var t0 = stopPositions[i];
+                    return math.lerp(stopColors[i], stopColors[i + 1], (t - t0) / (t1 - t0));
+                }
+            }
+            return stopColors[count - 1];
+        }
+    }
+}
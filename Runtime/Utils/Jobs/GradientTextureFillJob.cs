@@ -24,7 +24,7 @@ namespace OneJS.Utils {
 
         public void Execute(int index) {
             int x = index % width;
-            int y = index / height;
+            int y = index / width;
             float fx = (float)x / (float)width;
             float fy = (float)y / (float)height;
 
@@ -0,0 +1,44 @@
+﻿using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Fills pixels with fractal (fBm) simplex noise, mapped from lowColor to highColor.
+    /// </summary>
+    [BurstCompile]
+    public struct NoiseFillJob : IJobParallelFor {
+        [WriteOnly] public NativeArray<Color32> pixels;
+        public int width;
+        public int height;
+        /// <summary>
+        /// Size of the first octave's features, in pixels
+        /// </summary>
+        public float scale;
+        public int octaves;
+        /// <summary>
+        /// Amplitude falloff per octave
+        /// </summary>
+        public float persistence;
+        public float2 offset;
+        public float4 lowColor;
+        public float4 highColor;
+
+        public void Execute(int index) {
+            var p = TextureKernelUtil.PixelPosition(index, width, height) / math.max(scale, 0.0001f) + offset;
+            var value = 0f;
+            var amplitude = 1f;
+            var total = 0f;
+            for (int i = 0; i < math.max(octaves, 1); i++) {
+                value += noise.snoise(p) * amplitude;
+                total += amplitude;
+                amplitude *= persistence;
+                p *= 2;
+            }
+            var v = math.saturate(value / total * 0.5f + 0.5f);
+            pixels[index] = TextureKernelUtil.ToColor32(math.lerp(lowColor, highColor, v));
+        }
+    }
+}
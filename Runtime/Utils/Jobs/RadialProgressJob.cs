@@ -0,0 +1,59 @@
+﻿using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Draws an anti-aliased progress ring: the arc from startAngle (degrees clockwise from the top) covering
+    /// `progress` of the circle in fillColor, the rest of the ring in trackColor.
+    /// </summary>
+    [BurstCompile]
+    public struct RadialProgressJob : IJobParallelFor {
+        [WriteOnly] public NativeArray<Color32> pixels;
+        public int width;
+        public int height;
+        /// <summary>
+        /// 0 to 1
+        /// </summary>
+        public float progress;
+        public float thickness;
+        public float startAngle;
+        /// <summary>
+        /// Width of the anti-aliased edges, in pixels
+        /// </summary>
+        public float softness;
+        public float4 fillColor;
+        public float4 trackColor;
+
+        public void Execute(int index) {
+            var p = TextureKernelUtil.PixelPosition(index, width, height) - new float2(width, height) * 0.5f;
+            var outer = math.min(width, height) * 0.5f;
+            var inner = math.max(outer - thickness, 0);
+            var r = math.length(p);
+            var soft = math.max(softness, 0.0001f);
+            var ring = math.saturate(0.5f - math.max(r - outer, inner - r) / soft);
+
+            // Fraction of the way around, clockwise from startAngle (y points down, so up is -y)
+            var turn = math.atan2(p.x, -p.y) / (2 * math.PI) - startAngle / 360f;
+            var fraction = math.frac(turn + 2);
+            float arc;
+            if (progress >= 1) {
+                arc = 1;
+            } else if (progress <= 0) {
+                arc = 0;
+            } else {
+                // Signed distance (in pixels, along the circle) to the arc's ends
+                var circumference = 2 * math.PI * math.max(r, 0.0001f);
+                var distance = fraction <= progress
+                    ? -math.min(fraction, progress - fraction)
+                    : math.min(fraction - progress, 1 - fraction);
+                arc = math.saturate(0.5f - distance * circumference / soft);
+            }
+            var color = math.lerp(trackColor, fillColor, arc);
+            color.w *= ring;
+            pixels[index] = TextureKernelUtil.ToColor32(color);
+        }
+    }
+}
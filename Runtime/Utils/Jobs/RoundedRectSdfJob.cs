@@ -0,0 +1,47 @@
+﻿using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Draws an anti-aliased rounded rect (with an optional inner border) from its signed distance field. Pixels
+    /// outside of it are transparent.
+    /// </summary>
+    [BurstCompile]
+    public struct RoundedRectSdfJob : IJobParallelFor {
+        [WriteOnly] public NativeArray<Color32> pixels;
+        public int width;
+        public int height;
+        /// <summary>
+        /// Distance from the texture's edges to the rect
+        /// </summary>
+        public float inset;
+        public float radius;
+        public float borderWidth;
+        /// <summary>
+        /// Width of the anti-aliased edge, in pixels
+        /// </summary>
+        public float softness;
+        public float4 fillColor;
+        public float4 borderColor;
+
+        public void Execute(int index) {
+            var p = TextureKernelUtil.PixelPosition(index, width, height);
+            var halfSize = new float2(width, height) * 0.5f - inset;
+            var r = math.min(radius, math.cmin(halfSize));
+            var q = math.abs(p - new float2(width, height) * 0.5f) - halfSize + r;
+            var d = math.length(math.max(q, 0)) + math.min(math.cmax(q), 0) - r;
+
+            var soft = math.max(softness, 0.0001f);
+            var color = fillColor;
+            if (borderWidth > 0) {
+                var inner = math.saturate(0.5f - (d + borderWidth) / soft);
+                color = math.lerp(borderColor, fillColor, inner);
+            }
+            color.w *= math.saturate(0.5f - d / soft);
+            pixels[index] = TextureKernelUtil.ToColor32(color);
+        }
+    }
+}
@@ -0,0 +1,254 @@
+﻿using System;
+using System.Collections;
+using System.Collections.Generic;
+using System.Threading.Tasks;
+using OneJS.Dom;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Schedules the procedural texture jobs (gradients, rounded rects, noise, progress rings) on worker threads.
+    /// Every method returns right away with a Task that completes on the main thread once the pixels are written,
+    /// so from JS:
+    ///
+    ///     const tex = TextureKernels.CreateTexture(256, 256)
+    ///     await puer.$promise(TextureKernels.RoundedRect(tex.GetRawDataColor32(), 256, 256, 24, fill))
+    ///     tex.Apply()
+    ///
+    /// The pixel array has to stay alive (i.e. its texture not destroyed) until then. Rows go bottom to top, as in
+    /// Texture2D; shapes are laid out top-down like CSS. Engines call CancelAll() before disposing their JsEnv.
+    /// </summary>
+    public static class TextureKernels {
+        const int BatchSize = 64;
+
+        static readonly List<Pending> _pending = new List<Pending>();
+        static Coroutine _coroutine;
+
+        public static int PendingCount => _pending.Count;
+
+        [RuntimeInitializeOnLoadMethod(RuntimeInitializeLoadType.SubsystemRegistration)]
+        static void Init() {
+            _pending.Clear();
+            _coroutine = null;
+        }
+
+        /// <summary>
+        /// An RGBA32 texture without mipmaps, ready to be filled through GetRawDataColor32().
+        /// </summary>
+        public static Texture2D CreateTexture(int width, int height, FilterMode filterMode = FilterMode.Bilinear) {
+            return new Texture2D(width, height, TextureFormat.RGBA32, false) {
+                filterMode = filterMode,
+                wrapMode = TextureWrapMode.Clamp
+            };
+        }
+
+        /// <summary>
+        /// Fills the pixels with a CSS linear-gradient() or radial-gradient() (see CssGradient), any number of stops.
+        /// </summary>
+        public static Task<bool> Gradient(NativeArray<Color32> pixels, int width, int height, string css) {
+            if (!Validate(pixels, width, height, out var error))
+                return error;
+            if (!CssGradient.TryParse(css, out var gradient))
+                return Task.FromException<bool>(new ArgumentException($"Invalid gradient: {css}"));
+
+            var rect = new Rect(0, 0, width, height);
+            var job = new CssGradientFillJob {
+                pixels = pixels,
+                width = width,
+                height = height,
+                radial = gradient.kind == CssGradient.Kind.Radial,
+                repeating = gradient.repeating
+            };
+            float length;
+            if (job.radial) {
+                var center = gradient.ResolveCenter(rect);
+                var radii = gradient.ResolveRadii(rect, center);
+                job.center = new float2(center.x, center.y);
+                job.radii = math.max(new float2(radii.x, radii.y), 0.001f);
+                length = job.radii.x;
+            } else {
+                var radians = math.radians(gradient.ResolveAngle(rect));
+                job.center = new float2(width, height) * 0.5f;
+                job.direction = new float2(math.sin(radians), -math.cos(radians));
+                job.length = math.max(math.abs(width * job.direction.x) + math.abs(height * job.direction.y), 0.001f);
+                length = job.length;
+            }
+            var stops = new List<(float t, Color color)>();
+            gradient.ResolveStops(length, stops);
+            job.stopPositions = new NativeArray<float>(stops.Count, Allocator.Persistent);
+            job.stopColors = new NativeArray<float4>(stops.Count, Allocator.Persistent);
+            for (int i = 0; i < stops.Count; i++) {
+                job.stopPositions[i] = stops[i].t;
+                job.stopColors[i] = ToFloat4(stops[i].color);
+            }
+            return Track(job.Schedule(pixels.Length, BatchSize), job.stopPositions, job.stopColors);
+        }
+
+        /// <summary>
+        /// An anti-aliased rounded rect, inset from the texture's edges, with an optional inner border.
+        /// </summary>
+        public static Task<bool> RoundedRect(NativeArray<Color32> pixels, int width, int height, float radius, Color fill,
+            float borderWidth = 0, Color borderColor = default, float inset = 0, float softness = 1) {
+            if (!Validate(pixels, width, height, out var error))
+                return error;
+            var job = new RoundedRectSdfJob {
+                pixels = pixels,
+                width = width,
+                height = height,
+                inset = inset,
+                radius = radius,
+                borderWidth = borderWidth,
+                softness = softness,
+                fillColor = ToFloat4(fill),
+                borderColor = ToFloat4(borderColor)
+            };
+            return Track(job.Schedule(pixels.Length, BatchSize));
+        }
+
+        /// <summary>
+        /// Fractal simplex noise from low to high. Different seeds give different patterns.
+        /// </summary>
+        /// <param name="scale">Size of the coarsest features, in pixels</param>
+        public static Task<bool> Noise(NativeArray<Color32> pixels, int width, int height, Color low, Color high,
+            float scale = 32, int octaves = 4, float persistence = 0.5f, float seed = 0) {
+            if (!Validate(pixels, width, height, out var error))
+                return error;
+            var job = new NoiseFillJob {
+                pixels = pixels,
+                width = width,
+                height = height,
+                scale = scale,
+                octaves = math.clamp(octaves, 1, 12),
+                persistence = persistence,
+                offset = new float2(seed * 17.13f, seed * 31.71f),
+                lowColor = ToFloat4(low),
+                highColor = ToFloat4(high)
+            };
+            return Track(job.Schedule(pixels.Length, BatchSize));
+        }
+
+        /// <summary>
+        /// A progress ring as big as fits in the texture.
+        /// </summary>
+        /// <param name="progress">0 to 1</param>
+        /// <param name="startAngle">Degrees clockwise from the top</param>
+        public static Task<bool> RadialProgress(NativeArray<Color32> pixels, int width, int height, float progress,
+            float thickness, Color fill, Color track, float startAngle = 0, float softness = 1) {
+            if (!Validate(pixels, width, height, out var error))
+                return error;
+            var job = new RadialProgressJob {
+                pixels = pixels,
+                width = width,
+                height = height,
+                progress = progress,
+                thickness = thickness,
+                startAngle = startAngle,
+                softness = softness,
+                fillColor = ToFloat4(fill),
+                trackColor = ToFloat4(track)
+            };
+            return Track(job.Schedule(pixels.Length, BatchSize));
+        }
+
+        /// <summary>
+        /// Waits for every scheduled job and completes their Tasks.
+        /// </summary>
+        public static void CompleteAll() {
+            foreach (var pending in _pending.ToArray())
+                Finish(pending);
+            _pending.Clear();
+        }
+
+        /// <summary>
+        /// Waits for every scheduled job and frees its buffers, but drops its Task instead of completing it: the
+        /// continuations would run (on a later frame) in a JsEnv that's gone by then. Kernels are shared, so this
+        /// drops the Tasks of every engine, not just the one being disposed.
+        /// </summary>
+        public static void CancelAll() {
+            foreach (var pending in _pending)
+                Complete(pending);
+            _pending.Clear();
+        }
+
+        static bool Validate(NativeArray<Color32> pixels, int width, int height, out Task<bool> error) {
+            error = null;
+            if (!pixels.IsCreated)
+                error = Task.FromException<bool>(new ArgumentException("The pixel array isn't allocated"));
+            else if (width <= 0 || height <= 0 || pixels.Length != width * height)
+                error = Task.FromException<bool>(
+                    new ArgumentException($"{width}x{height} doesn't match the pixel array's length ({pixels.Length})"));
+            return error == null;
+        }
+
+        static Task<bool> Track(JobHandle handle, params IDisposable[] disposables) {
+            var pending = new Pending { handle = handle, disposables = disposables, tcs = new TaskCompletionSource<bool>() };
+            JobHandle.ScheduleBatchedJobs();
+            if (!Application.isPlaying) {
+                // No coroutines outside of play mode
+                Finish(pending);
+                return pending.tcs.Task;
+            }
+            _pending.Add(pending);
+            _coroutine ??= StaticCoroutine.Start(Poll());
+            return pending.tcs.Task;
+        }
+
+        static IEnumerator Poll() {
+            while (_pending.Count > 0) {
+                yield return null;
+                for (int i = _pending.Count - 1; i >= 0; i--) {
+                    var pending = _pending[i];
+                    if (!pending.handle.IsCompleted)
+                        continue;
+                    _pending.RemoveAt(i);
+                    Finish(pending);
+                }
+            }
+            _coroutine = null;
+        }
+
+        static void Finish(Pending pending) {
+            Complete(pending);
+            // Continuations (i.e. the JS promise) run right here, on the main thread
+            pending.tcs.TrySetResult(true);
+        }
+
+        static void Complete(Pending pending) {
+            pending.handle.Complete();
+            foreach (var disposable in pending.disposables)
+                disposable.Dispose();
+        }
+
+        static float4 ToFloat4(Color c) {
+            return new float4(c.r, c.g, c.b, c.a);
+        }
+
+        class Pending {
+            public JobHandle handle;
+            public IDisposable[] disposables;
+            public TaskCompletionSource<bool> tcs;
+        }
+    }
+
+    /// <summary>
+    /// Shared by the texture jobs (Burst-compatible).
+    /// </summary>
+    public static class TextureKernelUtil {
+        /// <summary>
+        /// The pixel's center, with y pointing down (Texture2D rows go bottom to top).
+        /// </summary>
+        public static float2 PixelPosition(int index, int width, int height) {
+            var x = index % width;
+            var y = index / width;
+            return new float2(x + 0.5f, height - y - 0.5f);
+        }
+
+        public static Color32 ToColor32(float4 c) {
+            var b = (int4)math.round(math.saturate(c) * 255);
+            return new Color32((byte)b.x, (byte)b.y, (byte)b.z, (byte)b.w);
+        }
+    }
+}
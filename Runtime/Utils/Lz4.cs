@@ -0,0 +1,178 @@
+﻿using System;
+using System.IO;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Managed implementation of the LZ4 block format (no frame headers). Compression is the greedy single-pass
+    /// variant of the reference implementation; decompression is a plain copy loop, which is what makes LZ4 so much
+    /// cheaper than inflate on low-end CPUs.
+    /// </summary>
+    public static class Lz4 {
+        const int MinMatch = 4;
+        const int LastLiterals = 5; // The last 5 bytes are always literals
+        const int MFLimit = 12; // The last match must start at least 12 bytes before the end
+        const int MaxDistance = 65535;
+        const int HashLog = 16;
+        const int SkipTrigger = 6; // Speeds up incompressible data by skipping ahead faster
+
+        public static int MaxCompressedLength(int length) {
+            return length + length / 255 + 16;
+        }
+
+        public static byte[] Compress(byte[] src) {
+            var dst = new byte[MaxCompressedLength(src.Length)];
+            var length = Compress(src, 0, src.Length, dst, 0);
+            Array.Resize(ref dst, length);
+            return dst;
+        }
+
+        /// <summary>
+        /// Compresses into dst, which needs at least MaxCompressedLength(srcLength) bytes from dstOffset.
+        /// Returns the compressed length.
+        /// </summary>
+        public static int Compress(byte[] src, int srcOffset, int srcLength, byte[] dst, int dstOffset) {
+            var end = srcOffset + srcLength;
+            var anchor = srcOffset;
+            var op = dstOffset;
+
+            if (srcLength >= MFLimit + 1) {
+                var table = new int[1 << HashLog];
+                for (int i = 0; i < table.Length; i++)
+                    table[i] = srcOffset;
+                var matchLimit = end - LastLiterals;
+                var mfLimit = end - MFLimit;
+                var ip = srcOffset;
+                var searchCount = 1 << SkipTrigger;
+
+                while (ip <= mfLimit) {
+                    var h = Hash(src, ip);
+                    var candidate = table[h];
+                    table[h] = ip;
+                    if (candidate >= ip || ip - candidate > MaxDistance || ReadUInt32(src, candidate) != ReadUInt32(src, ip)) {
+                        ip += searchCount++ >> SkipTrigger;
+                        continue;
+                    }
+                    searchCount = 1 << SkipTrigger;
+
+                    while (ip > anchor && candidate > srcOffset && src[ip - 1] == src[candidate - 1]) {
+                        ip--;
+                        candidate--;
+                    }
+                    var matchLength = MinMatch;
+                    while (ip + matchLength < matchLimit && src[ip + matchLength] == src[candidate + matchLength])
+                        matchLength++;
+
+                    op = WriteSequence(dst, op, src, anchor, ip - anchor, ip - candidate, matchLength);
+                    ip += matchLength;
+                    anchor = ip;
+                    if (ip <= mfLimit)
+                        table[Hash(src, ip - 2)] = ip - 2;
+                }
+            }
+
+            // Last literals
+            var literalLength = end - anchor;
+            var tokenPos = op++;
+            dst[tokenPos] = (byte)((literalLength >= 15 ? 15 : literalLength) << 4);
+            if (literalLength >= 15)
+                op = WriteLength(dst, op, literalLength - 15);
+            Buffer.BlockCopy(src, anchor, dst, op, literalLength);
+            op += literalLength;
+            return op - dstOffset;
+        }
+
+        /// <summary>
+        /// Decompresses a block whose decompressed length is known up front (LZ4 blocks don't store it).
+        /// Throws InvalidDataException on malformed input.
+        /// </summary>
+        public static void Decompress(byte[] src, int srcOffset, int srcLength, byte[] dst, int dstOffset, int dstLength) {
+            var ip = srcOffset;
+            var srcEnd = srcOffset + srcLength;
+            var op = dstOffset;
+            var dstEnd = dstOffset + dstLength;
+
+            while (ip < srcEnd) {
+                var token = src[ip++];
+
+                var literalLength = token >> 4;
+                if (literalLength == 15)
+                    literalLength += ReadLength(src, ref ip, srcEnd);
+                if (ip + literalLength > srcEnd || op + literalLength > dstEnd)
+                    throw new InvalidDataException("LZ4: literals out of bounds");
+                Buffer.BlockCopy(src, ip, dst, op, literalLength);
+                ip += literalLength;
+                op += literalLength;
+                if (ip == srcEnd)
+                    break; // The last sequence only has literals
+
+                if (ip + 2 > srcEnd)
+                    throw new InvalidDataException("LZ4: truncated offset");
+                var offset = src[ip] | (src[ip + 1] << 8);
+                ip += 2;
+                var match = op - offset;
+                if (offset == 0 || match < dstOffset)
+                    throw new InvalidDataException("LZ4: invalid match offset");
+
+                var matchLength = token & 15;
+                if (matchLength == 15)
+                    matchLength += ReadLength(src, ref ip, srcEnd);
+                matchLength += MinMatch;
+                if (op + matchLength > dstEnd)
+                    throw new InvalidDataException("LZ4: match out of bounds");
+
+                if (offset >= matchLength) {
+                    Buffer.BlockCopy(dst, match, dst, op, matchLength);
+                    op += matchLength;
+                } else {
+                    // Overlapping copy (i.e. runs), has to go byte by byte
+                    for (int i = 0; i < matchLength; i++)
+                        dst[op++] = dst[match++];
+                }
+            }
+            if (op != dstEnd)
+                throw new InvalidDataException("LZ4: decompressed length mismatch");
+        }
+
+        static int WriteSequence(byte[] dst, int op, byte[] src, int literalStart, int literalLength, int offset, int matchLength) {
+            var ml = matchLength - MinMatch;
+            dst[op++] = (byte)(((literalLength >= 15 ? 15 : literalLength) << 4) | (ml >= 15 ? 15 : ml));
+            if (literalLength >= 15)
+                op = WriteLength(dst, op, literalLength - 15);
+            Buffer.BlockCopy(src, literalStart, dst, op, literalLength);
+            op += literalLength;
+            dst[op++] = (byte)offset;
+            dst[op++] = (byte)(offset >> 8);
+            if (ml >= 15)
+                op = WriteLength(dst, op, ml - 15);
+            return op;
+        }
+
+        static int WriteLength(byte[] dst, int op, int length) {
+            while (length >= 255) {
+                dst[op++] = 255;
+                length -= 255;
+            }
+            dst[op++] = (byte)length;
+            return op;
+        }
+
+        static int ReadLength(byte[] src, ref int ip, int srcEnd) {
+            int length = 0, b;
+            do {
+                if (ip >= srcEnd)
+                    throw new InvalidDataException("LZ4: truncated length");
+                b = src[ip++];
+                length += b;
+            } while (b == 255);
+            return length;
+        }
+
+        static int Hash(byte[] src, int pos) {
+            return (int)((ReadUInt32(src, pos) * 2654435761u) >> (32 - HashLog));
+        }
+
+        static uint ReadUInt32(byte[] src, int pos) {
+            return (uint)(src[pos] | (src[pos + 1] << 8) | (src[pos + 2] << 16) | (src[pos + 3] << 24));
+        }
+    }
+}
@@ -0,0 +1,84 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.IO;
+using System.Security.Cryptography;
+using System.Text;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// On-disk cache of minified JS, keyed by a hash of the source and the minifier options (including the
+    /// minifier version). Safe to use from multiple threads; entries are written to a temp file and moved into
+    /// place, so a half-written entry is never read.
+    /// </summary>
+    public class MinifyCache {
+        public string Dir => _dir;
+
+        readonly string _dir;
+        readonly ConcurrentDictionary<string, byte> _used = new ConcurrentDictionary<string, byte>();
+
+        public MinifyCache(string dir) {
+            _dir = dir;
+            Directory.CreateDirectory(dir);
+        }
+
+        public static string ComputeKey(string source, string options) {
+            using (var sha = SHA256.Create()) {
+                var bytes = sha.ComputeHash(Encoding.UTF8.GetBytes(options + "\n" + source));
+                return BitConverter.ToString(bytes).Replace("-", "").ToLowerInvariant();
+            }
+        }
+
+        public bool TryGet(string key, out byte[] code) {
+            _used[key] = 0;
+            try {
+                code = File.ReadAllBytes(EntryPath(key));
+                return true;
+            } catch (IOException) {
+                code = null;
+                return false;
+            } catch (UnauthorizedAccessException) {
+                code = null;
+                return false;
+            }
+        }
+
+        public void Set(string key, byte[] code) {
+            _used[key] = 0;
+            var path = EntryPath(key);
+            var tmpPath = path + "." + Guid.NewGuid().ToString("N") + ".tmp";
+            try {
+                File.WriteAllBytes(tmpPath, code);
+                File.Move(tmpPath, path);
+            } catch (IOException) {
+                // Another thread (or process) got there first with the same content (or the write failed)
+                TryDelete(tmpPath);
+            } catch (UnauthorizedAccessException) {
+                TryDelete(tmpPath);
+            }
+        }
+
+        /// <summary>
+        /// Deletes every entry that wasn't looked up or added through this instance, so the cache only ever holds
+        /// what the last package run needed.
+        /// </summary>
+        public void PruneUnused() {
+            foreach (var file in Directory.GetFiles(_dir)) {
+                var key = Path.GetFileNameWithoutExtension(file);
+                if (!_used.ContainsKey(key) || file.EndsWith(".tmp"))
+                    TryDelete(file);
+            }
+        }
+
+        static void TryDelete(string path) {
+            try {
+                File.Delete(path);
+            } catch (IOException) {
+            } catch (UnauthorizedAccessException) {
+            }
+        }
+
+        string EntryPath(string key) {
+            return Path.Combine(_dir, key + ".js");
+        }
+    }
+}
@@ -0,0 +1,274 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading.Tasks;
+using ICSharpCode.SharpZipLib.Zip.Compression;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// A write-only gzip stream that compresses fixed-size blocks in parallel, in the style of pigz.
+    ///
+    /// Every block is deflated independently (primed with the last 32K of the previous block as dictionary),
+    /// sync-flushed to a byte boundary, and the pieces are written out in order. Per-block CRCs are combined, so the
+    /// result is a single, regular gzip member that any gzip reader (including GZipInputStream) can inflate.
+    /// </summary>
+    public class ParallelGZipOutputStream : Stream {
+        const int DictionarySize = 32 * 1024;
+        /// <summary>
+        /// Largest stored (uncompressed) deflate block
+        /// </summary>
+        const int MaxStoredBlock = 65535;
+
+        public bool IsStreamOwner { get; set; } = true;
+
+        readonly Stream _baseStream;
+        readonly int _level;
+        readonly int _blockSize;
+        readonly int _maxInFlight;
+        readonly Queue<Task<CompressedBlock>> _inFlight = new Queue<Task<CompressedBlock>>();
+
+        byte[] _block;
+        int _blockLength;
+        byte[] _prevBlock;
+        uint _crc;
+        long _totalIn;
+        bool _headerWritten;
+        bool _finished;
+
+        /// <param name="baseStream">Where the gzip stream is written to</param>
+        /// <param name="level">Deflate level, 0-9. 0 writes stored (uncompressed) blocks.</param>
+        /// <param name="blockSize">Uncompressed bytes per block. pigz uses 128K.</param>
+        /// <param name="threads">Max blocks compressing at once. Defaults to the number of cores.</param>
+        public ParallelGZipOutputStream(Stream baseStream, int level = 6, int blockSize = 128 * 1024, int threads = 0) {
+            if (blockSize < DictionarySize)
+                throw new ArgumentOutOfRangeException(nameof(blockSize), "Block size must be at least 32K.");
+            if (level < 0 || level > 9)
+                throw new ArgumentOutOfRangeException(nameof(level), "Level must be 0-9.");
+            _baseStream = baseStream;
+            _level = level;
+            _blockSize = blockSize;
+            _maxInFlight = (threads > 0 ? threads : Environment.ProcessorCount) * 2;
+            _block = new byte[blockSize];
+        }
+
+        public override bool CanRead => false;
+        public override bool CanSeek => false;
+        public override bool CanWrite => !_finished;
+        public override long Length => _totalIn;
+        public override long Position { get => _totalIn; set => throw new NotSupportedException(); }
+
+        public override void Write(byte[] buffer, int offset, int count) {
+            if (_finished)
+                throw new ObjectDisposedException(nameof(ParallelGZipOutputStream));
+            while (count > 0) {
+                var n = Math.Min(count, _blockSize - _blockLength);
+                Buffer.BlockCopy(buffer, offset, _block, _blockLength, n);
+                _blockLength += n;
+                offset += n;
+                count -= n;
+                if (_blockLength == _blockSize)
+                    SubmitBlock(false);
+            }
+        }
+
+        /// <summary>
+        /// Compresses what's buffered, writes everything out along with the gzip trailer.
+        /// </summary>
+        public void Finish() {
+            if (_finished)
+                return;
+            SubmitBlock(true);
+            while (_inFlight.Count > 0)
+                WriteBlock(_inFlight.Dequeue().Result);
+            WriteTrailer();
+            _baseStream.Flush();
+            _finished = true;
+        }
+
+        public override void Flush() {
+            _baseStream.Flush();
+        }
+
+        protected override void Dispose(bool disposing) {
+            try {
+                if (disposing) {
+                    Finish();
+                    if (IsStreamOwner)
+                        _baseStream.Dispose();
+                }
+            } finally {
+                base.Dispose(disposing);
+            }
+        }
+
+        public override int Read(byte[] buffer, int offset, int count) => throw new NotSupportedException();
+        public override long Seek(long offset, SeekOrigin origin) => throw new NotSupportedException();
+        public override void SetLength(long value) => throw new NotSupportedException();
+
+        void SubmitBlock(bool last) {
+            var input = _block;
+            var length = _blockLength;
+            var dictionary = _prevBlock;
+            var level = _level;
+            _inFlight.Enqueue(Task.Run(() => CompressBlock(input, length, dictionary, level, last)));
+            _totalIn += length;
+            _prevBlock = input;
+            _block = new byte[_blockSize];
+            _blockLength = 0;
+
+            // Write out finished blocks in order, and apply back pressure so we don't buffer the whole input
+            while (_inFlight.Count > 0 && (_inFlight.Peek().IsCompleted || _inFlight.Count >= _maxInFlight))
+                WriteBlock(_inFlight.Dequeue().Result);
+        }
+
+        void WriteBlock(CompressedBlock block) {
+            if (!_headerWritten) {
+                // ID1 ID2 CM FLG MTIME(4) XFL OS(unknown)
+                _baseStream.Write(new byte[] { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff }, 0, 10);
+                _headerWritten = true;
+            }
+            _baseStream.Write(block.data, 0, block.length);
+            _crc = Crc32Combine(_crc, block.crc, block.inputLength);
+        }
+
+        void WriteTrailer() {
+            var trailer = new byte[8];
+            WriteUInt32LE(trailer, 0, _crc);
+            WriteUInt32LE(trailer, 4, (uint)_totalIn);
+            _baseStream.Write(trailer, 0, trailer.Length);
+        }
+
+        static CompressedBlock CompressBlock(byte[] input, int length, byte[] dictionary, int level, bool last) {
+            if (level == 0)
+                return StoreBlock(input, length, last);
+            // Drive the deflate engine directly: Deflater.Flush() only does a partial flush that leaves bits
+            // pending, while concatenating blocks needs a byte-aligned sync flush like zlib's Z_SYNC_FLUSH.
+            var pending = new DeflaterPending();
+            var engine = new DeflaterEngine(pending, true);
+            engine.SetLevel(level);
+            if (dictionary != null)
+                engine.SetDictionary(dictionary, dictionary.Length - DictionarySize, DictionarySize);
+            engine.SetInput(input, 0, length);
+
+            var output = new MemoryStream(length / 2 + 64);
+            var buf = new byte[64 * 1024];
+            bool progress;
+            do {
+                progress = engine.Deflate(true, last);
+                Drain(pending, output, buf);
+            } while (progress || !pending.IsFlushed);
+
+            if (last) {
+                pending.AlignToByte();
+            } else {
+                // Empty, non-final stored block: aligns to a byte boundary and keeps the deflate stream open
+                pending.WriteBits(0, 3);
+                pending.AlignToByte();
+                pending.WriteShort(0x0000);
+                pending.WriteShort(0xffff);
+            }
+            Drain(pending, output, buf);
+
+            var crc = new ICSharpCode.SharpZipLib.Checksum.Crc32();
+            crc.Update(new ArraySegment<byte>(input, 0, length));
+            return new CompressedBlock {
+                data = output.GetBuffer(), length = (int)output.Length, crc = (uint)crc.Value, inputLength = length
+            };
+        }
+
+        /// <summary>
+        /// Level 0: the input as stored deflate blocks (the engine's own stored mode doesn't survive the sync flush
+        /// above). Blocks start byte-aligned, so there's nothing to flush in between.
+        /// </summary>
+        static CompressedBlock StoreBlock(byte[] input, int length, bool last) {
+            var count = Math.Max(1, (length + MaxStoredBlock - 1) / MaxStoredBlock);
+            var data = new byte[length + count * 5];
+            var offset = 0;
+            for (int i = 0; i < count; i++) {
+                var start = i * MaxStoredBlock;
+                var n = Math.Min(MaxStoredBlock, length - start);
+                // BFINAL, BTYPE 00 (stored), padded to the byte; then LEN and NLEN
+                data[offset] = (byte)(last && i == count - 1 ? 1 : 0);
+                data[offset + 1] = (byte)n;
+                data[offset + 2] = (byte)(n >> 8);
+                data[offset + 3] = (byte)~n;
+                data[offset + 4] = (byte)(~n >> 8);
+                Buffer.BlockCopy(input, start, data, offset + 5, n);
+                offset += n + 5;
+            }
+            var crc = new ICSharpCode.SharpZipLib.Checksum.Crc32();
+            crc.Update(new ArraySegment<byte>(input, 0, length));
+            return new CompressedBlock { data = data, length = offset, crc = (uint)crc.Value, inputLength = length };
+        }
+
+        static void Drain(DeflaterPending pending, Stream output, byte[] buf) {
+            while (!pending.IsFlushed) {
+                var n = pending.Flush(buf, 0, buf.Length);
+                if (n == 0)
+                    break; // Only sub-byte bits left
+                output.Write(buf, 0, n);
+            }
+        }
+
+        static void WriteUInt32LE(byte[] buf, int offset, uint v) {
+            buf[offset] = (byte)v;
+            buf[offset + 1] = (byte)(v >> 8);
+            buf[offset + 2] = (byte)(v >> 16);
+            buf[offset + 3] = (byte)(v >> 24);
+        }
+
+        #region CRC-32 Combine
+        // Port of zlib's crc32_combine(). Returns the CRC of A+B given the CRCs of A and B and the length of B.
+        static uint Crc32Combine(uint crc1, uint crc2, long len2) {
+            if (len2 <= 0)
+                return crc1;
+            var even = new uint[32];
+            var odd = new uint[32];
+
+            odd[0] = 0xedb88320; // CRC-32 polynomial
+            uint row = 1;
+            for (int n = 1; n < 32; n++) {
+                odd[n] = row;
+                row <<= 1;
+            }
+            Gf2MatrixSquare(even, odd); // Operator for two zero bits
+            Gf2MatrixSquare(odd, even); // Operator for four zero bits
+
+            do {
+                Gf2MatrixSquare(even, odd);
+                if ((len2 & 1) != 0)
+                    crc1 = Gf2MatrixTimes(even, crc1);
+                len2 >>= 1;
+                if (len2 == 0)
+                    break;
+                Gf2MatrixSquare(odd, even);
+                if ((len2 & 1) != 0)
+                    crc1 = Gf2MatrixTimes(odd, crc1);
+                len2 >>= 1;
+            } while (len2 != 0);
+            return crc1 ^ crc2;
+        }
+
+        static uint Gf2MatrixTimes(uint[] mat, uint vec) {
+            uint sum = 0;
+            for (int i = 0; vec != 0; i++, vec >>= 1) {
+                if ((vec & 1) != 0)
+                    sum ^= mat[i];
+            }
+            return sum;
+        }
+
+        static void Gf2MatrixSquare(uint[] square, uint[] mat) {
+            for (int n = 0; n < 32; n++)
+                square[n] = Gf2MatrixTimes(mat, mat[n]);
+        }
+        #endregion
+
+        struct CompressedBlock {
+            public byte[] data;
+            public int length;
+            public uint crc;
+            public int inputLength;
+        }
+    }
+}
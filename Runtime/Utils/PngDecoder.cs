@@ -0,0 +1,386 @@
+﻿using System;
+using System.IO;
+using ICSharpCode.SharpZipLib;
+using ICSharpCode.SharpZipLib.Zip.Compression.Streams;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// Managed PNG decoder, so images can be decoded off the main thread (Texture2D.LoadImage is main thread only).
+    /// Handles every standard color type and bit depth, tRNS transparency and Adam7 interlacing. Output is RGBA32
+    /// with the bottom row first, which is what Texture2D.LoadRawTextureData expects.
+    /// Gamma, color profiles and ancillary chunks are ignored (same as LoadImage). Chunk CRCs aren't checked, the
+    /// zlib checksum is.
+    /// </summary>
+    public static class PngDecoder {
+        const int ColorGray = 0;
+        const int ColorRGB = 2;
+        const int ColorPalette = 3;
+        const int ColorGrayAlpha = 4;
+        const int ColorRGBA = 6;
+
+        static readonly byte[] Signature = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+        // Adam7 passes: x start, y start, x step, y step
+        static readonly int[,] Passes = {
+            { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 }
+        };
+
+        public static bool IsPng(byte[] bytes) {
+            if (bytes == null || bytes.Length < Signature.Length)
+                return false;
+            for (int i = 0; i < Signature.Length; i++) {
+                if (bytes[i] != Signature[i])
+                    return false;
+            }
+            return true;
+        }
+
+        /// <summary>
+        /// Decodes a PNG to RGBA32 pixels, bottom row first. Throws InvalidDataException if the data is malformed.
+        /// </summary>
+        public static byte[] Decode(byte[] bytes, out int width, out int height) {
+            if (!IsPng(bytes))
+                throw new InvalidDataException("Not a PNG");
+
+            var header = default(Header);
+            byte[] palette = null;
+            byte[] transparency = null;
+            var idat = new MemoryStream();
+            var pos = Signature.Length;
+            while (pos + 8 <= bytes.Length) {
+                var length = ReadInt32(bytes, pos);
+                var type = ReadInt32(bytes, pos + 4);
+                var data = pos + 8;
+                if (length < 0 || data + length > bytes.Length)
+                    throw new InvalidDataException("Truncated PNG chunk");
+                pos = data + length + 4; // + CRC
+
+                if (type == 0x49484452) { // IHDR
+                    header = new Header(bytes, data);
+                } else if (type == 0x504C5445) { // PLTE
+                    palette = new byte[length];
+                    Buffer.BlockCopy(bytes, data, palette, 0, length);
+                } else if (type == 0x74524E53) { // tRNS
+                    transparency = new byte[length];
+                    Buffer.BlockCopy(bytes, data, transparency, 0, length);
+                } else if (type == 0x49444154) { // IDAT
+                    idat.Write(bytes, data, length);
+                } else if (type == 0x49454E44) { // IEND
+                    break;
+                }
+            }
+            if (header.width <= 0 || header.height <= 0)
+                throw new InvalidDataException("Missing or invalid IHDR");
+            if (header.colorType == ColorPalette && palette == null)
+                throw new InvalidDataException("Missing PLTE");
+
+            width = header.width;
+            height = header.height;
+            var raw = Inflate(idat, RawSize(header));
+            var pixels = new byte[(long)width * height * 4];
+            var converter = new RowConverter(header, palette, transparency);
+            if (header.interlaced) {
+                var offset = 0;
+                for (int p = 0; p < 7; p++) {
+                    var passWidth = (width - Passes[p, 0] + Passes[p, 2] - 1) / Passes[p, 2];
+                    var passHeight = (height - Passes[p, 1] + Passes[p, 3] - 1) / Passes[p, 3];
+                    if (passWidth <= 0 || passHeight <= 0)
+                        continue;
+                    offset = DecodePass(raw, offset, passWidth, passHeight, header, converter, pixels,
+                        Passes[p, 0], Passes[p, 1], Passes[p, 2], Passes[p, 3]);
+                }
+            } else {
+                DecodePass(raw, 0, width, height, header, converter, pixels, 0, 0, 1, 1);
+            }
+            return pixels;
+        }
+
+        /// <summary>
+        /// Unfilters the scanlines of one pass (or the whole image) and writes them out as RGBA. Returns the offset
+        /// of the next pass in the raw data.
+        /// </summary>
+        static int DecodePass(byte[] raw, int offset, int passWidth, int passHeight, Header header, RowConverter converter,
+            byte[] pixels, int x0, int y0, int dx, int dy) {
+            var stride = RowBytes(header, passWidth);
+            var bpp = Math.Max(1, header.BitsPerPixel / 8);
+            var prev = new byte[stride];
+            var row = new byte[stride];
+            for (int y = 0; y < passHeight; y++) {
+                if (offset + 1 + stride > raw.Length)
+                    throw new InvalidDataException("Truncated PNG image data");
+                var filter = raw[offset];
+                Buffer.BlockCopy(raw, offset + 1, row, 0, stride);
+                offset += 1 + stride;
+                Unfilter(filter, row, prev, bpp);
+                var outY = header.height - 1 - (y0 + y * dy);
+                converter.Convert(row, passWidth, pixels, outY * header.width, x0, dx);
+                var tmp = prev;
+                prev = row;
+                row = tmp;
+            }
+            return offset;
+        }
+
+        static void Unfilter(byte filter, byte[] row, byte[] prev, int bpp) {
+            var n = row.Length;
+            switch (filter) {
+                case 0:
+                    break;
+                case 1: // Sub
+                    for (int i = bpp; i < n; i++)
+                        row[i] += row[i - bpp];
+                    break;
+                case 2: // Up
+                    for (int i = 0; i < n; i++)
+                        row[i] += prev[i];
+                    break;
+                case 3: // Average
+                    for (int i = 0; i < bpp; i++)
+                        row[i] += (byte)(prev[i] >> 1);
+                    for (int i = bpp; i < n; i++)
+                        row[i] += (byte)((row[i - bpp] + prev[i]) >> 1);
+                    break;
+                case 4: // Paeth
+                    for (int i = 0; i < bpp; i++)
+                        row[i] += prev[i];
+                    for (int i = bpp; i < n; i++)
+                        row[i] += Paeth(row[i - bpp], prev[i], prev[i - bpp]);
+                    break;
+                default:
+                    throw new InvalidDataException($"Unknown PNG filter type {filter}");
+            }
+        }
+
+        static byte Paeth(byte a, byte b, byte c) {
+            int p = a + b - c;
+            int pa = Math.Abs(p - a);
+            int pb = Math.Abs(p - b);
+            int pc = Math.Abs(p - c);
+            if (pa <= pb && pa <= pc)
+                return a;
+            return pb <= pc ? b : c;
+        }
+
+        static byte[] Inflate(MemoryStream idat, long size) {
+            if (idat.Length < 2)
+                throw new InvalidDataException("Missing PNG image data");
+            var raw = new byte[size];
+            idat.Position = 0;
+            // Checks the zlib header, and the adler32 trailer once the stream is read to the end
+            try {
+                using (var inflater = new InflaterInputStream(idat)) {
+                    var read = 0;
+                    while (read < raw.Length) {
+                        var n = inflater.Read(raw, read, raw.Length - read);
+                        if (n <= 0)
+                            break;
+                        read += n;
+                    }
+                    if (read < raw.Length)
+                        throw new InvalidDataException("Truncated PNG image data");
+                    // Extra data is ignored (same as libpng), but reading up to the end is what verifies the checksum
+                    var rest = new byte[256];
+                    while (inflater.Read(rest, 0, rest.Length) > 0) { }
+                }
+            } catch (SharpZipBaseException e) {
+                throw new InvalidDataException("Corrupt PNG image data: " + e.Message, e);
+            }
+            return raw;
+        }
+
+        static long RawSize(Header header) {
+            if (!header.interlaced)
+                return (long)header.height * (1 + RowBytes(header, header.width));
+            long size = 0;
+            for (int p = 0; p < 7; p++) {
+                var passWidth = (header.width - Passes[p, 0] + Passes[p, 2] - 1) / Passes[p, 2];
+                var passHeight = (header.height - Passes[p, 1] + Passes[p, 3] - 1) / Passes[p, 3];
+                if (passWidth > 0 && passHeight > 0)
+                    size += (long)passHeight * (1 + RowBytes(header, passWidth));
+            }
+            return size;
+        }
+
+        static int RowBytes(Header header, int width) {
+            return (int)(((long)width * header.BitsPerPixel + 7) / 8);
+        }
+
+        static int ReadInt32(byte[] bytes, int offset) {
+            return (bytes[offset] << 24) | (bytes[offset + 1] << 16) | (bytes[offset + 2] << 8) | bytes[offset + 3];
+        }
+
+        readonly struct Header {
+            public readonly int width;
+            public readonly int height;
+            public readonly int bitDepth;
+            public readonly int colorType;
+            public readonly bool interlaced;
+
+            public Header(byte[] bytes, int offset) {
+                width = ReadInt32(bytes, offset);
+                height = ReadInt32(bytes, offset + 4);
+                bitDepth = bytes[offset + 8];
+                colorType = bytes[offset + 9];
+                interlaced = bytes[offset + 12] == 1;
+                if (Channels(colorType) == 0 || !ValidBitDepth(bitDepth, colorType))
+                    throw new InvalidDataException($"Unsupported PNG format (color type {colorType}, bit depth {bitDepth})");
+            }
+
+            public int BitsPerPixel => bitDepth * Channels(colorType);
+
+            static int Channels(int colorType) {
+                switch (colorType) {
+                    case ColorGray: return 1;
+                    case ColorRGB: return 3;
+                    case ColorPalette: return 1;
+                    case ColorGrayAlpha: return 2;
+                    case ColorRGBA: return 4;
+                    default: return 0;
+                }
+            }
+
+            static bool ValidBitDepth(int bitDepth, int colorType) {
+                switch (colorType) {
+                    case ColorGray: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+                    case ColorPalette: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+                    default: return bitDepth == 8 || bitDepth == 16;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Turns unfiltered scanlines into RGBA32 pixels.
+        /// </summary>
+        class RowConverter {
+            readonly int _bitDepth;
+            readonly int _colorType;
+            readonly byte[] _palette; // RGBA, 256 entries
+            readonly int _keyR = -1, _keyG = -1, _keyB = -1; // tRNS color key for gray / RGB, in sample units
+
+            public RowConverter(Header header, byte[] palette, byte[] transparency) {
+                _bitDepth = header.bitDepth;
+                _colorType = header.colorType;
+                if (_colorType == ColorPalette) {
+                    _palette = new byte[256 * 4];
+                    for (int i = 0; i < 256; i++) {
+                        if (i * 3 + 2 < palette.Length) {
+                            _palette[i * 4] = palette[i * 3];
+                            _palette[i * 4 + 1] = palette[i * 3 + 1];
+                            _palette[i * 4 + 2] = palette[i * 3 + 2];
+                        }
+                        _palette[i * 4 + 3] = transparency != null && i < transparency.Length ? transparency[i] : (byte)255;
+                    }
+                } else if (transparency != null) {
+                    if (_colorType == ColorGray && transparency.Length >= 2) {
+                        _keyR = _keyG = _keyB = (transparency[0] << 8) | transparency[1];
+                    } else if (_colorType == ColorRGB && transparency.Length >= 6) {
+                        _keyR = (transparency[0] << 8) | transparency[1];
+                        _keyG = (transparency[2] << 8) | transparency[3];
+                        _keyB = (transparency[4] << 8) | transparency[5];
+                    }
+                }
+            }
+
+            /// <param name="rowStart">Index of the output row's first pixel</param>
+            /// <param name="x0">First output column (Adam7 pass offset)</param>
+            /// <param name="dx">Output column step (Adam7 pass step)</param>
+            public void Convert(byte[] row, int count, byte[] pixels, int rowStart, int x0, int dx) {
+                var o = (rowStart + x0) * 4;
+                var step = dx * 4;
+                if (_bitDepth == 8) {
+                    switch (_colorType) {
+                        case ColorRGBA:
+                            for (int x = 0, i = 0; x < count; x++, i += 4, o += step) {
+                                pixels[o] = row[i];
+                                pixels[o + 1] = row[i + 1];
+                                pixels[o + 2] = row[i + 2];
+                                pixels[o + 3] = row[i + 3];
+                            }
+                            return;
+                        case ColorRGB:
+                            for (int x = 0, i = 0; x < count; x++, i += 3, o += step) {
+                                pixels[o] = row[i];
+                                pixels[o + 1] = row[i + 1];
+                                pixels[o + 2] = row[i + 2];
+                                pixels[o + 3] = row[i] == _keyR && row[i + 1] == _keyG && row[i + 2] == _keyB ? (byte)0 : (byte)255;
+                            }
+                            return;
+                        case ColorPalette:
+                            for (int x = 0; x < count; x++, o += step) {
+                                var p = row[x] * 4;
+                                pixels[o] = _palette[p];
+                                pixels[o + 1] = _palette[p + 1];
+                                pixels[o + 2] = _palette[p + 2];
+                                pixels[o + 3] = _palette[p + 3];
+                            }
+                            return;
+                    }
+                }
+                for (int x = 0; x < count; x++, o += step)
+                    ConvertPixel(row, x, pixels, o);
+            }
+
+            void ConvertPixel(byte[] row, int x, byte[] pixels, int o) {
+                switch (_colorType) {
+                    case ColorGray: {
+                        var v = Sample(row, x);
+                        var g = To8(v);
+                        pixels[o] = pixels[o + 1] = pixels[o + 2] = g;
+                        pixels[o + 3] = v == _keyR ? (byte)0 : (byte)255;
+                        break;
+                    }
+                    case ColorGrayAlpha: {
+                        var g = To8(Sample(row, x * 2));
+                        pixels[o] = pixels[o + 1] = pixels[o + 2] = g;
+                        pixels[o + 3] = To8(Sample(row, x * 2 + 1));
+                        break;
+                    }
+                    case ColorRGB: {
+                        int r = Sample(row, x * 3), g = Sample(row, x * 3 + 1), b = Sample(row, x * 3 + 2);
+                        pixels[o] = To8(r);
+                        pixels[o + 1] = To8(g);
+                        pixels[o + 2] = To8(b);
+                        pixels[o + 3] = r == _keyR && g == _keyG && b == _keyB ? (byte)0 : (byte)255;
+                        break;
+                    }
+                    case ColorRGBA:
+                        for (int c = 0; c < 4; c++)
+                            pixels[o + c] = To8(Sample(row, x * 4 + c));
+                        break;
+                    case ColorPalette: {
+                        var p = Sample(row, x) * 4;
+                        pixels[o] = _palette[p];
+                        pixels[o + 1] = _palette[p + 1];
+                        pixels[o + 2] = _palette[p + 2];
+                        pixels[o + 3] = _palette[p + 3];
+                        break;
+                    }
+                }
+            }
+
+            /// <summary>
+            /// The n-th sample of the row, at the image's bit depth.
+            /// </summary>
+            int Sample(byte[] row, int n) {
+                switch (_bitDepth) {
+                    case 16:
+                        return (row[n * 2] << 8) | row[n * 2 + 1];
+                    case 8:
+                        return row[n];
+                    default:
+                        var bit = n * _bitDepth;
+                        var shift = 8 - _bitDepth - (bit & 7);
+                        return (row[bit >> 3] >> shift) & ((1 << _bitDepth) - 1);
+                }
+            }
+
+            byte To8(int sample) {
+                switch (_bitDepth) {
+                    case 16: return (byte)(sample >> 8);
+                    case 8: return (byte)sample;
+                    default: return (byte)(sample * 255 / ((1 << _bitDepth) - 1));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,810 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Xml;
+using UnityEngine;
+using UnityEngine.UIElements;
+
+namespace OneJS.Utils {
+    /// <summary>
+    /// A parsed SVG: its shapes as absolute paths in viewBox units, with every transform already applied. Colors are
+    /// left as strings (resolved on the main thread by SvgLoader), so parsing doesn't touch the Unity API and can
+    /// run on any thread.
+    /// </summary>
+    public class SvgDocument {
+        public Rect viewBox;
+        /// <summary>
+        /// The width/height attributes in px, or the viewBox's size
+        /// </summary>
+        public Vector2 size;
+        public readonly List<SvgShape> shapes = new List<SvgShape>();
+        /// <summary>
+        /// Whether any shape paints with currentColor (SvgParser.CurrentColor), whose color comes from the element
+        /// showing the image
+        /// </summary>
+        public bool usesCurrentColor;
+    }
+
+    public enum SvgPathOp : byte {
+        MoveTo,
+        LineTo,
+        CubicTo, // p0, p1 control points, p2 end
+        QuadraticTo, // p0 control point, p1 end
+        Close
+    }
+
+    public struct SvgPathCommand {
+        public SvgPathOp op;
+        public Vector2 p0;
+        public Vector2 p1;
+        public Vector2 p2;
+    }
+
+    public class SvgShape {
+        public readonly List<SvgPathCommand> commands = new List<SvgPathCommand>();
+        /// <summary>
+        /// Null for none
+        /// </summary>
+        public string fill;
+        public string stroke;
+        public float fillOpacity = 1;
+        public float strokeOpacity = 1;
+        /// <summary>
+        /// Scaled by the shape's transform
+        /// </summary>
+        public float strokeWidth = 1;
+        public bool evenOdd;
+        public LineCap lineCap = LineCap.Butt;
+        public LineJoin lineJoin = LineJoin.Miter;
+        public float miterLimit = 4;
+    }
+
+    /// <summary>
+    /// Parses the static subset of SVG icons use: svg, g, path (all commands, arcs converted to cubics), rect (with
+    /// rx/ry), circle, ellipse, line, polyline and polygon; fill, stroke and their opacities, stroke-width, fill-rule,
+    /// stroke-linecap/linejoin/miterlimit, opacity and display as attributes or in style="", and transform.
+    /// Group opacity is multiplied into the shapes' colors. currentColor is kept as is, for SvgLoader to resolve
+    /// with the element's color when it tessellates the image. Gradients, patterns, clipping, masks, &lt;use&gt;,
+    /// text and &lt;style&gt; sheets are skipped (url() paints draw nothing).
+    /// </summary>
+    public static class SvgParser {
+        public const string CurrentColor = "currentColor";
+
+        static readonly HashSet<string> SkippedElements = new HashSet<string> {
+            "defs", "symbol", "clipPath", "mask", "pattern", "marker", "linearGradient", "radialGradient", "filter",
+            "style", "script", "title", "desc", "metadata", "text", "foreignObject", "use", "image"
+        };
+
+        public static SvgDocument Parse(byte[] bytes) {
+            using (var stream = new MemoryStream(bytes))
+                return Parse(stream);
+        }
+
+        public static SvgDocument Parse(string xml) {
+            using (var reader = new StringReader(xml))
+                return Parse(XmlReader.Create(reader, Settings()));
+        }
+
+        public static SvgDocument Parse(Stream stream) {
+            return Parse(XmlReader.Create(stream, Settings()));
+        }
+
+        static XmlReaderSettings Settings() {
+            return new XmlReaderSettings {
+                DtdProcessing = DtdProcessing.Ignore,
+                XmlResolver = null,
+                IgnoreComments = true,
+                IgnoreWhitespace = true
+            };
+        }
+
+        static SvgDocument Parse(XmlReader reader) {
+            SvgDocument document = null;
+            var stack = new Stack<Style>();
+            using (reader) {
+                // Skip() already moves to the next node, so the loop mustn't Read() past it
+                var read = true;
+                while (read ? reader.Read() : !reader.EOF) {
+                    read = true;
+                    if (reader.NodeType == XmlNodeType.EndElement) {
+                        if (stack.Count > 0)
+                            stack.Pop();
+                        continue;
+                    }
+                    if (reader.NodeType != XmlNodeType.Element)
+                        continue;
+                    if (document == null) {
+                        if (reader.LocalName != "svg")
+                            throw new FormatException("Not an SVG document");
+                        document = new SvgDocument();
+                        ReadRoot(reader, document);
+                    }
+                    if (SkippedElements.Contains(reader.LocalName)) {
+                        reader.Skip();
+                        read = false;
+                        continue;
+                    }
+                    ProcessElement(reader, stack, document);
+                }
+            }
+            if (document == null)
+                throw new FormatException("Not an SVG document");
+            return document;
+        }
+
+        static void ProcessElement(XmlReader reader, Stack<Style> stack, SvgDocument document) {
+            var name = reader.LocalName;
+            var isEmpty = reader.IsEmptyElement;
+            var style = stack.Count > 0 ? stack.Peek() : Style.Default;
+            style = ReadStyle(reader, style);
+            if (!isEmpty)
+                stack.Push(style);
+            if (style.displayNone || style.invisible)
+                return;
+            var shape = ReadShape(reader, name, style);
+            if (shape != null && shape.commands.Count > 0 && (shape.fill != null || shape.stroke != null)) {
+                document.shapes.Add(shape);
+                if (shape.fill == CurrentColor || shape.stroke == CurrentColor)
+                    document.usesCurrentColor = true;
+            }
+        }
+
+        static void ReadRoot(XmlReader reader, SvgDocument document) {
+            var viewBox = reader.GetAttribute("viewBox");
+            var width = ParseLength(reader.GetAttribute("width"), float.NaN);
+            var height = ParseLength(reader.GetAttribute("height"), float.NaN);
+            var numbers = new List<float>();
+            if (viewBox != null)
+                ParseNumbers(viewBox, numbers);
+            if (numbers.Count == 4 && numbers[2] > 0 && numbers[3] > 0) {
+                document.viewBox = new Rect(numbers[0], numbers[1], numbers[2], numbers[3]);
+            } else {
+                document.viewBox = new Rect(0, 0, float.IsNaN(width) ? 100 : width, float.IsNaN(height) ? 100 : height);
+            }
+            var aspect = document.viewBox.width / document.viewBox.height;
+            if (float.IsNaN(width) && float.IsNaN(height)) {
+                document.size = document.viewBox.size;
+            } else if (float.IsNaN(width)) {
+                document.size = new Vector2(height * aspect, height);
+            } else if (float.IsNaN(height)) {
+                document.size = new Vector2(width, width / aspect);
+            } else {
+                document.size = new Vector2(width, height);
+            }
+        }
+
+        #region Style
+        struct Style {
+            public static Style Default => new Style {
+                fill = "black",
+                fillOpacity = 1,
+                strokeOpacity = 1,
+                strokeWidth = 1,
+                miterLimit = 4,
+                opacity = 1,
+                transform = Matrix.Identity
+            };
+
+            public string fill;
+            public string stroke;
+            public float fillOpacity;
+            public float strokeOpacity;
+            public float strokeWidth;
+            public bool evenOdd;
+            public LineCap lineCap;
+            public LineJoin lineJoin;
+            public float miterLimit;
+            /// <summary>
+            /// Product of the ancestors' opacities
+            /// </summary>
+            public float opacity;
+            /// <summary>
+            /// display: none, which (unlike visibility) descendants can't undo
+            /// </summary>
+            public bool displayNone;
+            public bool invisible;
+            public Matrix transform;
+        }
+
+        static Style ReadStyle(XmlReader reader, Style style) {
+            var transform = reader.GetAttribute("transform");
+            if (transform != null)
+                style.transform = style.transform.Multiply(ParseTransform(transform));
+            if (reader.MoveToFirstAttribute()) {
+                do {
+                    if (reader.LocalName != "style")
+                        ApplyProperty(ref style, reader.LocalName, reader.Value);
+                } while (reader.MoveToNextAttribute());
+                reader.MoveToElement();
+            }
+            // Inline styles win over presentation attributes
+            var inline = reader.GetAttribute("style");
+            if (inline != null) {
+                foreach (var declaration in inline.Split(';')) {
+                    var colon = declaration.IndexOf(':');
+                    if (colon > 0)
+                        ApplyProperty(ref style, declaration.Substring(0, colon).Trim(), declaration.Substring(colon + 1));
+                }
+            }
+            return style;
+        }
+
+        static void ApplyProperty(ref Style style, string name, string value) {
+            value = value.Trim();
+            if (value == "inherit")
+                return;
+            switch (name) {
+                case "fill":
+                    style.fill = Paint(value);
+                    break;
+                case "stroke":
+                    style.stroke = Paint(value);
+                    break;
+                case "fill-opacity":
+                    style.fillOpacity = Opacity(value, style.fillOpacity);
+                    break;
+                case "stroke-opacity":
+                    style.strokeOpacity = Opacity(value, style.strokeOpacity);
+                    break;
+                case "opacity":
+                    style.opacity *= Opacity(value, 1);
+                    break;
+                case "stroke-width":
+                    style.strokeWidth = ParseLength(value, style.strokeWidth);
+                    break;
+                case "fill-rule":
+                    style.evenOdd = value == "evenodd";
+                    break;
+                case "stroke-linecap":
+                    // Painter2D has no square caps
+                    style.lineCap = value == "round" ? LineCap.Round : LineCap.Butt;
+                    break;
+                case "stroke-linejoin":
+                    style.lineJoin = value == "round" ? LineJoin.Round : value == "bevel" ? LineJoin.Bevel : LineJoin.Miter;
+                    break;
+                case "stroke-miterlimit":
+                    style.miterLimit = ParseLength(value, style.miterLimit);
+                    break;
+                case "display":
+                    if (value == "none")
+                        style.displayNone = true;
+                    break;
+                case "visibility":
+                    style.invisible = value == "hidden" || value == "collapse";
+                    break;
+            }
+        }
+
+        static string Paint(string value) {
+            if (value == "none" || value.StartsWith("url(", StringComparison.Ordinal))
+                return null;
+            // Keywords are case-insensitive
+            return string.Equals(value, CurrentColor, StringComparison.OrdinalIgnoreCase) ? CurrentColor : value;
+        }
+
+        static float Opacity(string value, float fallback) {
+            var percent = value.EndsWith("%", StringComparison.Ordinal);
+            if (!TryParseFloat(percent ? value.Substring(0, value.Length - 1) : value, out var v))
+                return fallback;
+            return Mathf.Clamp01(percent ? v / 100 : v);
+        }
+        #endregion
+
+        #region Shapes
+        static SvgShape ReadShape(XmlReader reader, string name, Style style) {
+            var builder = new PathBuilder(style.transform);
+            switch (name) {
+                case "path":
+                    var d = reader.GetAttribute("d");
+                    if (d == null)
+                        return null;
+                    ParsePathData(d, builder);
+                    break;
+                case "rect":
+                    AddRect(builder, Attr(reader, "x"), Attr(reader, "y"), Attr(reader, "width"), Attr(reader, "height"),
+                        reader.GetAttribute("rx"), reader.GetAttribute("ry"));
+                    break;
+                case "circle":
+                    var r = Attr(reader, "r");
+                    AddEllipse(builder, Attr(reader, "cx"), Attr(reader, "cy"), r, r);
+                    break;
+                case "ellipse":
+                    AddEllipse(builder, Attr(reader, "cx"), Attr(reader, "cy"), Attr(reader, "rx"), Attr(reader, "ry"));
+                    break;
+                case "line":
+                    builder.MoveTo(new Vector2(Attr(reader, "x1"), Attr(reader, "y1")));
+                    builder.LineTo(new Vector2(Attr(reader, "x2"), Attr(reader, "y2")));
+                    // Lines are never filled
+                    style.fill = null;
+                    break;
+                case "polyline":
+                case "polygon":
+                    var numbers = new List<float>();
+                    ParseNumbers(reader.GetAttribute("points") ?? "", numbers);
+                    for (int i = 0; i + 1 < numbers.Count; i += 2) {
+                        var p = new Vector2(numbers[i], numbers[i + 1]);
+                        if (i == 0)
+                            builder.MoveTo(p);
+                        else
+                            builder.LineTo(p);
+                    }
+                    if (name == "polygon")
+                        builder.Close();
+                    break;
+                default:
+                    return null;
+            }
+            var shape = builder.shape;
+            shape.fill = style.fill;
+            shape.stroke = style.strokeWidth > 0 ? style.stroke : null;
+            shape.fillOpacity = style.fillOpacity * style.opacity;
+            shape.strokeOpacity = style.strokeOpacity * style.opacity;
+            shape.strokeWidth = style.strokeWidth * style.transform.Scale;
+            shape.evenOdd = style.evenOdd;
+            shape.lineCap = style.lineCap;
+            shape.lineJoin = style.lineJoin;
+            shape.miterLimit = style.miterLimit;
+            return shape;
+        }
+
+        static float Attr(XmlReader reader, string name) {
+            return ParseLength(reader.GetAttribute(name), 0);
+        }
+
+        static void AddRect(PathBuilder builder, float x, float y, float w, float h, string rxAttr, string ryAttr) {
+            if (w <= 0 || h <= 0)
+                return;
+            var rx = ParseLength(rxAttr, float.NaN);
+            var ry = ParseLength(ryAttr, float.NaN);
+            if (float.IsNaN(rx))
+                rx = float.IsNaN(ry) ? 0 : ry;
+            if (float.IsNaN(ry))
+                ry = rx;
+            rx = Mathf.Clamp(rx, 0, w / 2);
+            ry = Mathf.Clamp(ry, 0, h / 2);
+            if (rx <= 0 || ry <= 0) {
+                builder.MoveTo(new Vector2(x, y));
+                builder.LineTo(new Vector2(x + w, y));
+                builder.LineTo(new Vector2(x + w, y + h));
+                builder.LineTo(new Vector2(x, y + h));
+                builder.Close();
+                return;
+            }
+            builder.MoveTo(new Vector2(x + rx, y));
+            builder.LineTo(new Vector2(x + w - rx, y));
+            builder.ArcTo(rx, ry, 0, false, true, new Vector2(x + w, y + ry));
+            builder.LineTo(new Vector2(x + w, y + h - ry));
+            builder.ArcTo(rx, ry, 0, false, true, new Vector2(x + w - rx, y + h));
+            builder.LineTo(new Vector2(x + rx, y + h));
+            builder.ArcTo(rx, ry, 0, false, true, new Vector2(x, y + h - ry));
+            builder.LineTo(new Vector2(x, y + ry));
+            builder.ArcTo(rx, ry, 0, false, true, new Vector2(x + rx, y));
+            builder.Close();
+        }
+
+        static void AddEllipse(PathBuilder builder, float cx, float cy, float rx, float ry) {
+            if (rx <= 0 || ry <= 0)
+                return;
+            builder.MoveTo(new Vector2(cx + rx, cy));
+            builder.ArcTo(rx, ry, 0, false, true, new Vector2(cx - rx, cy));
+            builder.ArcTo(rx, ry, 0, false, true, new Vector2(cx + rx, cy));
+            builder.Close();
+        }
+        #endregion
+
+        #region Path data
+        static void ParsePathData(string d, PathBuilder builder) {
+            var i = 0;
+            var command = '\0';
+            var args = new float[7];
+            while (true) {
+                SkipSeparators(d, ref i);
+                if (i >= d.Length)
+                    return;
+                var c = d[i];
+                if (char.IsLetter(c) && c != 'e' && c != 'E') {
+                    command = c;
+                    i++;
+                    if (command == 'Z' || command == 'z') {
+                        builder.Close();
+                        continue;
+                    }
+                } else if (command == '\0' || command == 'Z' || command == 'z') {
+                    return; // Numbers without a command: invalid, stop here (like browsers)
+                }
+                var count = ArgCount(command);
+                if (count < 0)
+                    return;
+                for (int k = 0; k < count; k++) {
+                    SkipSeparators(d, ref i);
+                    // Arc flags can be written without separators ("a1 1 0 00.5.5")
+                    var isFlag = (command == 'A' || command == 'a') && (k == 3 || k == 4);
+                    if (isFlag) {
+                        if (i >= d.Length || (d[i] != '0' && d[i] != '1'))
+                            return;
+                        args[k] = d[i++] - '0';
+                    } else if (!TryReadNumber(d, ref i, out args[k])) {
+                        return;
+                    }
+                }
+                if (!ApplyCommand(builder, command, args))
+                    return;
+                // Extra coordinate pairs after a moveto are linetos
+                if (command == 'M')
+                    command = 'L';
+                else if (command == 'm')
+                    command = 'l';
+            }
+        }
+
+        static int ArgCount(char command) {
+            switch (char.ToUpperInvariant(command)) {
+                case 'M':
+                case 'L':
+                case 'T':
+                    return 2;
+                case 'H':
+                case 'V':
+                    return 1;
+                case 'C':
+                    return 6;
+                case 'S':
+                case 'Q':
+                    return 4;
+                case 'A':
+                    return 7;
+                default:
+                    return -1;
+            }
+        }
+
+        static bool ApplyCommand(PathBuilder b, char command, float[] a) {
+            var relative = char.IsLower(command);
+            var o = relative ? b.current : Vector2.zero;
+            switch (char.ToUpperInvariant(command)) {
+                case 'M':
+                    b.MoveTo(o + new Vector2(a[0], a[1]));
+                    break;
+                case 'L':
+                    b.LineTo(o + new Vector2(a[0], a[1]));
+                    break;
+                case 'H':
+                    b.LineTo(new Vector2(relative ? b.current.x + a[0] : a[0], b.current.y));
+                    break;
+                case 'V':
+                    b.LineTo(new Vector2(b.current.x, relative ? b.current.y + a[0] : a[0]));
+                    break;
+                case 'C':
+                    b.CubicTo(o + new Vector2(a[0], a[1]), o + new Vector2(a[2], a[3]), o + new Vector2(a[4], a[5]));
+                    break;
+                case 'S':
+                    b.CubicTo(b.ReflectedCubicControl(), o + new Vector2(a[0], a[1]), o + new Vector2(a[2], a[3]));
+                    break;
+                case 'Q':
+                    b.QuadraticTo(o + new Vector2(a[0], a[1]), o + new Vector2(a[2], a[3]));
+                    break;
+                case 'T':
+                    b.QuadraticTo(b.ReflectedQuadraticControl(), o + new Vector2(a[0], a[1]));
+                    break;
+                case 'A':
+                    b.ArcTo(a[0], a[1], a[2], a[3] != 0, a[4] != 0, o + new Vector2(a[5], a[6]));
+                    break;
+                default:
+                    return false;
+            }
+            return true;
+        }
+
+        static void SkipSeparators(string s, ref int i) {
+            while (i < s.Length && (char.IsWhiteSpace(s[i]) || s[i] == ','))
+                i++;
+        }
+
+        /// <summary>
+        /// Reads an SVG number, which ends wherever it can't continue ("1.5.5" is 1.5 and .5, "1-2" is 1 and -2).
+        /// </summary>
+        static bool TryReadNumber(string s, ref int i, out float value) {
+            var start = i;
+            if (i < s.Length && (s[i] == '+' || s[i] == '-'))
+                i++;
+            var digits = 0;
+            while (i < s.Length && char.IsDigit(s[i])) {
+                i++;
+                digits++;
+            }
+            if (i < s.Length && s[i] == '.') {
+                i++;
+                while (i < s.Length && char.IsDigit(s[i])) {
+                    i++;
+                    digits++;
+                }
+            }
+            if (digits == 0) {
+                i = start;
+                value = 0;
+                return false;
+            }
+            if (i < s.Length && (s[i] == 'e' || s[i] == 'E')) {
+                var exponent = i;
+                i++;
+                if (i < s.Length && (s[i] == '+' || s[i] == '-'))
+                    i++;
+                if (i < s.Length && char.IsDigit(s[i])) {
+                    while (i < s.Length && char.IsDigit(s[i]))
+                        i++;
+                } else {
+                    i = exponent;
+                }
+            }
+            return TryParseFloat(s.Substring(start, i - start), out value);
+        }
+
+        static void ParseNumbers(string s, List<float> numbers) {
+            var i = 0;
+            while (true) {
+                SkipSeparators(s, ref i);
+                if (i >= s.Length || !TryReadNumber(s, ref i, out var v))
+                    return;
+                numbers.Add(v);
+            }
+        }
+
+        /// <summary>
+        /// A number with an optional px unit (other units and percentages aren't resolved: fallback).
+        /// </summary>
+        static float ParseLength(string s, float fallback) {
+            if (string.IsNullOrEmpty(s))
+                return fallback;
+            s = s.Trim();
+            if (s.EndsWith("px", StringComparison.Ordinal))
+                s = s.Substring(0, s.Length - 2);
+            return TryParseFloat(s, out var v) ? v : fallback;
+        }
+
+        static bool TryParseFloat(string s, out float value) {
+            return float.TryParse(s, NumberStyles.Float, CultureInfo.InvariantCulture, out value);
+        }
+        #endregion
+
+        #region Transforms
+        static Matrix ParseTransform(string s) {
+            var result = Matrix.Identity;
+            var numbers = new List<float>();
+            var i = 0;
+            while (i < s.Length) {
+                SkipSeparators(s, ref i);
+                var open = s.IndexOf('(', i);
+                if (open < 0)
+                    break;
+                var close = s.IndexOf(')', open);
+                if (close < 0)
+                    break;
+                var name = s.Substring(i, open - i).Trim();
+                numbers.Clear();
+                ParseNumbers(s.Substring(open + 1, close - open - 1), numbers);
+                i = close + 1;
+                var n = numbers;
+                Matrix m;
+                switch (name) {
+                    case "matrix" when n.Count == 6:
+                        m = new Matrix(n[0], n[1], n[2], n[3], n[4], n[5]);
+                        break;
+                    case "translate" when n.Count >= 1:
+                        m = new Matrix(1, 0, 0, 1, n[0], n.Count > 1 ? n[1] : 0);
+                        break;
+                    case "scale" when n.Count >= 1:
+                        m = new Matrix(n[0], 0, 0, n.Count > 1 ? n[1] : n[0], 0, 0);
+                        break;
+                    case "rotate" when n.Count >= 1:
+                        var radians = n[0] * Mathf.Deg2Rad;
+                        var cos = Mathf.Cos(radians);
+                        var sin = Mathf.Sin(radians);
+                        m = new Matrix(cos, sin, -sin, cos, 0, 0);
+                        if (n.Count >= 3) {
+                            m = new Matrix(1, 0, 0, 1, n[1], n[2]).Multiply(m)
+                                .Multiply(new Matrix(1, 0, 0, 1, -n[1], -n[2]));
+                        }
+                        break;
+                    case "skewX" when n.Count >= 1:
+                        m = new Matrix(1, 0, Mathf.Tan(n[0] * Mathf.Deg2Rad), 1, 0, 0);
+                        break;
+                    case "skewY" when n.Count >= 1:
+                        m = new Matrix(1, Mathf.Tan(n[0] * Mathf.Deg2Rad), 0, 1, 0, 0);
+                        break;
+                    default:
+                        continue;
+                }
+                result = result.Multiply(m);
+            }
+            return result;
+        }
+
+        /// <summary>
+        /// x' = a*x + c*y + e, y' = b*x + d*y + f.
+        /// </summary>
+        struct Matrix {
+            public static readonly Matrix Identity = new Matrix(1, 0, 0, 1, 0, 0);
+
+            public readonly float a, b, c, d, e, f;
+
+            public Matrix(float a, float b, float c, float d, float e, float f) {
+                this.a = a;
+                this.b = b;
+                this.c = c;
+                this.d = d;
+                this.e = e;
+                this.f = f;
+            }
+
+            /// <summary>
+            /// Average scale, for stroke widths
+            /// </summary>
+            public float Scale => Mathf.Sqrt(Mathf.Abs(a * d - b * c));
+
+            public Vector2 Apply(Vector2 p) {
+                return new Vector2(a * p.x + c * p.y + e, b * p.x + d * p.y + f);
+            }
+
+            /// <summary>
+            /// `other` applied first, then this.
+            /// </summary>
+            public Matrix Multiply(Matrix o) {
+                return new Matrix(
+                    a * o.a + c * o.b, b * o.a + d * o.b,
+                    a * o.c + c * o.d, b * o.c + d * o.d,
+                    a * o.e + c * o.f + e, b * o.e + d * o.f + f);
+            }
+        }
+        #endregion
+
+        /// <summary>
+        /// Tracks the current point (in user space) and writes transformed commands.
+        /// </summary>
+        class PathBuilder {
+            public readonly SvgShape shape = new SvgShape();
+            public Vector2 current;
+
+            readonly Matrix _transform;
+            Vector2 _subpathStart;
+            Vector2 _lastControl;
+            SvgPathOp _lastOp = SvgPathOp.Close;
+            bool _open;
+
+            public PathBuilder(Matrix transform) {
+                _transform = transform;
+            }
+
+            public void MoveTo(Vector2 p) {
+                Add(SvgPathOp.MoveTo, p, default, default);
+                current = _subpathStart = p;
+                _open = true;
+                _lastOp = SvgPathOp.MoveTo;
+            }
+
+            public void LineTo(Vector2 p) {
+                EnsureOpen();
+                Add(SvgPathOp.LineTo, p, default, default);
+                current = p;
+                _lastOp = SvgPathOp.LineTo;
+            }
+
+            public void CubicTo(Vector2 c1, Vector2 c2, Vector2 p) {
+                EnsureOpen();
+                Add(SvgPathOp.CubicTo, c1, c2, p);
+                current = p;
+                _lastControl = c2;
+                _lastOp = SvgPathOp.CubicTo;
+            }
+
+            public void QuadraticTo(Vector2 c, Vector2 p) {
+                EnsureOpen();
+                Add(SvgPathOp.QuadraticTo, c, p, default);
+                current = p;
+                _lastControl = c;
+                _lastOp = SvgPathOp.QuadraticTo;
+            }
+
+            public Vector2 ReflectedCubicControl() {
+                return _lastOp == SvgPathOp.CubicTo ? current * 2 - _lastControl : current;
+            }
+
+            public Vector2 ReflectedQuadraticControl() {
+                return _lastOp == SvgPathOp.QuadraticTo ? current * 2 - _lastControl : current;
+            }
+
+            public void Close() {
+                if (!_open)
+                    return;
+                Add(SvgPathOp.Close, default, default, default);
+                current = _subpathStart;
+                _open = false;
+                _lastOp = SvgPathOp.Close;
+            }
+
+            /// <summary>
+            /// Elliptical arc (SVG endpoint parameterization) as up to four cubics, one per quarter turn or less.
+            /// </summary>
+            public void ArcTo(float rx, float ry, float rotation, bool largeArc, bool sweep, Vector2 end) {
+                var start = current;
+                rx = Mathf.Abs(rx);
+                ry = Mathf.Abs(ry);
+                if (rx < 1e-6f || ry < 1e-6f || (end - start).sqrMagnitude < 1e-12f) {
+                    if (start != end)
+                        LineTo(end);
+                    return;
+                }
+                var phi = rotation * Mathf.Deg2Rad;
+                var cos = Mathf.Cos(phi);
+                var sin = Mathf.Sin(phi);
+                // Step 1: the midpoint in the ellipse's rotated frame
+                var dx = (start.x - end.x) / 2;
+                var dy = (start.y - end.y) / 2;
+                var x1 = cos * dx + sin * dy;
+                var y1 = -sin * dx + cos * dy;
+                // Scale the radii up if the end point is out of reach
+                var lambda = x1 * x1 / (rx * rx) + y1 * y1 / (ry * ry);
+                if (lambda > 1) {
+                    var s = Mathf.Sqrt(lambda);
+                    rx *= s;
+                    ry *= s;
+                }
+                // Step 2: the center
+                var num = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+                var den = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+                var coef = Mathf.Sqrt(Mathf.Max(num / den, 0)) * (largeArc == sweep ? -1 : 1);
+                var cx1 = coef * rx * y1 / ry;
+                var cy1 = -coef * ry * x1 / rx;
+                var cx = cos * cx1 - sin * cy1 + (start.x + end.x) / 2;
+                var cy = sin * cx1 + cos * cy1 + (start.y + end.y) / 2;
+                // Step 3: the angles
+                var theta = Angle(1, 0, (x1 - cx1) / rx, (y1 - cy1) / ry);
+                var delta = Angle((x1 - cx1) / rx, (y1 - cy1) / ry, (-x1 - cx1) / rx, (-y1 - cy1) / ry);
+                if (!sweep && delta > 0)
+                    delta -= Mathf.PI * 2;
+                else if (sweep && delta < 0)
+                    delta += Mathf.PI * 2;
+
+                var segments = Mathf.Max(1, Mathf.CeilToInt(Mathf.Abs(delta) / (Mathf.PI / 2) - 0.001f));
+                var step = delta / segments;
+                var k = 4f / 3f * Mathf.Tan(step / 4);
+                for (int i = 0; i < segments; i++) {
+                    var a0 = theta + step * i;
+                    var a1 = a0 + step;
+                    var p0 = new Vector2(Mathf.Cos(a0), Mathf.Sin(a0));
+                    var p1 = new Vector2(Mathf.Cos(a1), Mathf.Sin(a1));
+                    var c1 = p0 + new Vector2(-p0.y, p0.x) * k;
+                    var c2 = p1 - new Vector2(-p1.y, p1.x) * k;
+                    CubicTo(Map(c1), Map(c2), i == segments - 1 ? end : Map(p1));
+                }
+
+                Vector2 Map(Vector2 unit) {
+                    var x = unit.x * rx;
+                    var y = unit.y * ry;
+                    return new Vector2(cos * x - sin * y + cx, sin * x + cos * y + cy);
+                }
+            }
+
+            static float Angle(float ux, float uy, float vx, float vy) {
+                return Mathf.Atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+            }
+
+            /// <summary>
+            /// Drawing after a closepath starts a new subpath at the same point (like Painter2D needs).
+            /// </summary>
+            void EnsureOpen() {
+                if (!_open)
+                    MoveTo(current);
+            }
+
+            void Add(SvgPathOp op, Vector2 p0, Vector2 p1, Vector2 p2) {
+                shape.commands.Add(new SvgPathCommand {
+                    op = op,
+                    p0 = _transform.Apply(p0),
+                    p1 = op == SvgPathOp.CubicTo || op == SvgPathOp.QuadraticTo ? _transform.Apply(p1) : default,
+                    p2 = op == SvgPathOp.CubicTo ? _transform.Apply(p2) : default
+                });
+            }
+        }
+    }
+}
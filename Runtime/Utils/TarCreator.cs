@@ -1,6 +1,9 @@
 ﻿using System;
+using System.Collections.Concurrent;
 using System.Collections.Generic;
 using System.IO;
+using System.Linq;
+using System.Threading.Tasks;
 using DotNet.Globbing;
 using ICSharpCode.SharpZipLib.Tar;
 using NUglify;
@@ -14,8 +17,25 @@ namespace OneJS.Utils {
         public string[] IgnoreList { get; set; }
         public bool IncludeRoot { get; set; } = true;
 
+        /// <summary>
+        /// Path, hash and size of every entry written so far. See WriteManifest().
+        /// </summary>
+        public BundleManifest Manifest { get; } = new BundleManifest();
+
+        /// <summary>
+        /// When set, minified JS is looked up here first (keyed by source hash and minifier options) and stored
+        /// after minifying, so re-packaging unchanged sources skips NUglify entirely.
+        /// </summary>
+        public MinifyCache MinifyCache { get; set; }
+
         string _baseDir;
         string _rootDir;
+        Glob[] _ignoreGlobs;
+
+        const int BatchSize = 256;
+
+        // Part of the minify cache key, so that a NUglify upgrade or settings change invalidates old entries
+        static readonly string MinifyOptions = $"nuglify {typeof(Uglify).Assembly.GetName().Version} default";
 
         /**
          * Creates a new TarCreator.
@@ -28,87 +48,196 @@ namespace OneJS.Utils {
         }
 
         /// <summary>
-        /// Creates a single tar file from the given top-level includes. Basically, it calls CreateTar() for each include.
+        /// Creates a single tar file from the given top-level includes. Files from all includes are collected
+        /// first, then read (and minified) in parallel and written in a stable order.
         /// </summary>
         public void CreateTarFromIncludes(string[] includes, TarOutputStream tarOutputStream) {
+            CreateFromIncludes(includes, new TarBundleWriter(tarOutputStream, false));
+        }
+
+        /// <summary>
+        /// Same as CreateTarFromIncludes(), for any container format (see BundleFormat.CreateWriter).
+        /// </summary>
+        public void CreateFromIncludes(string[] includes, IBundleWriter writer) {
+            var files = new List<TarFileInfo>();
             foreach (var include in includes) {
                 var includePath = Path.Combine(_baseDir, include);
                 if (Directory.Exists(includePath)) {
-                    CreateTar(tarOutputStream, includePath);
+                    files.AddRange(CollectFiles(includePath));
                 } else if (File.Exists(includePath)) {
-                    WriteEntry(tarOutputStream, includePath, include);
+                    if (!IsExcluded(includePath))
+                        files.Add(new TarFileInfo(includePath, include));
                 } else {
                     Debug.Log($"Include not found: {includePath}");
                 }
             }
+            WriteEntries(writer, files);
         }
 
         public void CreateTar(TarOutputStream tarOutputStream, string curDir = null) {
             curDir ??= _baseDir;
+            WriteEntries(new TarBundleWriter(tarOutputStream, false), CollectFiles(curDir));
+        }
+
+        public void WriteEntry(TarOutputStream tarOutputStream, string filepath, string tarName) {
+            if (IsExcluded(filepath))
+                return;
+            var bytes = ReadEntryBytes(filepath);
+            if (bytes != null)
+                AddEntry(new TarBundleWriter(tarOutputStream, false), tarName, bytes, BundleManifest.ComputeHash(bytes));
+        }
+
+        /// <summary>
+        /// Writes the manifest of everything written so far as the last entry, so the hashes are already known.
+        /// Extraction uses it to figure out which previously extracted files were removed.
+        /// </summary>
+        public void WriteManifest(TarOutputStream tarOutputStream) {
+            WriteManifest(new TarBundleWriter(tarOutputStream, false));
+        }
+
+        public void WriteManifest(IBundleWriter writer) {
+            writer.WriteEntry(BundleManifest.FileName, Manifest.ToBytes());
+        }
+
+        /// <summary>
+        /// Walks the directory tree in parallel. The result is sorted by tar name so that the output
+        /// doesn't depend on thread scheduling.
+        /// </summary>
+        List<TarFileInfo> CollectFiles(string dir) {
             // var baseBaseDir = Path.GetFullPath(IncludeRoot ? Path.Combine(_baseDir, "../") : _baseDir);
             var baseBaseDir = Path.GetFullPath(IncludeRoot ? _rootDir : _baseDir);
+            var bag = new ConcurrentBag<TarFileInfo>();
+            CollectFiles(dir, baseBaseDir, bag);
+            var files = new List<TarFileInfo>(bag);
+            files.Sort((a, b) => string.CompareOrdinal(a.tarName, b.tarName));
+            return files;
+        }
 
-            string[] filenames = Directory.GetFiles(curDir);
-            foreach (string filepath in filenames) {
-                string tarName = Path.GetRelativePath(baseBaseDir, filepath);
-                WriteEntry(tarOutputStream, filepath, tarName);
+        void CollectFiles(string curDir, string baseBaseDir, ConcurrentBag<TarFileInfo> bag) {
+            foreach (string filepath in Directory.GetFiles(curDir)) {
+                if (!IsExcluded(filepath))
+                    bag.Add(new TarFileInfo(filepath, Path.GetRelativePath(baseBaseDir, filepath)));
             }
-
-            var di = new DirectoryInfo(curDir);
-            foreach (DirectoryInfo dir in di.EnumerateDirectories()) {
+            var subDirs = new DirectoryInfo(curDir).GetDirectories();
+            Parallel.ForEach(subDirs, dir => {
                 if (dir.Name != ".git" && !IsIgnored(dir.FullName))
-                    CreateTar(tarOutputStream, dir.FullName);
+                    CollectFiles(dir.FullName, baseBaseDir, bag);
+            });
+        }
+
+        /// <summary>
+        /// Reads (and minifies) files on all cores in batches, while the previous batch is being written.
+        /// Tar entries are still written sequentially in the given order.
+        /// </summary>
+        void WriteEntries(IBundleWriter writer, List<TarFileInfo> files) {
+            Task<EntryData[]> next = files.Count > 0 ? Task.Run(() => ReadBatch(files, 0)) : null;
+            for (int start = 0; start < files.Count; start += BatchSize) {
+                var batch = next.Result;
+                var nextStart = start + BatchSize;
+                next = nextStart < files.Count ? Task.Run(() => ReadBatch(files, nextStart)) : null;
+                for (int i = 0; i < batch.Length; i++) {
+                    if (batch[i].bytes != null)
+                        AddEntry(writer, files[start + i].tarName, batch[i].bytes, batch[i].hash);
+                }
             }
         }
 
-        public void WriteEntry(TarOutputStream tarOutputStream, string filepath, string tarName) {
-            if (ExcludeTS && ((filepath.EndsWith(".ts") && !filepath.EndsWith(".d.ts")) || filepath.EndsWith(".tsx")))
-                return;
-            if (ExcludeTSDef && filepath.EndsWith(".d.ts"))
-                return;
-            if (IsIgnored(filepath))
-                return;
-            byte[] bytes;
+        EntryData[] ReadBatch(List<TarFileInfo> files, int start) {
+            var results = new EntryData[Math.Min(BatchSize, files.Count - start)];
+            Parallel.For(0, results.Length, i => {
+                var bytes = ReadEntryBytes(files[start + i].filepath);
+                if (bytes != null)
+                    results[i] = new EntryData(bytes, BundleManifest.ComputeHash(bytes));
+            });
+            return results;
+        }
+
+        /// <summary>
+        /// Returns null if the file should be skipped (i.e. it couldn't be minified).
+        /// </summary>
+        byte[] ReadEntryBytes(string filepath) {
             if (UglifyJS && filepath.EndsWith(".js")) {
                 var str = File.ReadAllText(filepath);
+                string cacheKey = null;
+                if (MinifyCache != null) {
+                    cacheKey = MinifyCache.ComputeKey(str, MinifyOptions);
+                    if (MinifyCache.TryGet(cacheKey, out var cached))
+                        return cached;
+                }
                 try {
                     var res = Uglify.Js(str);
                     if (res.HasErrors) {
                         Debug.Log($"Could not uglify {filepath}\n\n" + string.Join("\n\n", res.Errors));
-                        return;
+                        return null;
                     }
-                    bytes = System.Text.Encoding.UTF8.GetBytes(res.Code);
+                    var bytes = System.Text.Encoding.UTF8.GetBytes(res.Code);
+                    MinifyCache?.Set(cacheKey, bytes);
+                    return bytes;
                 } catch (Exception e) {
                     Debug.Log($"Could not uglify {filepath}\n\n" + e.Message);
-                    return;
+                    return null;
                 }
-            } else {
-                bytes = File.ReadAllBytes(filepath);
             }
-            TarEntry entry = TarEntry.CreateTarEntry(tarName.Replace(@"\", @"/"));
-            entry.Size = bytes.Length;
-            tarOutputStream.PutNextEntry(entry);
-            tarOutputStream.Write(bytes, 0, bytes.Length);
-            tarOutputStream.CloseEntry();
+            return File.ReadAllBytes(filepath);
         }
 
+        void AddEntry(IBundleWriter writer, string tarName, byte[] bytes, string hash) {
+            tarName = tarName.Replace(@"\", @"/");
+            writer.WriteEntry(tarName, bytes);
+            Manifest.Add(tarName, hash, bytes.Length);
+        }
+
+        bool IsExcluded(string filepath) {
+            if (ExcludeTS && ((filepath.EndsWith(".ts") && !filepath.EndsWith(".d.ts")) || filepath.EndsWith(".tsx")))
+                return true;
+            if (ExcludeTSDef && filepath.EndsWith(".d.ts"))
+                return true;
+            return IsIgnored(filepath);
+        }
+
+        // Called from multiple threads
         bool IsIgnored(string filepath) {
             if (IgnoreList == null || IgnoreList.Length == 0)
                 return false;
             var path = Path.GetRelativePath(_rootDir, filepath);
-            var pttrns = new List<string>(IgnoreList);
-            pttrns.Insert(0, "**/.git*");
-            foreach (var pttrn in pttrns) {
-                var glob = Glob.Parse(pttrn);
-                var isMatch = glob.IsMatch(path);
-                if (isMatch) {
-                    Debug.Log($"IGNORED: {filepath}");
+            foreach (var glob in IgnoreGlobs) {
+                if (glob.IsMatch(path))
                     return true;
-                }
             }
             return false;
         }
 
+        Glob[] IgnoreGlobs {
+            get {
+                if (_ignoreGlobs == null) {
+                    var pttrns = new List<string>(IgnoreList);
+                    pttrns.Insert(0, "**/.git*");
+                    _ignoreGlobs = pttrns.Select(p => Glob.Parse(p)).ToArray();
+                }
+                return _ignoreGlobs;
+            }
+        }
+
+        readonly struct TarFileInfo {
+            public readonly string filepath;
+            public readonly string tarName;
+
+            public TarFileInfo(string filepath, string tarName) {
+                this.filepath = filepath;
+                this.tarName = tarName;
+            }
+        }
+
+        readonly struct EntryData {
+            public readonly byte[] bytes;
+            public readonly string hash;
+
+            public EntryData(byte[] bytes, string hash) {
+                this.bytes = bytes;
+                this.hash = hash;
+            }
+        }
+
         public static void CreateTarManually(TarOutputStream tarOutputStream, string baseDir, string curDir = null) {
             curDir ??= baseDir;
             var baseBaseDir = Path.GetFullPath(Path.Combine(baseDir, "../"));
@@ -0,0 +1,213 @@
+﻿using System.Collections.Generic;
+using NUnit.Framework;
+using OneJS.Dom;
+using UnityEngine;
+
+namespace OneJS.CI {
+    public class CssGradientTests {
+        const float Delta = 0.001f;
+
+        static CssGradient Parse(string css) {
+            Assert.IsTrue(CssGradient.TryParse(css, out var gradient), css);
+            return gradient;
+        }
+
+        static List<(float t, Color color)> Stops(string css, float length = 100) {
+            var stops = new List<(float t, Color color)>();
+            Parse(css).ResolveStops(length, stops);
+            return stops;
+        }
+
+        static void AssertColor(Color expected, Color actual) {
+            Assert.AreEqual(expected.r, actual.r, Delta, "r");
+            Assert.AreEqual(expected.g, actual.g, Delta, "g");
+            Assert.AreEqual(expected.b, actual.b, Delta, "b");
+            Assert.AreEqual(expected.a, actual.a, Delta, "a");
+        }
+
+        #region Angles
+        [TestCase("linear-gradient(red, blue)", 180)]
+        [TestCase("linear-gradient(45deg, red, blue)", 45)]
+        [TestCase("linear-gradient(-90deg, red, blue)", -90)]
+        [TestCase("linear-gradient(0.25turn, red, blue)", 90)]
+        [TestCase("linear-gradient(100grad, red, blue)", 90)]
+        [TestCase("linear-gradient(3.14159265rad, red, blue)", 180)]
+        [TestCase("linear-gradient(0, red, blue)", 0)]
+        [TestCase("linear-gradient(to top, red, blue)", 0)]
+        [TestCase("linear-gradient(to right, red, blue)", 90)]
+        [TestCase("linear-gradient(to bottom, red, blue)", 180)]
+        [TestCase("linear-gradient(to left, red, blue)", 270)]
+        public void Angle(string css, float degrees) {
+            var gradient = Parse(css);
+            Assert.AreEqual(CssGradient.Kind.Linear, gradient.kind);
+            Assert.AreEqual(degrees, gradient.ResolveAngle(new Rect(0, 0, 200, 100)), Delta);
+        }
+
+        [TestCase("to top right", 45)]
+        [TestCase("to bottom right", 135)]
+        [TestCase("to bottom left", 225)]
+        [TestCase("to top left", 315)]
+        public void CornerAngleOnSquare(string direction, float degrees) {
+            var gradient = Parse($"linear-gradient({direction}, red, blue)");
+            Assert.AreEqual(degrees, gradient.ResolveAngle(new Rect(0, 0, 100, 100)), Delta);
+        }
+
+        [Test]
+        public void CornerAngleDependsOnAspectRatio() {
+            // The 50% line runs from the bottom left to the top right corner of a 200x100 rect
+            var gradient = Parse("linear-gradient(to top right, red, blue)");
+            var expected = Mathf.Atan2(100, 200) * Mathf.Rad2Deg;
+            Assert.AreEqual(expected, gradient.ResolveAngle(new Rect(0, 0, 200, 100)), Delta);
+        }
+        #endregion
+
+        #region Color stops
+        [Test]
+        public void StopsWithoutPositionsAreSpreadEvenly() {
+            var stops = Stops("linear-gradient(red, lime, blue)");
+            Assert.AreEqual(3, stops.Count);
+            Assert.AreEqual(0, stops[0].t, Delta);
+            Assert.AreEqual(0.5f, stops[1].t, Delta);
+            Assert.AreEqual(1, stops[2].t, Delta);
+            AssertColor(Color.red, stops[0].color);
+            AssertColor(Color.green, stops[1].color);
+            AssertColor(Color.blue, stops[2].color);
+        }
+
+        [Test]
+        public void MissingPositionsAreInterpolated() {
+            var stops = Stops("linear-gradient(red, lime, blue 80%)");
+            Assert.AreEqual(0, stops[0].t, Delta);
+            Assert.AreEqual(0.4f, stops[1].t, Delta);
+            Assert.AreEqual(0.8f, stops[2].t, Delta);
+        }
+
+        [Test]
+        public void PixelPositionsAreRelativeToTheLength() {
+            var stops = Stops("linear-gradient(red 10px, blue 50px)", 200);
+            Assert.AreEqual(0.05f, stops[0].t, Delta);
+            Assert.AreEqual(0.25f, stops[1].t, Delta);
+        }
+
+        [Test]
+        public void PositionsNeverGoBackwards() {
+            var stops = Stops("linear-gradient(red 50%, blue 20%)");
+            Assert.AreEqual(0.5f, stops[0].t, Delta);
+            Assert.AreEqual(0.5f, stops[1].t, Delta);
+        }
+
+        [Test]
+        public void TwoPositionsMakeTwoStops() {
+            var stops = Stops("linear-gradient(red 0 50%, blue)");
+            Assert.AreEqual(3, stops.Count);
+            Assert.AreEqual(0.5f, stops[1].t, Delta);
+            AssertColor(Color.red, stops[1].color);
+        }
+
+        [Test]
+        public void ColorHintsAreSkipped() {
+            var stops = Stops("linear-gradient(red, 30%, blue)");
+            Assert.AreEqual(2, stops.Count);
+        }
+
+        [TestCase("#ff0000", 1, 0, 0, 1)]
+        [TestCase("#00f8", 0, 0, 1, 0.5333f)]
+        [TestCase("rgb(0, 255, 0)", 0, 1, 0, 1)]
+        [TestCase("rgba(255, 0, 0, 0.5)", 1, 0, 0, 0.5f)]
+        [TestCase("rgb(100% 0% 0% / 25%)", 1, 0, 0, 0.25f)]
+        [TestCase("transparent", 0, 0, 0, 0)]
+        public void Colors(string css, float r, float g, float b, float a) {
+            Assert.IsTrue(CssGradient.TryParseColor(css, out var color));
+            AssertColor(new Color(r, g, b, a), color);
+        }
+
+        [Test]
+        public void TransparentStopsTakeTheirNeighborsColor() {
+            var stops = Stops("linear-gradient(red, transparent, blue)");
+            // Split in two, so the fade goes red -> clear red, clear blue -> blue
+            Assert.AreEqual(4, stops.Count);
+            AssertColor(new Color(1, 0, 0, 0), stops[1].color);
+            AssertColor(new Color(0, 0, 1, 0), stops[2].color);
+            Assert.AreEqual(stops[1].t, stops[2].t, Delta);
+        }
+        #endregion
+
+        #region Radial
+        [Test]
+        public void RadialDefaultsToFarthestCornerEllipse() {
+            var gradient = Parse("radial-gradient(red, blue)");
+            var rect = new Rect(0, 0, 100, 50);
+            var center = gradient.ResolveCenter(rect);
+            Assert.AreEqual(CssGradient.Kind.Radial, gradient.kind);
+            Assert.AreEqual(50, center.x, Delta);
+            Assert.AreEqual(25, center.y, Delta);
+            var radii = gradient.ResolveRadii(rect, center);
+            Assert.AreEqual(50 * Mathf.Sqrt(2), radii.x, Delta);
+            Assert.AreEqual(25 * Mathf.Sqrt(2), radii.y, Delta);
+        }
+
+        [Test]
+        public void RadialCircleAtCorner() {
+            var gradient = Parse("radial-gradient(circle at top left, red, blue)");
+            var rect = new Rect(0, 0, 100, 50);
+            var center = gradient.ResolveCenter(rect);
+            Assert.AreEqual(0, center.x, Delta);
+            Assert.AreEqual(0, center.y, Delta);
+            var radii = gradient.ResolveRadii(rect, center);
+            Assert.AreEqual(new Vector2(100, 50).magnitude, radii.x, Delta);
+            Assert.AreEqual(radii.x, radii.y, Delta);
+        }
+
+        [Test]
+        public void RadialClosestSide() {
+            var gradient = Parse("radial-gradient(closest-side at 25% 50%, red, blue)");
+            var rect = new Rect(0, 0, 100, 50);
+            var radii = gradient.ResolveRadii(rect, gradient.ResolveCenter(rect));
+            Assert.AreEqual(25, radii.x, Delta);
+            Assert.AreEqual(25, radii.y, Delta);
+        }
+
+        [Test]
+        public void RadialExplicitRadii() {
+            var gradient = Parse("radial-gradient(20px 50%, red, blue)");
+            Assert.AreEqual(CssGradient.RadialSize.Explicit, gradient.size);
+            var rect = new Rect(0, 0, 100, 50);
+            var radii = gradient.ResolveRadii(rect, gradient.ResolveCenter(rect));
+            Assert.AreEqual(20, radii.x, Delta);
+            Assert.AreEqual(25, radii.y, Delta);
+        }
+
+        [Test]
+        public void SingleLengthIsACircle() {
+            var gradient = Parse("radial-gradient(10px, red, blue)");
+            Assert.IsTrue(gradient.circle);
+            var rect = new Rect(0, 0, 100, 50);
+            var radii = gradient.ResolveRadii(rect, gradient.ResolveCenter(rect));
+            Assert.AreEqual(10, radii.x, Delta);
+            Assert.AreEqual(10, radii.y, Delta);
+        }
+        #endregion
+
+        [Test]
+        public void Repeating() {
+            Assert.IsTrue(Parse("repeating-linear-gradient(red, blue 10px)").repeating);
+            Assert.IsTrue(Parse("repeating-radial-gradient(red, blue 10px)").repeating);
+            Assert.IsFalse(Parse("linear-gradient(red, blue)").repeating);
+        }
+
+        [TestCase("linear-gradient(45, red, blue)")]
+        [TestCase("linear-gradient(to middle, red, blue)")]
+        [TestCase("linear-gradient(45deg)")]
+        [TestCase("linear-gradient(red, blue")]
+        [TestCase("linear-gradient(red 10px 20px 30px, blue)")]
+        [TestCase("radial-gradient(circle 10px 20px, red, blue)")]
+        [TestCase("radial-gradient(50%, red, blue)")]
+        [TestCase("conic-gradient(red, blue)")]
+        [TestCase("red")]
+        [TestCase(null)]
+        public void Invalid(string css) {
+            Assert.IsFalse(CssGradient.TryParse(css, out var gradient));
+            Assert.IsNull(gradient);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+﻿using System;
+using System.Collections.Generic;
+using NUnit.Framework;
+
+namespace OneJS.CI {
+    public class HttpDiskCacheTests {
+        // Whole seconds, since HTTP dates have no fraction
+        static readonly DateTimeOffset Now = new DateTimeOffset(2024, 5, 1, 12, 0, 0, TimeSpan.Zero);
+        static readonly long NowMs = Now.ToUnixTimeMilliseconds();
+
+        /// <summary>
+        /// Seconds the response stays fresh for, from now
+        /// </summary>
+        static double Lifetime(Dictionary<string, string> headers) {
+            headers.TryGetValue("Cache-Control", out var cacheControl);
+            var expiry = HttpDiskCache.ComputeExpiry(name => headers.TryGetValue(name, out var value) ? value : null,
+                HttpDiskCache.ParseCacheControl(cacheControl), NowMs);
+            return (expiry - NowMs) / 1000.0;
+        }
+
+        static string HttpDate(DateTimeOffset date) {
+            return date.ToString("r");
+        }
+
+        [Test]
+        public void ParseCacheControl() {
+            var directives = HttpDiskCache.ParseCacheControl("Public, MAX-AGE=\"300\",, no-cache ");
+            Assert.AreEqual(3, directives.Count);
+            Assert.AreEqual("", directives["public"]);
+            Assert.AreEqual("300", directives["max-age"]);
+            Assert.AreEqual("", directives["no-cache"]);
+            Assert.AreEqual(0, HttpDiskCache.ParseCacheControl(null).Count);
+        }
+
+        [Test]
+        public void NoHeadersMeansStale() {
+            Assert.AreEqual(0, Lifetime(new Dictionary<string, string>()));
+        }
+
+        [Test]
+        public void MaxAge() {
+            Assert.AreEqual(60, Lifetime(new Dictionary<string, string> { ["Cache-Control"] = "max-age=60" }));
+        }
+
+        [Test]
+        public void MaxAgeMinusAge() {
+            Assert.AreEqual(50, Lifetime(new Dictionary<string, string> {
+                ["Cache-Control"] = "max-age=60", ["Age"] = "10"
+            }));
+        }
+
+        [Test]
+        public void MaxAgeWinsOverExpires() {
+            Assert.AreEqual(60, Lifetime(new Dictionary<string, string> {
+                ["Cache-Control"] = "max-age=60", ["Date"] = HttpDate(Now), ["Expires"] = HttpDate(Now.AddHours(1))
+            }));
+        }
+
+        [Test]
+        public void NoCacheIsAlwaysRevalidated() {
+            Assert.AreEqual(0, Lifetime(new Dictionary<string, string> {
+                ["Cache-Control"] = "max-age=60, no-cache", ["Expires"] = HttpDate(Now.AddHours(1))
+            }));
+        }
+
+        [Test]
+        public void ExpiresRelativeToDate() {
+            // The server's clock is an hour behind: Expires - Date counts, not Expires - now
+            var date = Now.AddHours(-1);
+            Assert.AreEqual(1800, Lifetime(new Dictionary<string, string> {
+                ["Date"] = HttpDate(date), ["Expires"] = HttpDate(date.AddMinutes(30))
+            }));
+        }
+
+        [Test]
+        public void ExpiresMinusAge() {
+            Assert.AreEqual(1700, Lifetime(new Dictionary<string, string> {
+                ["Date"] = HttpDate(Now), ["Expires"] = HttpDate(Now.AddMinutes(30)), ["Age"] = "100"
+            }));
+        }
+
+        [Test]
+        public void ExpiresWithoutDate() {
+            Assert.AreEqual(7200, Lifetime(new Dictionary<string, string> { ["Expires"] = HttpDate(Now.AddHours(2)) }));
+        }
+
+        [TestCase("0")]
+        [TestCase("-1")]
+        [TestCase("tomorrow")]
+        public void InvalidExpiresIsStale(string expires) {
+            Assert.AreEqual(0, Lifetime(new Dictionary<string, string> {
+                ["Date"] = HttpDate(Now), ["Expires"] = expires,
+                // Not used when Expires is there, even if invalid
+                ["Last-Modified"] = HttpDate(Now.AddDays(-10))
+            }));
+        }
+
+        [Test]
+        public void LastModifiedHeuristic() {
+            // 10% of the time since it was last modified
+            Assert.AreEqual(3600, Lifetime(new Dictionary<string, string> {
+                ["Date"] = HttpDate(Now), ["Last-Modified"] = HttpDate(Now.AddHours(-10))
+            }));
+        }
+
+        [Test]
+        public void LastModifiedHeuristicIsCapped() {
+            Assert.AreEqual(TimeSpan.FromDays(1).TotalSeconds, Lifetime(new Dictionary<string, string> {
+                ["Date"] = HttpDate(Now), ["Last-Modified"] = HttpDate(Now.AddDays(-365))
+            }));
+        }
+
+        [Test]
+        public void LastModifiedInTheFutureIsStale() {
+            Assert.AreEqual(0, Lifetime(new Dictionary<string, string> {
+                ["Date"] = HttpDate(Now), ["Last-Modified"] = HttpDate(Now.AddHours(1))
+            }));
+        }
+    }
+}
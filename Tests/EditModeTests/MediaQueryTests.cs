@@ -0,0 +1,109 @@
+﻿using NUnit.Framework;
+using OneJS.Dom;
+
+namespace OneJS.CI {
+    public class MediaQueryTests {
+        // 800x600 landscape at 2 physical pixels per UI pixel
+        static readonly MediaFeatures Features = new MediaFeatures {
+            width = 800, height = 600, dppx = 2, deviceWidth = 800, deviceHeight = 600
+        };
+
+        static bool Matches(string query) {
+            return MediaQuery.Parse(query).Evaluate(Features);
+        }
+
+        [TestCase("")]
+        [TestCase("all")]
+        [TestCase("screen")]
+        [TestCase("only screen")]
+        [TestCase("SCREEN AND (MIN-WIDTH: 800PX)")]
+        public void MediaTypes(string query) {
+            Assert.IsTrue(Matches(query));
+        }
+
+        [Test]
+        public void UnknownMediaTypeNeverMatches() {
+            Assert.IsFalse(Matches("print"));
+            Assert.IsTrue(Matches("not print"));
+        }
+
+        [TestCase("(min-width: 640px)", true)]
+        [TestCase("(max-width: 640px)", false)]
+        [TestCase("(width: 800px)", true)]
+        [TestCase("(min-width: 50em)", true)]
+        [TestCase("(min-width: 51rem)", false)]
+        [TestCase("(orientation: landscape)", true)]
+        [TestCase("(orientation: portrait)", false)]
+        [TestCase("(aspect-ratio: 4/3)", true)]
+        [TestCase("(min-aspect-ratio: 16/9)", false)]
+        [TestCase("(device-width: 800px)", true)]
+        [TestCase("(width)", true)]
+        public void SingleFeatures(string query, bool expected) {
+            Assert.AreEqual(expected, Matches(query));
+        }
+
+        [TestCase("(width >= 800px)", true)]
+        [TestCase("(width > 800px)", false)]
+        [TestCase("(600px < width)", true)]
+        [TestCase("(400px <= width < 900px)", true)]
+        [TestCase("(400px <= width < 800px)", false)]
+        [TestCase("(900px > width >= 800px)", true)]
+        public void RangeSyntax(string query, bool expected) {
+            Assert.AreEqual(expected, Matches(query));
+        }
+
+        [TestCase("(resolution: 2dppx)", true)]
+        [TestCase("(resolution: 2x)", true)]
+        [TestCase("(min-resolution: 192dpi)", true)]
+        [TestCase("(min-resolution: 2.5dppx)", false)]
+        [TestCase("(max-resolution: 1dppx)", false)]
+        [TestCase("(resolution > 1.5x)", true)]
+        public void Resolution(string query, bool expected) {
+            Assert.AreEqual(expected, Matches(query));
+        }
+
+        [TestCase("not (orientation: portrait)", true)]
+        [TestCase("not (min-width: 640px)", false)]
+        [TestCase("NOT (width > 1000px)", true)]
+        [TestCase("(not (width < 100px))", true)]
+        [TestCase("not ((width > 100px) and (height > 100px))", false)]
+        [TestCase("not screen and (min-width: 1000px)", true)]
+        [TestCase("not screen and (min-width: 640px)", false)]
+        public void Not(string query, bool expected) {
+            Assert.AreEqual(expected, Matches(query));
+        }
+
+        [TestCase("(min-width: 1000px) or (min-resolution: 2dppx)", true)]
+        [TestCase("(width < 400px) or (height < 400px)", false)]
+        [TestCase("screen and ((width < 400px) or (height < 700px))", true)]
+        [TestCase("(width > 100px) and (height > 100px) and (resolution: 2x)", true)]
+        public void AndOr(string query, bool expected) {
+            Assert.AreEqual(expected, Matches(query));
+        }
+
+        [Test]
+        public void ListMatchesIfAnyQueryDoes() {
+            Assert.IsTrue(Matches("(max-width: 400px), (orientation: landscape)"));
+            Assert.IsFalse(Matches("(max-width: 400px), (orientation: portrait)"));
+        }
+
+        [TestCase("(min-width: 640px) and")]
+        [TestCase("(width) and (height) or (resolution)")]
+        [TestCase("not (width) and (height)")]
+        [TestCase("screen and (width) or (height)")]
+        [TestCase("only (width)")]
+        [TestCase("(min-width: 640)")]
+        [TestCase("(colour: red)")]
+        [TestCase("(min-width: 640px")]
+        public void InvalidQueriesNeverMatch(string query) {
+            Assert.IsFalse(Matches(query));
+            // Not even negated
+            Assert.IsFalse(Matches("not " + query));
+        }
+
+        [Test]
+        public void InvalidQueryLeavesTheRestOfTheListAlone() {
+            Assert.IsTrue(Matches("(min-width: 640), (orientation: landscape)"));
+        }
+    }
+}
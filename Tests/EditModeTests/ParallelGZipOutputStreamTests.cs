@@ -0,0 +1,57 @@
+﻿using System;
+using System.IO;
+using ICSharpCode.SharpZipLib.GZip;
+using NUnit.Framework;
+using OneJS.Utils;
+
+namespace OneJS.CI {
+    public class ParallelGZipOutputStreamTests {
+        const int BlockSize = 128 * 1024;
+
+        /// <summary>
+        /// Compressible but not trivially so, and spanning several blocks (and several stored blocks per block)
+        /// </summary>
+        static byte[] Input(int size) {
+            var random = new Random(size);
+            var data = new byte[size];
+            for (int i = 0; i < size; i++)
+                data[i] = random.Next(4) == 0 ? (byte)random.Next(256) : (byte)(i % 7);
+            return data;
+        }
+
+        static byte[] RoundTrip(byte[] input, int level) {
+            var compressed = new MemoryStream();
+            using (var gzip = new ParallelGZipOutputStream(compressed, level, BlockSize) { IsStreamOwner = false })
+                gzip.Write(input, 0, input.Length);
+            compressed.Position = 0;
+            var output = new MemoryStream();
+            using (var gunzip = new GZipInputStream(compressed))
+                gunzip.CopyTo(output);
+            return output.ToArray();
+        }
+
+        [Test]
+        public void RoundTripsAtEveryLevel([Range(0, 9)] int level,
+            [Values(0, 1, 65535, 65536, BlockSize + 1, 1024 * 1024)] int size) {
+            var input = Input(size);
+            CollectionAssert.AreEqual(input, RoundTrip(input, level));
+        }
+
+        [Test]
+        public void LevelZeroIsStored() {
+            var input = Input(BlockSize * 2);
+            var compressed = new MemoryStream();
+            using (var gzip = new ParallelGZipOutputStream(compressed, 0, BlockSize) { IsStreamOwner = false })
+                gzip.Write(input, 0, input.Length);
+            // Only headers on top of the input: 5 bytes per 64K stored block, the gzip header and trailer
+            Assert.Greater(compressed.Length, input.Length);
+            Assert.Less(compressed.Length, input.Length + 128);
+        }
+
+        [TestCase(-1)]
+        [TestCase(10)]
+        public void RejectsInvalidLevels(int level) {
+            Assert.Throws<ArgumentOutOfRangeException>(() => new ParallelGZipOutputStream(new MemoryStream(), level));
+        }
+    }
+}
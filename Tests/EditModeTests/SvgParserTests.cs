@@ -0,0 +1,267 @@
+﻿using System;
+using NUnit.Framework;
+using OneJS.Utils;
+using UnityEngine;
+
+namespace OneJS.CI {
+    public class SvgParserTests {
+        const float Delta = 0.001f;
+
+        static SvgDocument Parse(string content, string attributes = "viewBox=\"0 0 100 100\"") {
+            return SvgParser.Parse($"<svg xmlns=\"http://www.w3.org/2000/svg\" {attributes}>{content}</svg>");
+        }
+
+        static SvgShape Path(string d, string attributes = "") {
+            var document = Parse($"<path d=\"{d}\" {attributes}/>");
+            Assert.AreEqual(1, document.shapes.Count);
+            return document.shapes[0];
+        }
+
+        static void AssertPoint(float x, float y, Vector2 actual) {
+            Assert.AreEqual(x, actual.x, Delta, "x");
+            Assert.AreEqual(y, actual.y, Delta, "y");
+        }
+
+        static void AssertOps(SvgShape shape, params SvgPathOp[] ops) {
+            Assert.AreEqual(ops.Length, shape.commands.Count);
+            for (int i = 0; i < ops.Length; i++)
+                Assert.AreEqual(ops[i], shape.commands[i].op, $"Command {i}");
+        }
+
+        /// <summary>
+        /// Where a command leaves the current point
+        /// </summary>
+        static Vector2 End(SvgPathCommand command) {
+            switch (command.op) {
+                case SvgPathOp.CubicTo: return command.p2;
+                case SvgPathOp.QuadraticTo: return command.p1;
+                default: return command.p0;
+            }
+        }
+
+        #region Document
+        [Test]
+        public void ViewBoxAndSize() {
+            var document = Parse("", "viewBox=\"10 20 24 12\" width=\"48px\"");
+            Assert.AreEqual(new Rect(10, 20, 24, 12), document.viewBox);
+            // The missing height follows the viewBox's aspect ratio
+            AssertPoint(48, 24, document.size);
+        }
+
+        [Test]
+        public void SizeWithoutViewBox() {
+            var document = Parse("", "width=\"32\" height=\"16\"");
+            Assert.AreEqual(new Rect(0, 0, 32, 16), document.viewBox);
+            AssertPoint(32, 16, document.size);
+        }
+
+        [Test]
+        public void NotAnSvg() {
+            Assert.Throws<FormatException>(() => SvgParser.Parse("<html></html>"));
+        }
+        #endregion
+
+        #region Path data
+        [Test]
+        public void AbsoluteCommands() {
+            var shape = Path("M10 20 L30 40 H50 V60 Z");
+            AssertOps(shape, SvgPathOp.MoveTo, SvgPathOp.LineTo, SvgPathOp.LineTo, SvgPathOp.LineTo, SvgPathOp.Close);
+            AssertPoint(10, 20, shape.commands[0].p0);
+            AssertPoint(30, 40, shape.commands[1].p0);
+            AssertPoint(50, 40, shape.commands[2].p0);
+            AssertPoint(50, 60, shape.commands[3].p0);
+        }
+
+        [Test]
+        public void RelativeCommands() {
+            var shape = Path("m10 10 l5 5 h5 v-5 z m1 1 l1 0");
+            AssertPoint(15, 15, shape.commands[1].p0);
+            AssertPoint(20, 15, shape.commands[2].p0);
+            AssertPoint(20, 10, shape.commands[3].p0);
+            // After closepath, relative moves start from the subpath's start
+            AssertPoint(11, 11, shape.commands[5].p0);
+            AssertPoint(12, 11, shape.commands[6].p0);
+        }
+
+        [Test]
+        public void ExtraPairsAfterMoveToAreLineTos() {
+            var shape = Path("M0 0 10 10 20 0");
+            AssertOps(shape, SvgPathOp.MoveTo, SvgPathOp.LineTo, SvgPathOp.LineTo);
+        }
+
+        [Test]
+        public void CompactNumbers() {
+            var shape = Path("M1.5.5L-2-3e1");
+            AssertPoint(1.5f, 0.5f, shape.commands[0].p0);
+            AssertPoint(-2, -30, shape.commands[1].p0);
+        }
+
+        [Test]
+        public void SmoothCurvesReflectTheLastControlPoint() {
+            var shape = Path("M0 0 C0 10 10 10 10 0 S20 -10 20 0 Q25 10 30 0 T40 0");
+            AssertOps(shape, SvgPathOp.MoveTo, SvgPathOp.CubicTo, SvgPathOp.CubicTo, SvgPathOp.QuadraticTo,
+                SvgPathOp.QuadraticTo);
+            AssertPoint(10, -10, shape.commands[2].p0);
+            AssertPoint(35, -10, shape.commands[4].p0);
+            AssertPoint(40, 0, shape.commands[4].p1);
+        }
+
+        [Test]
+        public void InvalidDataStopsThere() {
+            var shape = Path("M0 0 L10 10 L20 x L30 30");
+            AssertOps(shape, SvgPathOp.MoveTo, SvgPathOp.LineTo);
+        }
+        #endregion
+
+        #region Arcs
+        [TestCase("M0 0 A10 10 0 0 1 20 0")]
+        [TestCase("M0 0a10 10 0 0120 0")]
+        // Radii too small to reach the end point are scaled up
+        [TestCase("M0 0 A1 1 0 0 1 20 0")]
+        public void HalfCircleArc(string d) {
+            var shape = Path(d, "fill=\"none\" stroke=\"black\"");
+            // One cubic per quarter turn
+            AssertOps(shape, SvgPathOp.MoveTo, SvgPathOp.CubicTo, SvgPathOp.CubicTo);
+            // Sweep 1 is clockwise with y down, so over the top
+            AssertPoint(10, -10, End(shape.commands[1]));
+            AssertPoint(20, 0, End(shape.commands[2]));
+        }
+
+        [Test]
+        public void SweepFlagPicksTheSide() {
+            var shape = Path("M0 0 A10 10 0 0 0 20 0");
+            AssertPoint(10, 10, End(shape.commands[1]));
+        }
+
+        [Test]
+        public void LargeArcFlag() {
+            // A quarter of a circle centered on (10, 10), or the other three quarters
+            var small = Path("M0 10 A10 10 0 0 1 10 0");
+            var large = Path("M0 10 A10 10 0 1 0 10 0");
+            Assert.AreEqual(2, small.commands.Count);
+            Assert.AreEqual(4, large.commands.Count);
+            AssertPoint(10, 20, End(large.commands[1]));
+            AssertPoint(20, 10, End(large.commands[2]));
+            AssertPoint(10, 0, End(large.commands[3]));
+        }
+
+        [Test]
+        public void ZeroRadiusArcIsALine() {
+            var shape = Path("M0 0 A0 10 0 0 1 20 0");
+            AssertOps(shape, SvgPathOp.MoveTo, SvgPathOp.LineTo);
+        }
+
+        [Test]
+        public void CircleIsFourQuarterArcs() {
+            var shape = Parse("<circle cx=\"50\" cy=\"40\" r=\"10\"/>").shapes[0];
+            AssertOps(shape, SvgPathOp.MoveTo, SvgPathOp.CubicTo, SvgPathOp.CubicTo, SvgPathOp.CubicTo,
+                SvgPathOp.CubicTo, SvgPathOp.Close);
+            AssertPoint(60, 40, shape.commands[0].p0);
+            AssertPoint(50, 50, End(shape.commands[1]));
+            AssertPoint(40, 40, End(shape.commands[2]));
+            AssertPoint(50, 30, End(shape.commands[3]));
+            AssertPoint(60, 40, End(shape.commands[4]));
+        }
+
+        [Test]
+        public void RoundedRect() {
+            var shape = Parse("<rect x=\"10\" y=\"10\" width=\"40\" height=\"20\" rx=\"5\"/>").shapes[0];
+            AssertOps(shape, SvgPathOp.MoveTo, SvgPathOp.LineTo, SvgPathOp.CubicTo, SvgPathOp.LineTo,
+                SvgPathOp.CubicTo, SvgPathOp.LineTo, SvgPathOp.CubicTo, SvgPathOp.LineTo, SvgPathOp.CubicTo,
+                SvgPathOp.Close);
+            AssertPoint(15, 10, shape.commands[0].p0);
+            AssertPoint(50, 15, End(shape.commands[2]));
+        }
+        #endregion
+
+        #region Transforms
+        [TestCase("translate(10 20)", 11, 21)]
+        [TestCase("translate(10)", 11, 1)]
+        [TestCase("scale(2 3)", 2, 3)]
+        [TestCase("rotate(90)", -1, 1)]
+        [TestCase("rotate(90 10 10)", 19, 1)]
+        [TestCase("matrix(1 0 0 1 5 6)", 6, 7)]
+        [TestCase("skewX(45)", 2, 1)]
+        [TestCase("translate(10, 0) scale(2)", 12, 2)]
+        [TestCase("scale(2) translate(10, 0)", 22, 2)]
+        public void Transform(string transform, float x, float y) {
+            var shape = Path("M1 1 L2 2", $"transform=\"{transform}\"");
+            AssertPoint(x, y, shape.commands[0].p0);
+        }
+
+        [Test]
+        public void GroupTransformsCompose() {
+            var document = Parse(
+                "<g transform=\"translate(10 0)\"><g transform=\"scale(2)\"><path d=\"M1 1 L2 2\"/></g></g>");
+            AssertPoint(12, 2, document.shapes[0].commands[0].p0);
+        }
+
+        [Test]
+        public void StrokeWidthIsScaled() {
+            var shape = Path("M0 0 L10 0", "stroke=\"red\" stroke-width=\"2\" transform=\"scale(3)\"");
+            Assert.AreEqual(6, shape.strokeWidth, Delta);
+        }
+        #endregion
+
+        #region Style
+        [Test]
+        public void DefaultFillIsBlack() {
+            var shape = Path("M0 0 L10 0 L10 10 Z");
+            Assert.AreEqual("black", shape.fill);
+            Assert.IsNull(shape.stroke);
+        }
+
+        [Test]
+        public void StylesAreInherited() {
+            var document = Parse("<g fill=\"red\" stroke=\"blue\" opacity=\"0.5\"><path d=\"M0 0 L1 1\" " +
+                                 "fill-opacity=\"0.5\"/></g>");
+            var shape = document.shapes[0];
+            Assert.AreEqual("red", shape.fill);
+            Assert.AreEqual("blue", shape.stroke);
+            Assert.AreEqual(0.25f, shape.fillOpacity, Delta);
+            Assert.AreEqual(0.5f, shape.strokeOpacity, Delta);
+        }
+
+        [Test]
+        public void InlineStyleWinsOverAttributes() {
+            var shape = Path("M0 0 L1 1", "fill=\"red\" style=\"fill: blue; stroke-width: 3\" stroke=\"red\"");
+            Assert.AreEqual("blue", shape.fill);
+            Assert.AreEqual(3, shape.strokeWidth, Delta);
+        }
+
+        [Test]
+        public void CurrentColorIsKeptForTheLoader() {
+            var document = Parse("<path d=\"M0 0 L1 1\" fill=\"none\" stroke=\"CurrentColor\"/>");
+            Assert.AreEqual(SvgParser.CurrentColor, document.shapes[0].stroke);
+            Assert.IsTrue(document.usesCurrentColor);
+            Assert.IsFalse(Parse("<path d=\"M0 0 L1 1\"/>").usesCurrentColor);
+        }
+
+        [Test]
+        public void UnsupportedPaintsDrawNothing() {
+            var document = Parse(
+                "<path d=\"M0 0 L1 1\" fill=\"url(#gradient)\"/><path d=\"M0 0 L1 1\" fill=\"none\"/>");
+            Assert.AreEqual(0, document.shapes.Count);
+        }
+
+        [Test]
+        public void HiddenAndSkippedElements() {
+            var document = Parse(
+                "<defs><path d=\"M0 0 L1 1\"/></defs>" +
+                "<g display=\"none\"><path d=\"M0 0 L1 1\" display=\"inline\"/></g>" +
+                "<g visibility=\"hidden\"><path d=\"M0 0 L1 1\"/><path d=\"M0 0 L2 2\" visibility=\"visible\"/></g>" +
+                "<path d=\"M0 0 L3 3\"/>");
+            Assert.AreEqual(2, document.shapes.Count);
+            AssertPoint(2, 2, document.shapes[0].commands[1].p0);
+            AssertPoint(3, 3, document.shapes[1].commands[1].p0);
+        }
+
+        [Test]
+        public void LinesAreNeverFilled() {
+            var document = Parse("<line x1=\"0\" y1=\"0\" x2=\"10\" y2=\"10\" fill=\"red\" stroke=\"blue\"/>");
+            Assert.IsNull(document.shapes[0].fill);
+            Assert.AreEqual("blue", document.shapes[0].stroke);
+        }
+        #endregion
+    }
+}